@@ -0,0 +1,367 @@
+/*	Analyzer.cpp
+*
+*	ByteSyzed Static Analyzer Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Analyzer.h"
+#include <algorithm>
+#include <string.h>
+
+/* Decodes the instruction at an address, wrapping around the end of memory like the engines */
+template <int AddrBits>
+void AnalyzerT<AddrBits>::decode(Word address, typename Machine::Decoded & in) const {
+	unsigned char bytes[Machine::maxLength];
+	for (int index = 0; index < Machine::maxLength; ++index)
+		bytes[index] = mem[(Word)(address + index)];
+	Machine::decodeBytes(bytes, in);
+}
+
+/* Where control can go after an instruction, fall through first. A write to regs[0xF] is followed when its value is fixed by the instruction, the way the block engine folds it */
+template <int AddrBits>
+int AnalyzerT<AddrBits>::successors(Word address, const typename Machine::Decoded & in, Word next[2], bool & indirect) const {
+	const Word after = address + in.length;
+	const int fields = Machine::registerFields(in.opcode);
+	const bool writesPC = ((fields & Machine::writesA) && in.a == 0xF) || ((fields & Machine::writesB) && in.b == 0xF);
+	indirect = false;
+
+	if (Machine::opcodeLength[in.opcode] == 0) return 0; /* Invalid, the engines stop here */
+	switch (in.opcode) {
+		case 0x70: /* "jmp adr" */
+			next[0] = in.imm1;
+			return 1;
+		case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: /* Conditional jumps */
+		case 0xC2: /* "call adr", returns to after */
+			next[0] = after, next[1] = in.imm1;
+			return 2;
+		case 0x77: case 0x78: /* Skips */
+			next[0] = after, next[1] = address + in.b + 2;
+			return 2;
+		case 0xC3: /* "ret" */
+			indirect = true;
+			return 0;
+		case 0xEE: /* "exit" */
+			return 0;
+		case 0xE2: /* "printstr", continues after the 0 that ends its text */
+			for (int index = 1; index < n_mem; ++index) {
+				if (mem[(Word)(address + index)] == 0) {
+					next[0] = address + index + 1;
+					return 1;
+				}
+			}
+			return 0;
+	}
+	if (!writesPC) {
+		next[0] = after;
+		return 1;
+	}
+
+	switch (in.opcode) {
+		case 0x0F: next[0] = in.imm1; return 1; /* "movF val" jumps to val */
+		case 0x14: next[0] = in.imm1 + in.length; return 1; /* "mov AB val" */
+		case 0x15: case 0x17: next[0] = address + in.b + in.length; return 1; /* "inc AB", "pco AB" */
+		case 0x16: case 0x18: next[0] = address - in.b + in.length; return 1; /* "dec AB", "pco AB" */
+		case 0xA4: next[0] = in.b * in.imm1 + in.length; return 1; /* "lea AB val" */
+		case 0xA5: next[0] = in.b + in.imm1 + in.length; return 1; /* "lea AB val" */
+		case 0xA6: next[0] = in.b * in.imm1 + in.imm2 + in.length; return 1; /* "lea AB val1 val2" */
+	}
+	indirect = true; /* Depends on registers or memory */
+	return 0;
+}
+
+template <int AddrBits>
+void AnalyzerT<AddrBits>::addFinding(Problem problem, Word address) {
+	Finding finding = {problem, address};
+	findings.push_back(finding);
+}
+
+/* Follows every static successor from the entry point, marking each instruction's bytes */
+template <int AddrBits>
+void AnalyzerT<AddrBits>::explore(void) {
+	std::vector<Word> pending(1, entry);
+	std::vector<Word> stores; /* Instructions storing to a fixed address, checked once all code is known */
+
+	while (!pending.empty()) {
+		Word address = pending.back();
+		pending.pop_back();
+		if (role[address] == opcodeByte && owner[address] == address) continue; /* Seen */
+		if (role[address] != unreached) { /* Lands inside another instruction or a string */
+			addFinding(overlapping, address);
+			continue;
+		}
+
+		typename Machine::Decoded in;
+		decode(address, in);
+		role[address] = opcodeByte, owner[address] = address;
+		for (int index = 1; index < in.length; ++index) {
+			Word byte = address + index;
+			if (role[byte] != unreached) {
+				addFinding(overlapping, address);
+				continue;
+			}
+			role[byte] = operandByte, owner[byte] = address;
+		}
+
+		Word next[2];
+		bool indirect;
+		int count = successors(address, in, next, indirect);
+		if (Machine::opcodeLength[in.opcode] == 0) addFinding(invalidOpcode, address);
+		if (indirect && in.opcode != 0xC3) addFinding(indirectJump, address);
+		if (in.opcode == 0xA2 || in.opcode == 0xAA) stores.push_back(address);
+		if ((in.opcode == 0xC2 || in.opcode == 0xE3) && !called[in.imm1]) {
+			called[in.imm1] = 1;
+			Function function = {in.imm1, unbounded};
+			functions.push_back(function);
+		}
+		if (in.opcode == 0xE3) pending.push_back(in.imm1); /* "spawn adr", another core runs it on its own stack */
+		if (in.opcode == 0xE2 && count == 1) { /* Its text is data */
+			for (Word byte = address + 1; byte != next[0]; ++byte) {
+				if (role[byte] != unreached && role[byte] != stringByte) addFinding(overlapping, address);
+				else role[byte] = stringByte;
+			}
+		}
+
+		for (int index = 0; index < count; ++index) {
+			if (count > 1 || next[index] != (Word)(address + in.length)) leader[next[index]] = 1; /* Not just the next instruction */
+			pending.push_back(next[index]);
+		}
+	}
+
+	for (int index = 0; index < (int) stores.size(); ++index) {
+		typename Machine::Decoded in;
+		decode(stores[index], in);
+		if (role[in.imm1] == opcodeByte || role[in.imm1] == operandByte) addFinding(writesCode, stores[index]);
+	}
+}
+
+/* Cuts the reachable instructions into blocks at every leader, and after every instruction that changes the flow like the block engine ends its blocks */
+template <int AddrBits>
+void AnalyzerT<AddrBits>::buildBlocks(void) {
+	leader[entry] = 1;
+	for (int index = 0; index < (int) functions.size(); ++index)
+		leader[functions[index].entry] = 1;
+
+	for (int start = 0; start < n_mem; ++start) {
+		if (!leader[start] || role[start] != opcodeByte || owner[start] != start) continue;
+
+		Block block = {(Word) start, 0, 0, std::vector<Word>(), false};
+		Word address = start;
+		for (;;) {
+			typename Machine::Decoded in;
+			decode(address, in);
+			block.length += in.length;
+			++block.instructions;
+
+			Word next[2];
+			bool indirect;
+			int count = successors(address, in, next, indirect);
+			if (count == 2 && next[0] == next[1]) count = 1; /* A branch to the next instruction */
+			bool ends = indirect || count != 1 || next[0] != (Word)(address + in.length) || in.opcode == 0xE2;
+			Word after = address + in.length;
+			if (!ends && (leader[after] || role[after] != opcodeByte || owner[after] != after || block.length >= n_mem)) ends = true;
+			if (ends) {
+				block.successors.assign(next, next + count);
+				block.indirect = indirect;
+				break;
+			}
+			address = after;
+		}
+		blocks.push_back(block);
+	}
+}
+
+/* Most stack slots a function uses from its entry, counting what its callees use and the return addresses pushed for them. Every path has to reach an address with the same depth */
+template <int AddrBits>
+int AnalyzerT<AddrBits>::boundFunction(Word address) {
+	enum {notAsked=-2, bounding=-3};
+	if (bound[address] == bounding) {
+		addFinding(recursion, address);
+		return unbounded;
+	}
+	if (bound[address] != notAsked) return bound[address];
+	bound[address] = bounding;
+
+	std::vector<int> depthAt(n_mem, -1);
+	std::vector<Word> pending(1, address);
+	depthAt[address] = 0;
+	int most = 0;
+	bool bounded = true;
+
+	while (!pending.empty() && bounded) {
+		Word at = pending.back();
+		pending.pop_back();
+		if (role[at] != opcodeByte || owner[at] != at) continue; /* Already reported by explore */
+
+		typename Machine::Decoded in;
+		decode(at, in);
+		const int fields = Machine::registerFields(in.opcode);
+		const int depth = depthAt[at];
+		int after = depth;
+
+		if (((fields & Machine::writesA) && in.a == 0xE) || ((fields & Machine::writesB) && in.b == 0xE)) {
+			addFinding(stackPointerWritten, at);
+			bounded = false;
+			break;
+		}
+		if ((in.opcode & 0xF0) == 0x80) {
+			after = depth + 1;
+		} else if ((in.opcode & 0xF0) == 0x90 || (in.opcode == 0xC3 && depth == 0 && address == entry)) {
+			if (depth == 0) { /* Its own return address, or the bottom of the stack */
+				addFinding(stackUnderflow, at);
+				if (address == entry) continue; /* A fault, the stack gets no deeper on this path */
+				bounded = false;
+				break;
+			}
+			after = depth - 1;
+		} else if (in.opcode == 0xC2) {
+			int callee = boundFunction(in.imm1);
+			if (callee == unbounded) {
+				bounded = false;
+				break;
+			}
+			most = std::max(most, depth + 1 + callee);
+		} else if (in.opcode == 0xC3 && depth != 0) {
+			addFinding(unbalancedReturn, at);
+			bounded = false;
+			break;
+		}
+		most = std::max(most, after);
+
+		Word next[2];
+		bool indirect;
+		int count = successors(at, in, next, indirect);
+		if (in.opcode == 0xC2) count = 1; /* The callee was bounded above, this function goes on at the return address */
+		for (int index = 0; index < count; ++index) {
+			if (depthAt[next[index]] == -1) {
+				depthAt[next[index]] = after;
+				pending.push_back(next[index]);
+			} else if (depthAt[next[index]] != after) {
+				addFinding(unbalancedStack, next[index]);
+				bounded = false;
+			}
+		}
+	}
+
+	bound[address] = bounded? most : unbounded;
+	return bound[address];
+}
+
+/* Analyzes memory, the program loaded count bytes from first */
+template <int AddrBits>
+void AnalyzerT<AddrBits>::analyze(const unsigned char * memory, Word entryPoint, Word first, int count) {
+	mem = memory;
+	entry = entryPoint, programFirst = first, programCount = count;
+	memset(role, unreached, sizeof(role));
+	memset(owner, 0, sizeof(owner));
+	blocks.clear(), functions.clear(), findings.clear();
+	leader.assign(n_mem, 0);
+	called.assign(n_mem, 0);
+	bound.assign(n_mem, -2);
+
+	Function start = {entry, unbounded};
+	functions.push_back(start);
+	called[entry] = 1;
+	explore();
+	buildBlocks();
+
+	for (int index = 0; index < (int) functions.size(); ++index)
+		functions[index].maxDepth = boundFunction(functions[index].entry);
+	std::sort(functions.begin() + 1, functions.end(), [](const Function & a, const Function & b) { return a.entry < b.entry; });
+	maxDepth = functions[0].maxDepth;
+
+	/* The bottom slot holds progStart, every slot the program uses is below it */
+	int highest = (count > 0)? first + count - 1 : -1;
+	for (int address = n_mem - 1; address > highest; --address) {
+		if (role[address] != unreached) highest = address;
+	}
+	long lowest = (long) n_mem - (long) Machine::addrBytes * (1 + (long) std::max(maxDepth, 0));
+	stackLowest = (Word) std::max(lowest, 0L);
+	stackSafe = maxDepth != unbounded && lowest > highest;
+	if (maxDepth != unbounded && !stackSafe) addFinding(stackReachesCode, stackLowest);
+
+	std::stable_sort(findings.begin(), findings.end(), [](const Finding & a, const Finding & b) { return a.address < b.address; });
+	findings.erase(std::unique(findings.begin(), findings.end(), [](const Finding & a, const Finding & b) {
+		return a.address == b.address && a.problem == b.problem; }), findings.end());
+}
+
+/* Block starting at an address, NULL if none does */
+template <int AddrBits>
+const typename AnalyzerT<AddrBits>::Block * AnalyzerT<AddrBits>::blockAt(Word address) const {
+	auto found = std::lower_bound(blocks.begin(), blocks.end(), address, [](const Block & block, Word address) { return block.first < address; });
+	return (found != blocks.end() && found->first == address)? &*found : NULL;
+}
+
+/* Translates every block ahead of the run, so the block engine never stops to translate. Blocks it finds longer than the engine's are cut by translate as usual */
+template <int AddrBits>
+void AnalyzerT<AddrBits>::pretranslate(Machine & cpu) const {
+	for (int index = 0; index < (int) blocks.size(); ++index) {
+		if (cpu.blocks[blocks[index].first].count == 0) cpu.translate(blocks[index].first);
+	}
+}
+
+/* Prints blocks, findings, unreached ranges and the stack bound */
+template <int AddrBits>
+void AnalyzerT<AddrBits>::report(EmulatorOutput & out) const {
+	static const char * problems[] = {
+		"Invalid opcode",
+		"Decoded as part of two different instructions (check instruction lengths)",
+		"Jumps to an address only known at run time, not followed",
+		"Writes the stack pointer, the stack can't be bounded",
+		"Pops below where it was entered, or below the bottom of the stack",
+		"Reached with different stack depths",
+		"Returns with values it pushed still on the stack",
+		"Calls itself, the stack can't be bounded",
+		"Stores into code",
+		"The stack can reach the program"
+	};
+	int instructions = 0;
+	for (int index = 0; index < (int) blocks.size(); ++index) instructions += blocks[index].instructions;
+
+	out.print("Analysis: %i instructions in %i blocks, %i functions, entry 0x%02X\n", instructions, (int) blocks.size(), (int) functions.size(), entry);
+
+	out.print("\nBlock   Bytes  Instructions  Successors\n");
+	for (int index = 0; index < (int) blocks.size(); ++index) {
+		const Block & block = blocks[index];
+		out.print(" 0x%02X %7i %13i ", block.first, block.length, block.instructions);
+		for (int next = 0; next < (int) block.successors.size(); ++next)
+			out.print(" 0x%02X", block.successors[next]);
+		if (block.indirect) out.print(" (run time)");
+		if (block.successors.empty() && !block.indirect) out.print(" (stops)");
+		out.print("\n");
+	}
+
+	out.print("\nFunction  Max stack\n");
+	for (int index = 0; index < (int) functions.size(); ++index) {
+		if (functions[index].maxDepth == unbounded) out.print("    0x%02X  unbounded\n", functions[index].entry);
+		else out.print("    0x%02X %10i\n", functions[index].entry, functions[index].maxDepth);
+	}
+
+	/* Only the loaded bytes count, the rest of memory is expected to be unreached */
+	bool header = false;
+	for (int address = programFirst; address < programFirst + programCount && address < n_mem; ) {
+		if (role[address] != unreached) {
+			++address;
+			continue;
+		}
+		int end = address;
+		while (end < programFirst + programCount && end < n_mem && role[end] == unreached) ++end;
+		if (!header) out.print("\nUnreached (data or dead code)\n"), header = true;
+		out.print(" 0x%02X to 0x%02X, %i bytes\n", address, end - 1, end - address);
+		address = end;
+	}
+
+	if (!findings.empty()) out.print("\nFindings\n");
+	for (int index = 0; index < (int) findings.size(); ++index)
+		out.print(" 0x%02X  %s\n", findings[index].address, problems[findings[index].problem]);
+
+	if (maxDepth == unbounded)
+		out.print("\nStack: no static bound\n");
+	else
+		out.print("\nStack: at most %i slots below the bottom one, lowest byte 0x%02X, %s\n", maxDepth, stackLowest,
+			stackSafe? "never reaches the program" : "can overwrite the program");
+}
+
+template class AnalyzerT<8>;
+template class AnalyzerT<16>;
\ No newline at end of file
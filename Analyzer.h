@@ -0,0 +1,108 @@
+/*	Analyzer.h
+*
+*	ByteSyzed Static Analyzer Header.
+*
+*	Decodes a loaded program without running it, with the same instruction
+*	lengths as the engines, from its entry point through every jump, skip,
+*	call, spawn and return address. It builds the control flow graph of basic
+*	blocks, finds bytes that decode as two different instructions, invalid
+*	opcodes and code that is never reached, and bounds how deep the stack
+*	gets so it can tell whether pushes could ever overwrite the program.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include "ByteSyzed.h"
+#include <vector>
+
+template <int AddrBits>
+class AnalyzerT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+	enum {n_mem=Machine::n_mem, unbounded=-1};
+
+	/* What each byte of memory turned out to be */
+	enum Role {
+		unreached, /* Never decoded: data, or dead code */
+		opcodeByte, /* First byte of a reachable instruction */
+		operandByte, /* Later byte of one */
+		stringByte /* Text (and its 0) printed by printstr */
+	};
+
+	/* A straight run of instructions, entered only at its first one */
+	struct Block {
+		Word first; /* Address of its first instruction */
+		int length; /* Bytes, up to and including its last instruction */
+		int instructions;
+		std::vector<Word> successors; /* Where control can go next: fall through first, then the taken branch or call target */
+		bool indirect; /* Also continues at an address only known at run time (ret, popF or another write to regs[0xF]) */
+	};
+
+	/* Something that could go wrong at run time */
+	enum Problem {
+		invalidOpcode, /* Reachable byte that is no instruction, the engines fault on it */
+		overlapping, /* Byte decoded as part of two different instructions, usually a wrong instruction length */
+		indirectJump, /* regs[0xF] written with a value only known at run time, what follows is not analyzed */
+		stackPointerWritten, /* regs[0xE] written other than by push, pop, call and ret, so the stack can't be bounded */
+		stackUnderflow, /* Pop or ret below where the code was entered, or below the bottom of the stack */
+		unbalancedStack, /* Two paths reach an address with different stack depths, e.g. a push in a loop */
+		unbalancedReturn, /* ret with values it pushed still on the stack, so it returns to one of them */
+		recursion, /* A function calls itself, directly or not, so the stack has no static bound */
+		writesCode, /* Stores to a fixed address inside reachable code */
+		stackReachesCode /* The deepest stack overlaps the program */
+	};
+	struct Finding {
+		Problem problem;
+		Word address; /* Instruction it is about, or the lowest stack byte for stackReachesCode */
+	};
+
+	/* A call target (or the entry point) with its stack use */
+	struct Function {
+		Word entry;
+		int maxDepth; /* Most stack slots it uses, counting its callees and return addresses, unbounded if it can't be told */
+	};
+
+	unsigned char role[n_mem]; /* Role of every byte */
+	Word owner[n_mem]; /* For opcode and operand bytes, the instruction they belong to */
+	std::vector<Block> blocks; /* By address */
+	std::vector<Function> functions; /* The entry point first */
+	std::vector<Finding> findings; /* By address */
+	Word entry, programFirst; /* Where it starts, and the first byte it was loaded to */
+	int programCount; /* Bytes it was loaded as */
+	int maxDepth; /* Stack slots below the bottom one (which holds progStart) the program uses, unbounded if it can't be told */
+	Word stackLowest; /* Lowest byte the stack reaches, if bounded */
+	bool stackSafe; /* The stack provably never reaches a byte of the program */
+
+	void analyze(const unsigned char * mem, Word entry, Word first, int count); /* Analyzes memory, the program loaded count bytes from first */
+	void analyze(const Machine & cpu) { analyze(cpu.mem, cpu.progStart, cpu.loadedFirst, cpu.loadedCount); } /* A program loadFromFile just loaded, from where it loaded */
+	void report(EmulatorOutput & out) const; /* Prints blocks, findings, unreached ranges and the stack bound */
+	void pretranslate(Machine & cpu) const; /* Translates every block for the block engine ahead of the run. Call after boot, which empties the caches */
+	const Block * blockAt(Word address) const; /* Block starting at an address, NULL if none does */
+
+private:
+	const unsigned char * mem;
+	std::vector<char> leader; /* n_mem entries, set where a block starts */
+	std::vector<char> called; /* n_mem entries, set where a function starts */
+	std::vector<int> bound; /* n_mem entries, maxDepth of the function entered there, -2 until asked, -3 while it is being bounded */
+
+	void decode(Word address, typename Machine::Decoded & in) const;
+	int successors(Word address, const typename Machine::Decoded & in, Word next[2], bool & indirect) const; /* Static successors, fall through first. Returns how many */
+	void addFinding(Problem problem, Word address);
+	void explore(void); /* Marks every reachable instruction and its bytes */
+	void buildBlocks(void);
+	int boundFunction(Word address); /* maxDepth of a function, bounding its callees first */
+};
+
+typedef AnalyzerT<8> Analyzer;
+typedef AnalyzerT<16> Analyzer16; /* About 200 KB, allocate it with new */
+
+/* Built once in Analyzer.cpp */
+extern template class AnalyzerT<8>;
+extern template class AnalyzerT<16>;
+
+#endif
\ No newline at end of file
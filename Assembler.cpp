@@ -0,0 +1,665 @@
+/*	Assembler.cpp
+*
+*	ByteSyzed Assembler Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Assembler.h"
+#include <algorithm>
+#include <ctype.h>
+#include <memory>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+*	Forms of every mnemonic, by the kinds of their operands:
+*	r register, i [register], m [expression], e expression, s "string".
+*	A mnemonic with several forms takes the one its operands match.
+*/
+struct AssemblerForm {
+	const char * mnemonic;
+	const char * operands;
+	unsigned char opcode;
+};
+
+static const AssemblerForm assemblerForms[] = {
+	{"mov", "re", 0x00}, /* movA val */
+	{"mov", "rr", 0x10}, {"mov", "ri", 0x11}, {"mov", "ir", 0x12}, {"mov", "ii", 0x13},
+	{"mov", "rre", 0x14},
+	{"inc", "re", 0x15}, {"dec", "re", 0x16},
+	{"pco", "re", 0x17}, /* 0x18 when the offset is negative */
+	{"cas", "ir", 0x19}, {"xadd", "ir", 0x1A},
+	{"and", "rr", 0x20}, {"or", "rr", 0x30}, {"xor", "rr", 0x40},
+	{"shl", "rr", 0x50}, {"shr", "rr", 0x51}, {"rol", "rr", 0x52}, {"ror", "rr", 0x53},
+	{"jmp", "e", 0x70},
+	{"jl", "rre", 0x71}, {"jle", "rre", 0x72}, {"je", "rre", 0x73}, {"jge", "rre", 0x74}, {"jg", "rre", 0x75}, {"jne", "rre", 0x76},
+	{"skipifnz", "re", 0x77}, {"skipifz", "re", 0x78},
+	{"push", "r", 0x80}, {"pop", "r", 0x90},
+	{"add", "rr", 0xA0}, {"add", "rrm", 0xA1}, {"add", "mrr", 0xA2}, {"add", "rre", 0xA3},
+	{"lea", "rm", 0xA4}, /* 0xA4, 0xA5 or 0xA6 by what is in the brackets */
+	{"sub", "rr", 0xA7}, {"sub", "rrm", 0xA8}, {"sub", "rmr", 0xA9}, {"sub", "mrr", 0xAA}, {"sub", "rre", 0xAB}, {"sub", "rer", 0xAC},
+	{"call", "e", 0xC2}, {"ret", "", 0xC3},
+	{"nop", "", 0xD0},
+	{"putchar", "", 0xE0}, {"getchar", "", 0xE1}, {"printstr", "s", 0xE2}, {"spawn", "e", 0xE3}, {"join", "", 0xE4},
+	{"dumpregs", "e", 0xE8}, /* 0xE9 for "dumpregs 1" */
+	{"dumpmem", "", 0xEA}, {"dumpmem", "rr", 0xEB}, /* Always r1, r2 */
+	{"dumpregs", "r", 0xEC}, /* Always r1 */
+	{"dump", "e", 0xED}, {"exit", "", 0xEE}, {"filedump", "", 0xEF}
+};
+
+/* Register an operand names, -1 if it names none */
+static int assemblerRegister(const std::string & operand) {
+	if (operand.size() == 2 && tolower((unsigned char) operand[0]) == 'r' && isxdigit((unsigned char) operand[1]))
+		return (int) strtol(operand.c_str() + 1, NULL, 16);
+	if (operand.size() == 2 && tolower((unsigned char) operand[0]) == 'p' && tolower((unsigned char) operand[1]) == 'c') return 0xF;
+	if (operand.size() == 2 && tolower((unsigned char) operand[0]) == 's' && tolower((unsigned char) operand[1]) == 'p') return 0xE;
+	return -1;
+}
+
+/* Kind of an operand, as in assemblerForms */
+static char assemblerKind(const std::string & operand) {
+	if (assemblerRegister(operand) >= 0) return 'r';
+	if (operand[0] == '"') return 's';
+	if (operand[0] == '[' && operand[operand.size() - 1] == ']') {
+		std::string inside = operand.substr(1, operand.size() - 2);
+		size_t from = inside.find_first_not_of(" \t"), to = inside.find_last_not_of(" \t");
+		return (from != std::string::npos && assemblerRegister(inside.substr(from, to - from + 1)) >= 0)? 'i' : 'm';
+	}
+	return 'e';
+}
+
+/* Register inside the brackets of an "i" operand */
+static int assemblerPointer(const std::string & operand) {
+	std::string inside = operand.substr(1, operand.size() - 2);
+	size_t from = inside.find_first_not_of(" \t"), to = inside.find_last_not_of(" \t");
+	return assemblerRegister(inside.substr(from, to - from + 1));
+}
+
+static bool assemblerSymbolChar(char c) {
+	return isalnum((unsigned char) c) || c == '_' || c == '.';
+}
+
+static void assemblerSkip(const char *& at) {
+	while (*at == ' ' || *at == '\t') ++at;
+}
+
+template <int AddrBits>
+void AssemblerT<AddrBits>::error(const char * format, ...) {
+	if (pass == 0) return; /* Everything is checked again, with every label known, in pass 1 */
+	char buffer[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	messages->print("Line %i: %s\n", line, buffer);
+	++errors;
+}
+
+/* Assembles source text, twice: pass 0 to find the address of every label, pass 1 to emit */
+template <int AddrBits>
+bool AssemblerT<AddrBits>::assemble(const char * source, EmulatorOutput * messages) {
+	this->messages = messages;
+	text = source;
+	symbols.clear();
+	errors = 0;
+
+	for (pass = 0; pass < 2; ++pass) {
+		program.clear();
+		listing.clear();
+		first = entry = 0;
+		placed = entrySet = false;
+		line = 0;
+		for (const char * begin = text.c_str(); *begin != '\0'; ) {
+			const char * end = strchr(begin, '\n');
+			if (end == NULL) end = begin + strlen(begin);
+			++line;
+			assembleLine(begin, (end > begin && end[-1] == '\r')? end - 1 : end);
+			begin = (*end == '\0')? end : end + 1;
+		}
+		if (!entrySet) entry = first;
+	}
+
+	if ((long) first + (long) program.size() > Machine::n_mem) {
+		messages->print("Error. The program ends at 0x%02lX, past the end of memory.\n", (long) first + (long) program.size());
+		++errors;
+	}
+	if (errors > 0) messages->print("%i error%s.\n", errors, (errors == 1)? "" : "s");
+	return errors == 0;
+}
+
+template <int AddrBits>
+bool AssemblerT<AddrBits>::assembleFile(const char * fileName, EmulatorOutput * messages) {
+	FILE * file = fopen(fileName, "rb");
+	if (file == NULL) {
+		messages->print("Can't open %s.\n", fileName);
+		errors = 1;
+		return false;
+	}
+	std::string source;
+	char buffer[4096];
+	for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0; )
+		source.append(buffer, count);
+	fclose(file);
+	return assemble(source.c_str(), messages);
+}
+
+/* Labels, then a constant, a directive or an instruction */
+template <int AddrBits>
+void AssemblerT<AddrBits>::assembleLine(const char * begin, const char * end) {
+	/* Drop the comment, minding strings and characters */
+	char quote = 0;
+	for (const char * at = begin; at < end; ++at) {
+		if (quote != 0) {
+			if (*at == '\\' && at + 1 < end) ++at;
+			else if (*at == quote) quote = 0;
+		} else if (*at == '"' || *at == '\'') {
+			quote = *at;
+		} else if (*at == ';' || (*at == '/' && at + 1 < end && at[1] == '/')) {
+			end = at;
+			break;
+		}
+	}
+	std::string statement(begin, end);
+	const char * at = statement.c_str();
+	here = (long) first + (long) program.size();
+	int offset = (int) program.size();
+
+	for (;;) {
+		assemblerSkip(at);
+		const char * name = at;
+		while (assemblerSymbolChar(*at)) ++at;
+		std::string word(name, at);
+		assemblerSkip(at);
+
+		if (!word.empty() && *at == ':' && word[0] != '.' && !isdigit((unsigned char) word[0])) { /* Label */
+			++at;
+			if (assemblerRegister(word) >= 0) error("%s is a register, not a label.", word.c_str());
+			Symbol & symbol = symbols[word];
+			if (pass == 0 && symbol.line == 0) symbol.value = here, symbol.line = line;
+			else if (pass == 1 && symbol.line != line) error("%s is already defined on line %i.", word.c_str(), symbol.line);
+			continue;
+		}
+
+		if (word.empty() && *at == '\0') return; /* Blank */
+
+		operands.clear();
+		if (*at == '=' && at[1] != '=') { /* Constant */
+			operands.push_back(word);
+			operands.push_back(at + 1);
+			word = ".equ";
+		} else {
+			/* Operands, split at commas outside of strings, brackets and parentheses */
+			int depth = 0;
+			quote = 0;
+			const char * start = at;
+			for (;; ++at) {
+				if (quote != 0) {
+					if (*at == '\\' && at[1] != '\0') ++at;
+					else if (*at == quote) quote = 0;
+					else if (*at == '\0') break;
+					continue;
+				}
+				if (*at == '"' || *at == '\'') quote = *at;
+				else if (*at == '(' || *at == '[') ++depth;
+				else if (*at == ')' || *at == ']') --depth;
+				else if ((*at == ',' && depth == 0) || *at == '\0') {
+					std::string operand(start, at);
+					size_t from = operand.find_first_not_of(" \t"), to = operand.find_last_not_of(" \t");
+					operand = (from == std::string::npos)? "" : operand.substr(from, to - from + 1);
+					if (!operand.empty() || *at == ',' || !operands.empty()) operands.push_back(operand);
+					if (*at == '\0') break;
+					start = at + 1;
+				}
+			}
+			if (quote != 0) {
+				error("A string or character is not closed.");
+				return;
+			}
+			for (size_t index = 0; index < operands.size(); ++index) {
+				if (operands[index].empty()) {
+					error("Operand %i is missing.", (int) index + 1);
+					return;
+				}
+			}
+		}
+
+		if (word.empty()) {
+			error("Expected a label, directive or instruction.");
+		} else if (word[0] == '.') {
+			for (size_t index = 0; index < word.size(); ++index) word[index] = (char) tolower((unsigned char) word[index]);
+			if (word == ".byte" || word == ".ascii") {
+				if (operands.empty()) error("%s needs something to put.", word.c_str());
+				for (size_t index = 0; index < operands.size(); ++index) {
+					if (operands[index][0] == '"') emitString(operands[index]);
+					else if (word == ".ascii") error(".ascii takes strings, use .byte for numbers.");
+					else emit(evaluate(operands[index]), "Byte");
+				}
+			} else if (word == ".equ") {
+				if (operands.size() != 2 || operands[0].empty() || !assemblerSymbolChar(operands[0][0]) || isdigit((unsigned char) operands[0][0])) {
+					error("Expected \"name = expression\".");
+				} else {
+					forward = false;
+					long value = evaluate(operands[1]);
+					Symbol & symbol = symbols[operands[0]];
+					if (forward) error("%s is defined from a symbol that comes later.", operands[0].c_str());
+					if (assemblerRegister(operands[0]) >= 0) error("%s is a register, not a constant.", operands[0].c_str());
+					if (pass == 0 && symbol.line == 0) symbol.value = value, symbol.line = line;
+					else if (pass == 1 && symbol.line != line) error("%s is already defined on line %i.", operands[0].c_str(), symbol.line);
+				}
+			} else if (word == ".org") {
+				forward = false;
+				long value = (operands.size() == 1)? evaluate(operands[0]) : 0;
+				if (operands.size() != 1) error(".org takes one address.");
+				else if (forward) error(".org can't use a symbol that comes later.");
+				else if (value < 0 || value >= Machine::n_mem) error("Address %li is outside memory.", value);
+				else if (!placed) first = (Word) value, here = value;
+				else if (value < here) error(".org can't go back, from 0x%02lX to 0x%02lX.", here, value);
+				else program.resize(program.size() + (value - here), 0);
+			} else if (word == ".entry") {
+				long value = (operands.size() == 1)? evaluate(operands[0]) : 0;
+				if (operands.size() != 1) error(".entry takes one address.");
+				else if (value < 0 || value >= Machine::n_mem) error("Address %li is outside memory.", value);
+				else entry = (Word) value, entrySet = true;
+			} else {
+				error("Unknown directive %s.", word.c_str());
+			}
+		} else {
+			assembleInstruction(word, operands);
+		}
+		break;
+	}
+
+	if (pass == 1 && (int) program.size() > offset) {
+		Listing bytes = {offset, (int) program.size() - offset, (int)(begin - text.c_str()), (int)(end - text.c_str())};
+		listing.push_back(bytes);
+	}
+}
+
+/* Picks the form its operands match and emits it */
+template <int AddrBits>
+void AssemblerT<AddrBits>::assembleInstruction(const std::string & name, std::vector<std::string> & operands) {
+	std::string mnemonic(name), kinds;
+	for (size_t index = 0; index < mnemonic.size(); ++index) mnemonic[index] = (char) tolower((unsigned char) mnemonic[index]);
+	for (size_t index = 0; index < operands.size(); ++index) kinds += assemblerKind(operands[index]);
+
+	const AssemblerForm * form = NULL;
+	bool known = false;
+	for (size_t index = 0; index < sizeof(assemblerForms) / sizeof(assemblerForms[0]) && form == NULL; ++index) {
+		if (mnemonic != assemblerForms[index].mnemonic) continue;
+		known = true;
+		if (kinds == assemblerForms[index].operands) form = &assemblerForms[index];
+	}
+	if (form == NULL) {
+		if (known) error("%s takes different operands.", name.c_str());
+		else error("Unknown instruction %s.", name.c_str());
+		return;
+	}
+
+	/* Registers of the operands, in order ("[rB]" counts as rB) */
+	int reg[3] = {0, 0, 0};
+	for (size_t index = 0; index < operands.size() && index < 3; ++index) {
+		if (kinds[index] == 'r') reg[index] = assemblerRegister(operands[index]);
+		else if (kinds[index] == 'i') reg[index] = assemblerPointer(operands[index]);
+	}
+	unsigned char opcode = form->opcode;
+	long value;
+
+	switch (opcode) {
+		case 0x00: /* "movA val" */
+			program.push_back((unsigned char)(opcode | reg[0]));
+			emit(evaluate(operands[1]), "Value");
+			break;
+		case 0x15: case 0x16: case 0x77: case 0x78: /* "inc AB", "dec AB", skips */
+		case 0x17: /* "pco AB" */
+			value = evaluate(operands[1]);
+			if (opcode == 0x17 && value < 0) opcode = 0x18, value = -value;
+			if (pass == 1 && (value < 0 || value > 0xF)) error("%li does not fit in a nibble (0 to 15).", (opcode == 0x18)? -value : value);
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | (value & 0xF)));
+			break;
+		case 0x70: case 0xC2: case 0xE3: /* "jmp adr", "call adr", "spawn adr" */
+			program.push_back(opcode);
+			emitAddress(evaluate(operands[0]));
+			break;
+		case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: /* Conditional jumps */
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | reg[1]));
+			emitAddress(evaluate(operands[2]));
+			break;
+		case 0x80: case 0x90: /* "pushA", "popA" */
+			program.push_back((unsigned char)(opcode | reg[0]));
+			break;
+		case 0x14: case 0xA3: case 0xAB: /* "mov AB val", "add AB val", "sub AB val" */
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | reg[1]));
+			emit(evaluate(operands[2]), "Value");
+			break;
+		case 0xAC: /* "sub AB val", reg[A] = val - reg[B] */
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | reg[2]));
+			emit(evaluate(operands[1]), "Value");
+			break;
+		case 0xA1: case 0xA8: /* reg[A] = reg[B] op mem[adr] */
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | reg[1]));
+			emitAddress(evaluate(operands[2].substr(1, operands[2].size() - 2)));
+			break;
+		case 0xA9: /* reg[A] = mem[adr] - reg[B] */
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | reg[2]));
+			emitAddress(evaluate(operands[1].substr(1, operands[1].size() - 2)));
+			break;
+		case 0xA2: case 0xAA: /* mem[adr] = reg[A] op reg[B], the address comes first */
+			program.push_back(opcode);
+			emitAddress(evaluate(operands[0].substr(1, operands[0].size() - 2)));
+			program.push_back((unsigned char)((reg[1] << 4) | reg[2]));
+			break;
+		case 0xA4: { /* "lea AB val" [B*val], [B+val] or [B*val1+val2] */
+			std::string inside = operands[1].substr(1, operands[1].size() - 2);
+			const char * at = inside.c_str();
+			problem = NULL;
+			long scale = parseUnary(at), values[2] = {0, 0};
+			int count = 0;
+			assemblerSkip(at);
+			if (*at == '*') {
+				++at;
+				values[count++] = parseUnary(at);
+				assemblerSkip(at);
+				opcode = 0xA4;
+			}
+			if (*at == '+') {
+				++at;
+				values[count++] = parseOr(at);
+				assemblerSkip(at);
+				opcode = (count == 2)? 0xA6 : 0xA5;
+			}
+			if (count == 0 || *at != '\0' || problem != NULL) {
+				error("Expected [B*val], [B+val] or [B*val1+val2] in \"%s\".", operands[1].c_str());
+				break;
+			}
+			if (pass == 1 && (scale < 0 || scale > 0xF)) error("%li does not fit in a nibble (0 to 15).", scale);
+			program.push_back(opcode);
+			program.push_back((unsigned char)((reg[0] << 4) | (scale & 0xF)));
+			for (int index = 0; index < count; ++index) emit(values[index], "Value");
+			break;
+		}
+		case 0xE2: /* "printstr char[],0" */
+			program.push_back(opcode);
+			value = (long) program.size();
+			emitString(operands[0]);
+			if (std::find(program.begin() + value, program.end(), 0) != program.end()) error("printstr stops at the first 0, the text can't hold one.");
+			program.push_back(0x00);
+			break;
+		case 0xE8: /* "dumpregs 0" or "dumpregs 1" */
+			value = evaluate(operands[0]);
+			if (pass == 1 && value != 0 && value != 1) error("dumpregs takes 0, 1 or r1.");
+			program.push_back((unsigned char)(opcode + (value & 1)));
+			break;
+		case 0xEB: /* "dumpmem r1, r2" */
+			if (reg[0] != 0x1 || reg[1] != 0x2) error("dumpmem dumps from r1 to r2, it takes no other registers.");
+			program.push_back(opcode);
+			break;
+		case 0xEC: /* "dumpregs r1" */
+			if (reg[0] != 0x1) error("dumpregs takes 0, 1 or r1.");
+			program.push_back(opcode);
+			break;
+		case 0xED: /* "dump id" */
+			program.push_back(opcode);
+			emit(evaluate(operands[0]), "Dump id");
+			break;
+		default:
+			if (form->operands[0] == '\0') { /* No operands */
+				program.push_back(opcode);
+			} else { /* "opcode AB", registers or the registers they point to */
+				program.push_back(opcode);
+				program.push_back((unsigned char)((reg[0] << 4) | reg[1]));
+			}
+			break;
+	}
+	placed = true;
+}
+
+/* One byte, signed or not */
+template <int AddrBits>
+void AssemblerT<AddrBits>::emit(long value, const char * what) {
+	if (pass == 1 && (value < -128 || value > 0xFF)) error("%s %li does not fit in a byte.", what, value);
+	program.push_back((unsigned char) value);
+	placed = true;
+}
+
+/* An address, little endian and as wide as the machine's */
+template <int AddrBits>
+void AssemblerT<AddrBits>::emitAddress(long value) {
+	if (pass == 1 && (value < 0 || value >= Machine::n_mem)) error("Address %li is outside memory.", value);
+	for (int index = 0; index < Machine::addrBytes; ++index)
+		program.push_back((unsigned char)(value >> (8 * index)));
+	placed = true;
+}
+
+/* The characters of a "string", without a 0 */
+template <int AddrBits>
+void AssemblerT<AddrBits>::emitString(const std::string & operand) {
+	const char * at = operand.c_str() + 1;
+	long value;
+	problem = NULL;
+	while (*at != '"' && *at != '\0' && parseCharacter(at, '"', value))
+		program.push_back((unsigned char) value);
+	if (*at != '"' || at[1] != '\0') error("Can't read the string %s.", operand.c_str());
+	else if (problem != NULL) error("%s in %s.", problem, operand.c_str());
+	placed = true;
+}
+
+/* Value of an expression, 0 (and an error) if it can't be read */
+template <int AddrBits>
+long AssemblerT<AddrBits>::evaluate(const std::string & operand) {
+	const char * at = operand.c_str();
+	problem = NULL;
+	long value = parseOr(at);
+	assemblerSkip(at);
+	if (problem == NULL && *at != '\0') problem = "Unexpected text";
+	if (problem != NULL) {
+		error("%s in \"%s\".", problem, operand.c_str());
+		return 0;
+	}
+	return value;
+}
+
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseOr(const char *& at) {
+	long value = parseXor(at);
+	for (assemblerSkip(at); *at == '|'; assemblerSkip(at)) ++at, value |= parseXor(at);
+	return value;
+}
+
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseXor(const char *& at) {
+	long value = parseAnd(at);
+	for (assemblerSkip(at); *at == '^'; assemblerSkip(at)) ++at, value ^= parseAnd(at);
+	return value;
+}
+
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseAnd(const char *& at) {
+	long value = parseShift(at);
+	for (assemblerSkip(at); *at == '&'; assemblerSkip(at)) ++at, value &= parseShift(at);
+	return value;
+}
+
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseShift(const char *& at) {
+	long value = parseSum(at);
+	for (assemblerSkip(at); (at[0] == '<' && at[1] == '<') || (at[0] == '>' && at[1] == '>'); assemblerSkip(at)) {
+		bool left = (*at == '<');
+		at += 2;
+		long count = parseSum(at);
+		if (count < 0 || count > 31) count = 0, problem = (problem != NULL)? problem : "Shift out of range";
+		value = left? (value << count) : (value >> count);
+	}
+	return value;
+}
+
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseSum(const char *& at) {
+	long value = parseProduct(at);
+	for (assemblerSkip(at); *at == '+' || *at == '-'; assemblerSkip(at)) {
+		bool add = (*at++ == '+');
+		long term = parseProduct(at);
+		value = add? value + term : value - term;
+	}
+	return value;
+}
+
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseProduct(const char *& at) {
+	long value = parseUnary(at);
+	for (assemblerSkip(at); *at == '*' || *at == '/' || *at == '%'; assemblerSkip(at)) {
+		char op = *at++;
+		long factor = parseUnary(at);
+		if (op == '*') value *= factor;
+		else if (factor == 0) problem = (problem != NULL)? problem : "Division by zero";
+		else value = (op == '/')? value / factor : value % factor;
+	}
+	return value;
+}
+
+/* Numbers, characters, symbols, ".", parentheses and - + ~ in front of them */
+template <int AddrBits>
+long AssemblerT<AddrBits>::parseUnary(const char *& at) {
+	assemblerSkip(at);
+	if (*at == '-') return ++at, -parseUnary(at);
+	if (*at == '+') return ++at, parseUnary(at);
+	if (*at == '~') return ++at, ~parseUnary(at);
+	if (*at == '(') {
+		++at;
+		long value = parseOr(at);
+		assemblerSkip(at);
+		if (*at == ')') ++at;
+		else problem = (problem != NULL)? problem : "Missing )";
+		return value;
+	}
+	if (*at == '\'') {
+		long value = 0;
+		++at;
+		if (*at == '\'' || !parseCharacter(at, '\'', value) || *at != '\'') {
+			problem = (problem != NULL)? problem : "Can't read the character";
+			return 0;
+		}
+		++at;
+		return value;
+	}
+	if (isdigit((unsigned char) *at)) {
+		const char * start = at;
+		long value;
+		bool binary = (at[0] == '0' && (at[1] == 'b' || at[1] == 'B'));
+		if (binary) value = strtol(at + 2, (char **) &at, 2);
+		else value = strtol(at, (char **) &at, 0);
+		if (assemblerSymbolChar(*at) || (binary && at == start + 2)) problem = (problem != NULL)? problem : "Can't read the number";
+		return value;
+	}
+	if (*at == '.' && !assemblerSymbolChar(at[1])) return ++at, here;
+	if (assemblerSymbolChar(*at)) {
+		const char * start = at;
+		while (assemblerSymbolChar(*at)) ++at;
+		std::string name(start, at);
+		typename std::unordered_map<std::string, Symbol>::const_iterator symbol = symbols.find(name);
+		if (symbol == symbols.end() || symbol->second.line == 0) {
+			if (pass == 1) problem = (problem != NULL)? problem : (assemblerRegister(name) >= 0)? "A register can't be used as a value" : "Undefined symbol";
+			return 0;
+		}
+		if (symbol->second.line >= line) forward = true;
+		return symbol->second.value;
+	}
+	problem = (problem != NULL)? problem : "Expected a value";
+	return 0;
+}
+
+/* One character of a string or 'c', with the escapes \n \t \r \0 \\ \' \" and \xHH */
+template <int AddrBits>
+bool AssemblerT<AddrBits>::parseCharacter(const char *& at, char quote, long & value) {
+	if (*at == '\0' || *at == quote) return false;
+	if (*at != '\\') {
+		value = (unsigned char) *at++;
+		return true;
+	}
+	++at;
+	switch (*at) {
+		case 'n': value = '\n'; break;
+		case 't': value = '\t'; break;
+		case 'r': value = '\r'; break;
+		case '0': value = 0; break;
+		case '\\': case '\'': case '"': value = *at; break;
+		case 'x':
+			if (!isxdigit((unsigned char) at[1])) return false;
+			value = strtol(at + 1, (char **) &at, 16) & 0xFF;
+			return true;
+		default:
+			problem = (problem != NULL)? problem : "Unknown escape";
+			return false;
+	}
+	++at;
+	return true;
+}
+
+/* Puts the program in memory, like loadFromFile would */
+template <int AddrBits>
+bool AssemblerT<AddrBits>::load(Machine & cpu) const {
+	cpu.progStart = first;
+	bool loaded = cpu.loadFromMemory(program.data(), (int) program.size());
+	cpu.progStart = entry;
+	return loaded;
+}
+
+/* Saves in the text format of loadFromFile: four bytes a line at most, each statement after its first bytes */
+template <int AddrBits>
+bool AssemblerT<AddrBits>::saveText(const char * fileName, EmulatorOutput * messages) const {
+	if (entry != first) {
+		messages->print("Error. The text format starts where it loads (0x%02X), not at 0x%02X. Save an image instead.\n", first, entry);
+		return false;
+	}
+	FILE * file = fopen(fileName, "w");
+	if (file == NULL) {
+		messages->print("Can't open %s. Unable to save.\n", fileName);
+		return false;
+	}
+
+	fprintf(file, "// %i bytes, load with progstart 0x%02X\n\n", (int) program.size(), first);
+	for (size_t index = 0; index < listing.size(); ++index) {
+		const Listing & bytes = listing[index];
+		for (int offset = 0; offset < bytes.count; offset += 4) {
+			for (int byte = offset; byte < offset + 4 && byte < bytes.count; ++byte)
+				fprintf(file, (byte == offset)? "0x%02X" : " 0x%02X", program[bytes.offset + byte]);
+			if (offset == 0) {
+				const char * statement = text.c_str() + bytes.begin;
+				const char * last = text.c_str() + bytes.end;
+				while (*statement == ' ' || *statement == '\t') ++statement;
+				while (last > statement && (last[-1] == ' ' || last[-1] == '\t')) --last;
+				fprintf(file, "\t! %.*s", (int)(last - statement), statement);
+			}
+			fprintf(file, "\n");
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+/* Saves as a binary image, through a machine holding the program */
+template <int AddrBits>
+bool AssemblerT<AddrBits>::saveImage(const char * fileName, EmulatorOutput * messages) const {
+	std::unique_ptr<Machine> cpu(new Machine()); /* Heap, it is a few kilobytes (megabytes when wide) */
+	cpu->output = messages;
+	return load(*cpu) && cpu->saveImage(fileName, first, (int) program.size());
+}
+
+template <int AddrBits>
+bool AssemblerT<AddrBits>::symbol(const char * name, long & value) const {
+	typename std::unordered_map<std::string, Symbol>::const_iterator found = symbols.find(name);
+	if (found == symbols.end() || found->second.line == 0) return false;
+	value = found->second.value;
+	return true;
+}
+
+template class AssemblerT<8>;
+template class AssemblerT<16>;
\ No newline at end of file
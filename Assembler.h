@@ -0,0 +1,107 @@
+/*	Assembler.h
+*
+*	ByteSyzed Assembler Header.
+*
+*	Turns mnemonics (the names in the opcode table of README.md) into
+*	program bytes, with labels, constants and expressions in place of hand
+*	computed addresses. The result loads straight into a machine, or is
+*	saved in the text format loadFromFile reads or as a binary image.
+*
+*	Source format, one statement per line, "; " or "//" starts a comment:
+*		label:                    Names the address of what follows
+*		name = expr               Names a constant (also ".equ name, expr")
+*		mov r1, 'H'               Registers are r0 to rF (pc is rF, sp is rE)
+*		mov r2, [r3]              [rB] is the byte a register points to
+*		add r1, r2, [table + 1]   [expr] is the byte at an address
+*		lea r4, [2*count+1]       Scale and offset of "lea"
+*		jne r1, r2, loop          Jumps, calls and skips take expressions
+*		printstr "Hi\n"           The 0 after the text is added
+*		.byte 1, 2, "text", 0     Bytes and strings as they are
+*		.ascii "text"             A string, without a 0
+*		.org 0x10                 Loads at (or pads up to) an address
+*		.entry start              Where the program starts, if not its first byte
+*	Expressions are C-like on integers: + - * / % << >> & ^ | ~ and
+*	parentheses, numbers in decimal, hex (0x), binary (0b) or octal
+*	(leading 0), 'c' characters, symbols, and "." for the address of the
+*	statement itself.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "ByteSyzed.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template <int AddrBits>
+class AssemblerT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+
+	std::vector<unsigned char> program; /* Assembled bytes, loaded at first */
+	Word first, entry; /* Where the program loads (.org before anything else, 0 otherwise) and where it starts (.entry, first otherwise) */
+	int errors; /* Errors found by the last assemble */
+
+	bool assemble(const char * source, EmulatorOutput * messages = &standardOutput); /* Assembles source text. False (and every error, by line, in messages) if it has errors */
+	bool assembleFile(const char * fileName, EmulatorOutput * messages = &standardOutput);
+	bool load(Machine & cpu) const; /* Puts the program in memory, with progStart at its entry point and loadedCount set, like loadFromFile */
+	bool saveText(const char * fileName, EmulatorOutput * messages = &standardOutput) const; /* Saves in the text format of loadFromFile, with each statement beside its bytes */
+	bool saveImage(const char * fileName, EmulatorOutput * messages = &standardOutput) const; /* Saves as a binary image (see ByteSyzed::saveImage) */
+	bool symbol(const char * name, long & value) const; /* Value of a label or constant of the last assemble. False if there is none */
+
+private:
+	struct Symbol {
+		long value;
+		int line; /* Where it is defined, 0 until it is */
+		Symbol() : value(0), line(0) {}
+	};
+	/* Bytes a source line put in program, for saveText */
+	struct Listing {
+		int offset, count; /* Bytes in program */
+		int begin, end; /* Statement in text */
+	};
+
+	std::string text; /* Source of the last assemble */
+	std::vector<Listing> listing;
+	std::vector<std::string> operands; /* Of the statement being assembled, kept to reuse their memory */
+	std::unordered_map<std::string, Symbol> symbols;
+	EmulatorOutput * messages;
+	int pass, line; /* Pass 0 only sizes statements and defines labels, pass 1 emits */
+	long here; /* Address of the statement being assembled */
+	bool forward; /* An expression used a symbol defined on this line or later */
+	bool placed; /* Something was emitted, so .org can only pad */
+	bool entrySet; /* .entry was given */
+	const char * problem; /* First thing wrong with the expression being read, NULL if nothing is */
+
+	void error(const char * format, ...);
+	void assembleLine(const char * begin, const char * end);
+	void assembleInstruction(const std::string & mnemonic, std::vector<std::string> & operands);
+	void emit(long value, const char * what); /* One byte, value must fit */
+	void emitAddress(long value);
+	void emitString(const std::string & operand);
+
+	/* Expressions, parsed straight from the text and evaluated as they go */
+	long evaluate(const std::string & operand);
+	long parseOr(const char *& at);
+	long parseXor(const char *& at);
+	long parseAnd(const char *& at);
+	long parseShift(const char *& at);
+	long parseSum(const char *& at);
+	long parseProduct(const char *& at);
+	long parseUnary(const char *& at);
+	bool parseCharacter(const char *& at, char quote, long & value); /* One character of a string or 'c', escapes included */
+};
+
+typedef AssemblerT<8> Assembler;
+typedef AssemblerT<16> Assembler16;
+
+/* Built once in Assembler.cpp */
+extern template class AssemblerT<8>;
+extern template class AssemblerT<16>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*	BatchRunner.cpp
+*
+*	ByteSyzed Batch Runner Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "BatchRunner.h"
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/* Queues a program file */
+void BatchRunner::addFile(const char * fileName, const char * input) {
+	Job job;
+	job.fileName = fileName;
+	job.input = input;
+	jobs.push_back(job);
+}
+
+/* Queues a byte image */
+void BatchRunner::addImage(const unsigned char * image, int count, const char * input) {
+	Job job;
+	job.image.assign(image, image + count);
+	job.input = input;
+	jobs.push_back(job);
+}
+
+/* Queues a run continuing from a snapshot. Forks of one snapshot share it */
+void BatchRunner::addFork(std::shared_ptr<const ByteSyzed::Snapshot> snapshot, const char * input) {
+	Job job;
+	job.snapshot = snapshot;
+	job.input = input;
+	jobs.push_back(job);
+}
+
+/* Same program, or forks of the same snapshot */
+static bool sameStart(const BatchRunner::Job & one, const BatchRunner::Job & other) {
+	return one.snapshot == other.snapshot && one.fileName == other.fileName && one.image == other.image;
+}
+
+/* Runs one job on a worker's instance. Output and input are in memory and private to the instance, so nothing interleaves */
+void BatchRunner::runJob(ByteSyzed & cpu, Pristine & pristine, const Job & job, Result & result) {
+	MemoryOutput output, dump;
+	QueueInput input;
+	input.push(job.input.c_str());
+	cpu.output = &output;
+	cpu.input = &input;
+	cpu.dumpOutput = &dump;
+
+	result.exitCode = 0;
+	result.status = ByteSyzed::faulted;
+	const bool again = pristine.job != NULL && sameStart(*pristine.job, job); /* Nothing to load, only the last run to undo */
+	if (job.snapshot) {
+		/* Restoring writes only what the last job changed, so forks of one snapshot keep its decoded code */
+		if (again) cpu.resetTo(*job.snapshot);
+		else cpu.restoreSnapshot(*job.snapshot);
+		input.seek(0); /* The fork's input starts at the snapshot */
+		pristine.job = &job;
+		result.loaded = true;
+		result.status = cpu.step(maxSteps);
+		result.exitCode = cpu.regs[0x0];
+	}
+	else if (again) {
+		cpu.resetTo(pristine.booted);
+		result.loaded = true;
+		result.status = cpu.step(maxSteps);
+		result.exitCode = cpu.regs[0x0];
+	}
+	else {
+		cpu.wipeMemory();
+		cpu.progStart = progStart;
+		if (job.fileName.empty())
+			result.loaded = cpu.loadFromMemory(job.image.data(), (int) job.image.size());
+		else
+			result.loaded = cpu.loadFromFile(job.fileName.c_str());
+
+		pristine.job = NULL;
+		if (result.loaded) {
+			/* Kept booted, so the next job with this program starts from here */
+			cpu.boot();
+			cpu.saveSnapshot(pristine.booted);
+			pristine.booted.inputPosition = -1;
+			cpu.clearDirty();
+			pristine.job = &job;
+			result.status = cpu.step(maxSteps);
+			result.exitCode = cpu.regs[0x0];
+		}
+	}
+
+	result.steps = cpu.steps;
+	memcpy(result.regs, cpu.regs, sizeof(result.regs));
+	memcpy(result.mem, cpu.mem, sizeof(result.mem));
+
+	result.output = output.text();
+	result.dump = dump.text();
+	cpu.output = &standardOutput, cpu.input = &standardInput, cpu.dumpOutput = NULL; /* None outlive the job */
+}
+
+/*
+*	Work-stealing pool. Every worker starts with a contiguous share of the
+*	jobs and takes from the front of it. A worker that runs dry steals the
+*	back half of the first other share that still has work, so a few slow
+*	programs do not leave the rest of the cores idle.
+*/
+namespace {
+	struct Share {
+		std::mutex lock;
+		int next, end; /* Jobs [next, end) are still to run */
+	};
+
+	/* Takes the next job of a share, -1 if it is empty */
+	int take(Share & share) {
+		std::lock_guard<std::mutex> guard(share.lock);
+		return (share.next < share.end)? share.next++ : -1;
+	}
+
+	/* Moves the back half of another share into an empty one. Returns false if there was nothing to steal */
+	bool steal(Share * shares, int count, int thief) {
+		for (int offset = 1; offset < count; ++offset) {
+			Share & victim = shares[(thief + offset) % count];
+			int first, last;
+			{
+				std::lock_guard<std::mutex> guard(victim.lock);
+				int left = victim.end - victim.next;
+				if (left <= 0) continue;
+				last = victim.end;
+				victim.end -= (left + 1) / 2;
+				first = victim.end;
+			}
+			std::lock_guard<std::mutex> guard(shares[thief].lock);
+			shares[thief].next = first, shares[thief].end = last;
+			return true;
+		}
+		return false;
+	}
+}
+
+/* Runs every queued job, results in queue order */
+std::vector<BatchRunner::Result> BatchRunner::run(int threads) {
+	std::vector<Result> results(jobs.size());
+	int count = (int) jobs.size();
+
+	if (threads <= 0) threads = (int) std::thread::hardware_concurrency();
+	if (threads <= 0) threads = 1; /* Unknown core count */
+	if (threads > count) threads = count;
+	if (count == 0) return results;
+
+	std::unique_ptr<Share[]> shares(new Share[threads]);
+	for (int worker = 0; worker < threads; ++worker) {
+		shares[worker].next = (int)((long long) count * worker / threads);
+		shares[worker].end = (int)((long long) count * (worker + 1) / threads);
+	}
+
+	auto work = [&](int worker) {
+		/* One instance per worker, wiped between jobs, or only reset when a job runs the program of the last. Heap, it is a few kilobytes */
+		std::unique_ptr<ByteSyzed> cpu(new ByteSyzed());
+		std::unique_ptr<Pristine> pristine(new Pristine);
+		cpu->verbose = false;
+		cpu->prompt = false; /* Input is scripted */
+		cpu->dumpFileName = NULL; /* Workers would fight over debug.txt, the dump is kept in the result */
+
+		for (;;) {
+			int index = take(shares[worker]);
+			if (index < 0) {
+				if (!steal(shares.get(), threads, worker)) return;
+				continue;
+			}
+			runJob(*cpu, *pristine, jobs[index], results[index]);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int worker = 1; worker < threads; ++worker)
+		pool.emplace_back(work, worker);
+	work(0); /* The calling thread is a worker too */
+	for (auto & thread : pool)
+		thread.join();
+
+	return results;
+}
\ No newline at end of file
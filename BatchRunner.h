@@ -0,0 +1,64 @@
+/*	BatchRunner.h
+*
+*	ByteSyzed Batch Runner Header.
+*
+*	Runs many independent ByteSyzed programs at once, spread over a
+*	work-stealing pool with one thread per core.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "ByteSyzed.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class BatchRunner {
+public:
+	/* One program to run. Either snapshot, fileName or image is used */
+	struct Job {
+		std::shared_ptr<const ByteSyzed::Snapshot> snapshot; /* Machine to continue, shared by every fork of it */
+		std::string fileName; /* Program file in loadFromFile format, empty if image is used */
+		std::vector<unsigned char> image; /* Byte image loaded at progStart */
+		std::string input; /* Numbers read by getchar, whitespace separated */
+	};
+
+	/* What a program left behind */
+	struct Result {
+		bool loaded; /* False if the program could not be loaded (nothing ran) */
+		ByteSyzed::Status status; /* Why it stopped: exited, faulted or outOfSteps */
+		unsigned char exitCode; /* regs[0x0] at exit */
+		unsigned long long steps; /* Instructions executed, for a fork counting the ones before the snapshot */
+		unsigned char regs[ByteSyzed::n_regs]; /* Final registers */
+		unsigned char mem[ByteSyzed::n_mem]; /* Final memory */
+		std::string output; /* Everything the program printed */
+		std::string dump; /* Every fileDump of the program, one after another, empty if there was none */
+	};
+
+	unsigned char progStart = 0x00; /* Where every program is loaded */
+	unsigned long long maxSteps = ~0ULL; /* Most instructions a job may run, so a runaway program stops with outOfSteps instead of holding its worker */
+
+	void addFile(const char * fileName, const char * input = ""); /* Queues a program file */
+	void addImage(const unsigned char * image, int count, const char * input = ""); /* Queues a byte image */
+	void addFork(std::shared_ptr<const ByteSyzed::Snapshot> snapshot, const char * input = ""); /* Queues a run continuing from a snapshot, input is what getchar reads from there on */
+	std::vector<Result> run(int threads = 0); /* Runs every queued job, results in queue order. 0 threads means one per core */
+	void clear(void) { jobs.clear(); } /* Empties the queue */
+	int size(void) const { return (int) jobs.size(); }
+
+private:
+	/* What a worker's instance last started from. A job with the same program (or snapshot) only puts back the pages the last run wrote */
+	struct Pristine {
+		const Job * job = NULL; /* Last job that loaded, NULL if its program did not load */
+		ByteSyzed::Snapshot booted; /* The instance booted on that program, for jobs that load one */
+	};
+
+	std::vector<Job> jobs;
+
+	void runJob(ByteSyzed & cpu, Pristine & pristine, const Job & job, Result & result); /* Runs one job on a worker's instance */
+};
+
+#endif
\ No newline at end of file
@@ -8,69 +8,145 @@
 *
 *	Written by Charles Emerson (cjemerson AT alaska.edu)
 *	Created: 10/1/2017
-*	Last Edited: 10/15/2017
+*	Last Edited: 10/17/2026
 */
 
 #include "ByteSyzed.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileOutput standardOutput;
+FileInput standardInput;
+
+/* Copies bytes into the buffer, handing it over each time it fills */
+void EmulatorOutput::write(const char * bytes, size_t count) {
+	while (count > 0) {
+		if (used == bufferSize) flush();
+		size_t piece = bufferSize - used;
+		if (piece > count) piece = count;
+		memcpy(buffer + used, bytes, piece);
+		used += piece, bytes += piece, count -= piece;
+	}
+}
+
+/* Formats straight into the buffer. Text longer than what is left goes through the heap */
+void EmulatorOutput::print(const char * format, ...) {
+	va_list args, again;
+	va_start(args, format);
+	va_copy(again, args);
+	int length = vsnprintf(buffer + used, bufferSize - used, format, args);
+	va_end(args);
+	if (length >= 0 && (size_t) length < bufferSize - used) {
+		used += length;
+	}
+	else if (length > 0) {
+		std::string text(length + 1, '\0');
+		vsnprintf(&text[0], text.size(), format, again);
+		write(text.data(), length);
+	}
+	va_end(again);
+}
+
+/* Writes a buffer out and pushes it past the FILE's own buffer, so prompts show up */
+void FileOutput::drain(const char * bytes, size_t count) {
+	if (count > 0) fwrite(bytes, 1, count, file);
+	fflush(file);
+}
+
+/* Queues every number in text, whitespace separated */
+void QueueInput::push(const char * text) {
+	for (;;) {
+		char * end;
+		long value = strtol(text, &end, 0);
+		if (end == text) break;
+		push((int) value);
+		text = end;
+	}
+}
 
 /* Prints out the registers */
-void ByteSyzed::dump(unsigned char id) {
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::dump(unsigned char id) {
 	switch (id) {
 		case 0xFD: /* Dump both all of memory and all the registers */ 
 		case 0xFE: /* Dump all memory */
-			dumpMemRange(0, sizeof(mem)/sizeof(unsigned char) - 1);
+			dumpMemRange(0, n_mem - 1);
 			if (id == 0xFE)	break; /* Dump only memory */
 		case 0xFF: /* Dump all registers */
 			dumpRegs(0xFF);
 			break;
 		default: /* If it is a valid register then dump, else do nothing */
-			if (0 <= id && id < (sizeof(regs)/sizeof(unsigned char)))
+			if (0 <= id && id < (n_regs))
 				dumpRegs(id);
 			else
-				if (verbose) printf("Invalid dump id: %i. Disabled dump.\n", id);
+				if (verbose) output->print("Invalid dump id: %i. Disabled dump.\n", id);
 	}
 	return;
 }
 
 /* Prints a range of memory */
-void ByteSyzed::dumpMemRange(unsigned char first, unsigned char last) {
-		if (verbose) printf("Memory:\n");
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::dumpMemRange(Word first, Word last) {
+		if (verbose) output->print("Memory:\n");
 
 		/* Handles printing memory from lowest to highest memroy */
 		for (int index = first; index <= last; ++index)
-			printf("0x%02X : 0x%02X\n", index, mem[index]);
+			output->print("0x%02X : 0x%02X\n", index, mem[index]);
 
 		/* Handles printing memory from highest to lowest memroy */
 		for (int index = first; index >= last; --index)
-			printf("0x%02X : 0x%02X\n", index, mem[index]);
+			output->print("0x%02X : 0x%02X\n", index, mem[index]);
 }
 
 /* Prints individual or all registers */
-void ByteSyzed::dumpRegs(unsigned char id) {
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::dumpRegs(Word id) {
 	/* Prints an individual register if between 0 and the max register index */
-	if (0 <= id && id < sizeof(regs)/sizeof(unsigned char)) {
-		printf("regs[0x%01X] = 0x%02X\n", id, regs[id]);
+	if (0 <= id && id < n_regs) {
+		output->print("regs[0x%01X] = 0x%02X\n", id, regs[id]);
 	}
 	else { /* Prints all registers */
-		if (verbose) printf("Registers:\n");
-		for (int index = 0; index < (sizeof(regs)/sizeof(unsigned char)); ++index) {
-			printf("0x%01X : 0x%02X\n", index, regs[index]);
+		if (verbose) output->print("Registers:\n");
+		for (int index = 0; index < (n_regs); ++index) {
+			output->print("0x%01X : 0x%02X\n", index, regs[index]);
 		}
 	}
 }
 
 /* File dump. Dumps memory andy register values, used for debugging suite. */
-void ByteSyzed::fileDump() {
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::fileDump() {
+	/* Same text in memory, e.g. for the native debugging suite */
+	if (dumpOutput != NULL) {
+		for (int index = 0; index < n_mem; ++index)
+			dumpOutput->print("%02X\n", mem[index]);
+		for (int index = 0; index < n_regs; ++index)
+			dumpOutput->print("%02X\n", regs[index]);
+		return;
+	}
+
+	/* Disabled, e.g. when many programs run at once */
+	if (dumpFileName == NULL) return;
+
 	/* File pointer */
-	FILE * file = fopen("debug.txt", "w");
+	FILE * file = fopen(dumpFileName, "w");
+	if (file == NULL) return;
 
 	/* Prints out the value of each index of memory in hex */
-	for (int index = 0; index < sizeof(mem)/sizeof(unsigned char); ++index) {
+	for (int index = 0; index < n_mem; ++index) {
 		fprintf(file, "%02X\n", mem[index]);
 	}
 
 	/* Prints out the value of each register in hex */
-	for (int index = 0; index < sizeof(regs)/sizeof(unsigned char); ++index) {
+	for (int index = 0; index < n_regs; ++index) {
 		fprintf(file, "%02X\n", regs[index]);
 	}
 
@@ -78,21 +154,406 @@ void ByteSyzed::fileDump() {
 	fclose(file);
 }
 
-/* Operates the ByteSyzed CPU */
-unsigned char ByteSyzed::run(void) {
-	if (verbose) printf("Running...\n");
+/* Zeroes every count */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::Profile::clear(void) {
+	memset(this, 0, sizeof(*this));
+}
+
+/* Prints the profile as tables: every executed address (in address order, so loops show up as runs of equal counts), every executed opcode and every call target */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::Profile::report(EmulatorOutput & out, const unsigned char * mem) const {
+	unsigned long long total = 0, totalCalls = 0;
+	for (int index = 0; index < 256; ++index) total += opcodes[index];
+	for (int index = 0; index < n_mem; ++index) totalCalls += calls[index];
+	double percent = (total > 0)? 100.0 / total : 0.0;
+
+	out.print("Profile: %llu instructions, %llu calls, %llu returns, max call depth %i\n", total, totalCalls, returns, maxDepth);
+
+	out.print("\nAddress  Byte            Count        %%           Taken       Not taken\n");
+	for (int index = 0; index < n_mem; ++index) {
+		if (executed[index] == 0) continue;
+		out.print("   0x%02X  0x%02X %16llu  %6.2f%%", index, mem[index], executed[index], executed[index] * percent);
+		if (taken[index] + notTaken[index] > 0) out.print(" %15llu %15llu", taken[index], notTaken[index]);
+		out.print("\n");
+	}
+
+	out.print("\nOpcode            Count        %%\n");
+	for (int index = 0; index < 256; ++index) {
+		if (opcodes[index] == 0) continue;
+		out.print("  0x%02X %16llu  %6.2f%%\n", index, opcodes[index], opcodes[index] * percent);
+	}
+
+	if (totalCalls == 0) return;
+	out.print("\nCall target       Count\n");
+	for (int index = 0; index < n_mem; ++index) {
+		if (calls[index] == 0) continue;
+		out.print("       0x%02X %11llu\n", index, calls[index]);
+	}
+}
+
+/* Writes the profile as CSV, one line per nonzero count: kind,key,count,taken,notTaken */
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::Profile::save(const char * fileName) const {
+	FILE * file = fopen(fileName, "w");
+	if (file == NULL) return false;
+
+	unsigned long long total = 0;
+	for (int index = 0; index < 256; ++index) total += opcodes[index];
+
+	fprintf(file, "kind,key,count,taken,notTaken\n");
+	fprintf(file, "instructions,,%llu,,\n", total);
+	fprintf(file, "returns,,%llu,,\n", returns);
+	fprintf(file, "maxDepth,,%i,,\n", maxDepth);
+	for (int index = 0; index < n_mem; ++index) {
+		if (executed[index] == 0) continue;
+		fprintf(file, "address,0x%02X,%llu,%llu,%llu\n", index, executed[index], taken[index], notTaken[index]);
+	}
+	for (int index = 0; index < 256; ++index) {
+		if (opcodes[index] != 0) fprintf(file, "opcode,0x%02X,%llu,,\n", index, opcodes[index]);
+	}
+	for (int index = 0; index < n_mem; ++index) {
+		if (calls[index] != 0) fprintf(file, "call,0x%02X,%llu,,\n", index, calls[index]);
+	}
+
+	fclose(file);
+	return true;
+}
+
+/* Removes every watchpoint, event and count */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::Watch::clear(void) {
+	memset(points, 0, sizeof(points));
+	memset(reads, 0, sizeof(reads));
+	memset(writes, 0, sizeof(writes));
+	memset(executes, 0, sizeof(executes));
+	events.clear();
+	lost = 0;
+	stackLowest = n_mem - addrBytes; /* Where boot points it */
+	held = ~0ULL;
+}
+
+/* Raises events on kinds of access to first..last */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::Watch::watch(Word first, Word last, int kinds) {
+	for (int index = first; index <= last; ++index)
+		points[index] |= kinds & (read | write | execute);
+}
+
+/* Counts accesses to every address, or stops counting */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::Watch::heatmap(bool on) {
+	for (int index = 0; index < n_mem; ++index)
+		points[index] = on? (points[index] | counted) : (points[index] & ~counted);
+}
+
+/* Prints the stack against the program, every event, and the heatmap in address order */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::Watch::report(EmulatorOutput & out, Word programFirst, Word programLast) const {
+	const int headroom = (int) stackLowest - programLast - 1; /* Bytes left between the program and the stack, which grows down onto it */
+	out.print("Watch: %llu events, stack lowest 0x%02X (%i bytes deep), program 0x%02X to 0x%02X, ", (unsigned long long) events.size() + lost,
+		stackLowest, (int)(n_mem - addrBytes - stackLowest), programFirst, programLast);
+	if (headroom >= 0) out.print("%i bytes free between them\n", headroom);
+	else out.print("the stack ran into the program\n");
+
+	if (!events.empty()) {
+		out.print("\n           Step  Address  Kind      PC     Was\n");
+		for (int index = 0; index < (int) events.size(); ++index) {
+			const Event & event = events[index];
+			out.print("%15llu   0x%02X  %-7s  0x%02X    0x%02X\n", event.step, event.address,
+				(event.kind == read)? "read" : (event.kind == write)? "write" : "execute", event.pc, event.value);
+		}
+		if (lost > 0) out.print("%llu more not kept\n", lost);
+	}
+
+	bool counts = false;
+	for (int index = 0; index < n_mem && !counts; ++index)
+		counts = reads[index] + writes[index] + executes[index] > 0;
+	if (!counts) return;
+	out.print("\nAddress           Reads          Writes        Executes\n");
+	for (int index = 0; index < n_mem; ++index) {
+		if (reads[index] + writes[index] + executes[index] == 0) continue;
+		out.print("   0x%02X %15llu %15llu %15llu\n", index, reads[index], writes[index], executes[index]);
+	}
+}
+
+/*
+*	Writes the report as CSV: kind,address,step,pc,value,reads,writes,executes.
+*	Summary lines come first (programFirst, programLast, stackLowest, and
+*	headroom with the free bytes as value, negative once the stack ran into
+*	the program), then one line per event, then a heat line per address
+*	that was accessed.
+*/
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::Watch::save(const char * fileName, Word programFirst, Word programLast) const {
+	FILE * file = fopen(fileName, "w");
+	if (file == NULL) return false;
+
+	fprintf(file, "kind,address,step,pc,value,reads,writes,executes\n");
+	fprintf(file, "programFirst,0x%02X,,,,,,\n", programFirst);
+	fprintf(file, "programLast,0x%02X,,,,,,\n", programLast);
+	fprintf(file, "stackLowest,0x%02X,,,,,,\n", stackLowest);
+	fprintf(file, "headroom,,,,%i,,,\n", (int) stackLowest - programLast - 1);
+	for (int index = 0; index < (int) events.size(); ++index) {
+		const Event & event = events[index];
+		fprintf(file, "%s,0x%02X,%llu,0x%02X,0x%02X,,,\n", (event.kind == read)? "read" : (event.kind == write)? "write" : "execute",
+			event.address, event.step, event.pc, event.value);
+	}
+	if (lost > 0) fprintf(file, "lost,,,,%llu,,,\n", lost);
+	for (int index = 0; index < n_mem; ++index) {
+		if (reads[index] + writes[index] + executes[index] == 0) continue;
+		fprintf(file, "heat,0x%02X,,,,%llu,%llu,%llu\n", index, reads[index], writes[index], executes[index]);
+	}
+
+	fclose(file);
+	return true;
+}
+
+/*
+*	Looks up everything the instruction about to run reads, writes and
+*	executes, from the registers as they are before it, one lookup in
+*	points per access. Counts the heatmap, keeps events and follows the
+*	stack pointer. True if the run should stop before the instruction.
+*/
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::watchStep(const Decoded * in) {
+	Watch & watched = *watch;
+	const Word pc = regs[0xF];
+	const unsigned long long step = steps + 1;
+	if (step == watched.held) { /* Stopped here last time, now it runs */
+		watched.held = ~0ULL;
+		return false;
+	}
+
+	bool hit = false;
+	auto access = [&](Word address, unsigned char kind) {
+		const unsigned char bits = watched.points[address];
+		if ((bits & (kind | Watch::counted)) == 0) return; /* The fast path */
+		if (bits & Watch::counted) ++((kind == Watch::read)? watched.reads : (kind == Watch::write)? watched.writes : watched.executes)[address];
+		if ((bits & kind) == 0) return;
+		hit = true;
+		if (watched.events.size() >= Watch::maxEvents) {
+			++watched.lost;
+			return;
+		}
+		typename Watch::Event event = {step, pc, address, kind, mem[address]};
+		watched.events.push_back(event);
+	};
+
+	access(pc, Watch::execute);
+	switch (in->opcode) {
+		case 0x11: access(regs[in->b], Watch::read); break; /* "mov A [B]" */
+		case 0x12: access(regs[in->a], Watch::write); break;
+		case 0x13: access(regs[in->b], Watch::read), access(regs[in->a], Watch::write); break;
+		case 0x19: /* "cas AB" writes only when it swaps */
+			access(regs[in->a], Watch::read);
+			if (mem[regs[in->a]] == regs[0x0]) access(regs[in->a], Watch::write);
+			break;
+		case 0x1A: access(regs[in->a], Watch::read), access(regs[in->a], Watch::write); break;
+		case 0xA1: case 0xA8: case 0xA9: access(in->imm1, Watch::read); break;
+		case 0xA2: case 0xAA: access(in->imm1, Watch::write); break;
+		case 0xE2: { /* "printstr" reads up to its 0, at most all of memory */
+			Word at = pc + 1;
+			for (int count = 0; count < n_mem; ++at, ++count) {
+				access(at, Watch::read);
+				if (mem[at] == 0) break;
+			}
+			break;
+		}
+	}
+	Word lowest = regs[0xE];
+	if (((in->opcode & 0xF0) == 0x80 || in->opcode == 0xC2) && regs[0xE] >= addrBytes) { /* Push and call */
+		lowest = regs[0xE] - addrBytes;
+		for (int index = 0; index < addrBytes; ++index)
+			access((Word)(lowest + index), Watch::write);
+	}
+	if (((in->opcode & 0xF0) == 0x90 || in->opcode == 0xC3) && regs[0xE] < n_mem - addrBytes) { /* Pop and ret */
+		for (int index = 0; index < addrBytes; ++index)
+			access((Word)(regs[0xE] + index), Watch::read);
+	}
+
+	if (lowest < watched.stackLowest) watched.stackLowest = lowest;
+	if (hit && watched.stop) {
+		watched.held = step;
+		return true;
+	}
+	return false;
+}
+
+/* Instruction length by opcode. 0 marks an invalid opcode. */
+template <int AddrBits>
+const unsigned char ByteSyzedT<AddrBits>::opcodeLength[256] = {
+/*	    0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+/* 0 */	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+/* 1 */	2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+/* 2 */	2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* 3 */	2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* 4 */	2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* 5 */	2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* 6 */	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* 7 */	2, 3, 3, 3, 3, 3, 3, 2, 2, 0, 0, 0, 0, 0, 0, 0,
+/* 8 */	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+/* 9 */	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+/* A */	2, 3, 3, 3, 3, 3, 4, 2, 3, 3, 3, 3, 3, 0, 0, 0,
+/* B */	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* C */	0, 0, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* D */	1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+/* E */	1, 1, 1, 2, 1, 0, 0, 0, 1, 1, 1, 1, 1, 2, 1, 1,
+/* F */	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* Decodes the instruction at an address into the predecode cache */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::decode(Word address) {
+	unsigned char bytes[maxLength];
+	for (int index = 0; index < maxLength; ++index)
+		bytes[index] = mem[(Word)(address + index)];
+	decodeBytes(bytes, decoded[address]);
+	cached = true;
+}
+
+/* Decodes an instruction from its (up to maxLength) bytes */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::decodeBytes(const unsigned char * bytes, Decoded & in) {
+	unsigned char opcode = bytes[0];
+
+	in.opcode = opcode;
+	in.next1 = bytes[1];
+	in.next2 = bytes[2];
+
+	/* Most instructions are "op AB imm1 imm2" */
+	in.a = in.next1 >> 4, in.b = in.next1 & 0xF;
+	in.imm1 = in.next2, in.imm2 = bytes[3];
+
+	switch (opcode & 0xF0) {
+		case 0x00: /* "movA val" */
+		case 0x80: /* "pushA" */
+		case 0x90: /* "popA" */
+			in.a = opcode & 0xF;
+			in.imm1 = in.next1;
+			break;
+		default:
+			switch (opcode) {
+				case 0x70: /* "jmp adr" */
+				case 0xC2: /* "call adr" */
+				case 0xE3: /* "spawn adr" */
+				case 0xED: /* "dump id" */
+					in.imm1 = in.next1;
+					break;
+				case 0xA2: /* "add adr AB" */
+				case 0xAA: /* "sub adr AB" */
+					in.imm1 = in.next1;
+					in.a = bytes[addrBytes + 1] >> 4, in.b = bytes[addrBytes + 1] & 0xF;
+					break;
+			}
+	}
+
+	/* Wider addresses take the bytes after the first one, little endian */
+	if (addrBytes > 1 && takesAddress(opcode)) {
+		const unsigned char * address = (opcode == 0x70 || opcode == 0xC2 || opcode == 0xE3 || opcode == 0xA2 || opcode == 0xAA)? bytes + 1 : bytes + 2;
+		in.imm1 = 0;
+		for (int index = 0; index < addrBytes; ++index)
+			in.imm1 |= (Word)(address[index] << (8 * index));
+	}
+
+	/* Invalid opcodes still take a slot so they are not decoded again */
+	in.length = (opcodeLength[opcode] != 0)? instructionLength(opcode) : 1;
+}
+
+/* Empties the predecode cache, and the block cache built from it. Nothing is decoded again between a wipe, a load and a boot, so only the first of them pays for it */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::invalidateDecoded(void) {
+	memset(dirty, 1, sizeof(dirty)); /* Memory changed behind writeMem, any page may differ */
+	traceSteps = ~0ULL; /* Memory changed behind the engines, a recorded run starts over with the whole state */
+	if (!cached) return;
+	memset(decoded, 0, sizeof(decoded)); /* length 0 is not decoded */
+	flushBlocks();
+	cached = false;
+}
+
+/* Points the program counter and stack pointer at their starting values */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::boot(void) {
 	regs[0xF] = progStart; /* "Program counter" -- points to program start */
-	regs[0xE] = (sizeof(mem)/sizeof(unsigned char))-1; /* "Stack pointer" -- points to highest memory address */
-	mem[regs[0xE]] = progStart; /* Program start is stored at the bottom of the stack */
+	regs[0xE] = n_mem - addrBytes; /* "Stack pointer" -- points to the highest slot in memory */
+	for (int index = 0; index < addrBytes; ++index) /* Program start is stored at the bottom of the stack */
+		mem[regs[0xE] + index] = (unsigned char)(progStart >> (8 * index));
+	invalidateDecoded(); /* mem is public, so anything cached may be stale */
+	steps = 0;
+	status = running;
+	if (watch != NULL) watch->held = ~0ULL; /* A stop in an earlier run is not resumed */
+}
+
+/*
+*	Engine helpers. Every handler ends in NEXT_ADVANCE (step past the
+*	instruction) or NEXT_JUMP (the handler already set the program counter).
+*	The switch engine loops back to a single switch. The threaded engine
+*	fetches the next instruction at the end of each handler and jumps straight
+*	to its label, so each handler gets its own indirect branch. Both stop
+*	before the fetch once steps reaches stepLimit. A recorded run finishes
+*	the last instruction's record before anything can decode over it.
+*/
+#define FETCH() { \
+	if (Trace::recorded && traceRecord != NULL) traceFinish(); \
+	if (steps >= stepLimit) { status = outOfSteps; return regs[0x0]; } \
+	if (decoded[regs[0xF]].length == 0) decode(regs[0xF]); \
+	in = &decoded[regs[0xF]]; \
+	if (Trace::watched && watchStep(in)) { status = watchHit; return regs[0x0]; } \
+	length = in->length; \
+	++steps; \
+	if (Trace::profiled) ++profile->executed[regs[0xF]], ++profile->opcodes[in->opcode]; \
+	if (Trace::recorded) traceStep(in); \
+	if (Trace::enabled) output->print("  [0x%02X] : 0x%02X", regs[0xF], in->opcode); \
+}
+#if BYTESYZED_THREADED
+#define TARGET(label) label:
+#define NEXT_JUMP() { if (Threaded) { FETCH(); goto *dispatch[in->opcode]; } continue; }
+#else
+#define TARGET(label)
+#define NEXT_JUMP() { continue; }
+#endif
+#define NEXT_ADVANCE() { regs[0xF] += length; NEXT_JUMP(); }
+#define PROFILE_BRANCH(counts) { if (Trace::profiled) ++profile->counts[regs[0xF]]; } /* Before the program counter moves */
+
+/* Executes from the current program counter until exit, invalid opcode or seg fault */
+template <int AddrBits>
+template <class Trace, bool Threaded>
+unsigned char ByteSyzedT<AddrBits>::execute(void) {
+#if BYTESYZED_THREADED
+#define L(label) &&op_##label /* op_xx handles invalid opcodes */
+	static void * const dispatch[256] = {
+/*	    0      1      2      3      4      5      6      7      8      9      A      B      C      D      E      F */
+/* 0 */	L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R), L(0R),
+/* 1 */	L(10), L(11), L(12), L(13), L(14), L(15), L(16), L(17), L(18), L(19), L(1A), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 2 */	L(20), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 3 */	L(30), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 4 */	L(40), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 5 */	L(50), L(51), L(52), L(53), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 6 */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 7 */	L(70), L(71), L(72), L(73), L(74), L(75), L(76), L(77), L(78), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 8 */	L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R), L(8R),
+/* 9 */	L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R), L(9R),
+/* A */	L(A0), L(A1), L(A2), L(A3), L(A4), L(A5), L(A6), L(A7), L(A8), L(A9), L(AA), L(AB), L(AC), L(xx), L(xx), L(xx),
+/* B */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* C */	L(xx), L(xx), L(C2), L(C3), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* D */	L(D0), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* E */	L(E0), L(E1), L(E2), L(E3), L(E4), L(xx), L(xx), L(xx), L(E8), L(E9), L(EA), L(EB), L(EC), L(ED), L(EE), L(EF),
+/* F */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx)
+	};
+#undef L
+#endif
+	const Decoded * in; /* Instruction being executed */
+	unsigned char length; /* Its length, kept apart since the instruction may overwrite itself */
+	Word old; /* What an atomic found in memory */
 
 	/* Continues to run until invalid opcode, seg faults, or emulator exits */
 	while(true) {
-		unsigned char opcode = mem[regs[0xF]];
-		unsigned char next1 = mem[regs[0xF]+1], next2 = mem[regs[0xF]+2], next3 = mem[regs[0xF]+3];
-
-		if (verbose) printf("  [0x%02X] : 0x%02X", regs[0xF], opcode);
+		FETCH();
+#if BYTESYZED_THREADED
+		if (Threaded) goto *dispatch[in->opcode];
+#endif
 
-		switch(opcode) {
+		switch(in->opcode) {
 			case 0x00: /* "movA val" -- mov reg[A], val */
 			case 0x01:
 			case 0x02:
@@ -108,179 +569,185 @@ unsigned char ByteSyzed::run(void) {
 			case 0x0C:
 			case 0x0D:
 			case 0x0E:
-			case 0x0F:
-				regs[opcode & 0xF] = next1;
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] = 0x%02X\n", next1, opcode & 0xF, next1);
-				if ((opcode & 0xF) != 0xF) { /* Have to compensate for the idea of immediately changing the program counter */
-					++regs[0xF];
-					break;
+			case 0x0F: TARGET(op_0R)
+				regs[in->a] = in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] = 0x%02X\n", in->next1, in->a, in->imm1);
+				if (in->a != 0xF) { /* Have to compensate for the idea of immediately changing the program counter */
+					NEXT_ADVANCE();
 				} else {
-					continue;
+					NEXT_JUMP();
 				}
-			case 0x10: /* "mov AB" -- reg[A] = reg[B] */
-				regs[next1 >> 4] = regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] = regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x11: /* "mov AB" -- reg[A] = mem[regs[B]] */
-				regs[next1 >> 4] = mem[regs[next1 & 0xF]];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] = mem[regs[0x%01X]]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x12: /* "mov AB" -- mem[reg[A]]=reg[B] */
-				mem[regs[next1 >> 4]] = regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tmem[regs[0x%01X]] = regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x13: /* "mov AB" -- mem[reg[A]] = mem[reg[B]] */
-				mem[regs[next1 >> 4]] = mem[regs[next1 & 0xF]];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tmem[regs[0x%01X]] = mem[regs[0x%01X]]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x14: /* "mov AB val" -- reg[A] = val, reg[B] = val */
-				regs[next1 >> 4] = next2, regs[next1 & 0xF] = next2;
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%02X, regs[0x%01X] = 0x%02X\n", next1, next2, next1>>4,next2, next1 & 0xF, next2);
-				break;
-			case 0x15: /* "inc AB" -- reg[A] += B */
-				regs[next1 >> 4] += next1 & 0xF;
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] += 0x%01X\n", next1, next1 >> 4, next2 & 0xF);
-				break;
-			case 0x16: /* "dec AB" -- reg[A] -= B */
-				regs[next1 >> 4] -= next1 & 0xF;
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] -= 0x%01X\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x17: /* "pco AB" -- reg[A] = regs[0xF] + B */
-				regs[next1 >> 4] = regs[0xF] + (next1 & 0xF);
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] = regs[0xF] + 0x%02X\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x18: /* "pco AB" -- reg[A] = reg[0xF] - B */
-				regs[next1 >> 4] = regs[0xF] - (next1 & 0xF);
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] = regs[0xF] - 0x%02X\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x20: /* "and AB" -- reg[A] &= reg[B] */
-				regs[next1 >> 4] &= regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] &= regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x30: /* "or AB" -- reg[A] |= reg[B] */
-				regs[next1 >> 4] |= regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] |= regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x40: /* "xor AB" -- reg[A] ^= reg[B] */
-				regs[next1 >> 4] ^= regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] ^= regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x50: /* "shl AB" -- reg[A] << (reg[B] % 8) */
-				regs[next1 >> 4] = regs[next1 >> 4] << (regs[next1 & 0xF] & 0x7);
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] << regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x51: /* "shr AB" -- reg[A] >> (reg[B] % 8) */
-				regs[next1 >> 4] = regs[next1 >> 4] << (regs[next1 & 0xF] & 0x7);
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] >> regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x52: /* "rol AB" -- reg[A] = (reg[A] >> 8-(reg[B]%8)) + (reg[A] << (reg[B]%8))*/
-				regs[next1 >> 4] = (regs[next1 >> 4] >> (8 - (regs[next1 & 0xF] & 0x7))) + (regs[next1 >> 4] << (regs[next1] & 0x7));
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\treg[0x%01X] = (reg[0x%01X] >> 8-(reg[0x%01X]%%8)) + (reg[0x%01X] << (reg[0x%01X]%%8))\n", next1, next1 >> 4, next1 >> 4,  next1 & 0xF, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x53: /* ror AB* -- reg[A] = (reg[A] << 8-(reg[B]%8)) + (reg[A] >> (reg[B] % 8)) */
-				regs[next1 >> 4] = (regs[next1 >> 4] << (8 - (regs[next1 & 0xF] & 0x7))) + (regs[next1 >> 4] >> (regs[next1] & 0x7));
-				++regs[0xF];
-			if (verbose) printf(" 0x%02X\t\treg[0x%01X] = (reg[0x%01X] << 8-(reg[0x%01X]%%8)) + (reg[0x%01X] >> (reg[0x%01X]%%8))\n", next1, next1 >> 4, next1 >> 4, next1 & 0xF, next1 >> 4, next1 & 0xF);
-				break;
-			case 0x70: /* "jmp adr" -- jmp [adr] */
-				regs[0xF] = next1;
-				if (verbose) printf(" 0x%02X\t\t(jmp) Jumping to [0x%02X]\n", next1, next1);
-				continue;
-			case 0x71: /* "jl AB adr" -- jmp [adr], if reg[A] < reg[B] */ 
-				if (regs[next1 >> 4] < regs[next1 & 0xF]) {
-					regs[0xF] = next2;
-					if (verbose) printf(" 0x%02X 0x%02X\t(jl) Jumping to [0x%02X]\n", next1, next2, next2);
-					continue;
+			case 0x10: TARGET(op_10) /* "mov AB" -- reg[A] = reg[B] */
+				regs[in->a] = regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] = regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x11: TARGET(op_11) /* "mov AB" -- reg[A] = mem[regs[B]] */
+				regs[in->a] = mem[regs[in->b]];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] = mem[regs[0x%01X]]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x12: TARGET(op_12) /* "mov AB" -- mem[reg[A]]=reg[B] */
+				writeMem(regs[in->a], regs[in->b]);
+				if (Trace::enabled) output->print(" 0x%02X\t\tmem[regs[0x%01X]] = regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x13: TARGET(op_13) /* "mov AB" -- mem[reg[A]] = mem[reg[B]] */
+				writeMem(regs[in->a], mem[regs[in->b]]);
+				if (Trace::enabled) output->print(" 0x%02X\t\tmem[regs[0x%01X]] = mem[regs[0x%01X]]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x14: TARGET(op_14) /* "mov AB val" -- reg[A] = val, reg[B] = val */
+				regs[in->a] = in->imm1, regs[in->b] = in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%02X, regs[0x%01X] = 0x%02X\n", in->next1, in->next2, in->a, in->imm1, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0x15: TARGET(op_15) /* "inc AB" -- reg[A] += B */
+				regs[in->a] += in->b;
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] += 0x%01X\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x16: TARGET(op_16) /* "dec AB" -- reg[A] -= B */
+				regs[in->a] -= in->b;
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] -= 0x%01X\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x17: TARGET(op_17) /* "pco AB" -- reg[A] = regs[0xF] + B */
+				regs[in->a] = regs[0xF] + in->b;
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] = regs[0xF] + 0x%02X\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x18: TARGET(op_18) /* "pco AB" -- reg[A] = reg[0xF] - B */
+				regs[in->a] = regs[0xF] - in->b;
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] = regs[0xF] - 0x%02X\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x19: TARGET(op_19) /* "cas AB" -- if mem[reg[A]] == regs[0x0] then mem[reg[A]] = reg[B]. regs[0x0] = what mem[reg[A]] was */
+				old = mem[regs[in->a]];
+				if (old == regs[0x0]) {
+					writeMem(regs[in->a], regs[in->b]);
+					if (Trace::enabled) output->print(" 0x%02X\t\t(cas) mem[regs[0x%01X]] = regs[0x%01X]\n", in->next1, in->a, in->b);
+				}
+				else if (Trace::enabled) output->print(" 0x%02X\t\t(cas) No swap. regs[0x0] = 0x%02X\n", in->next1, old);
+				regs[0x0] = old;
+				NEXT_ADVANCE();
+			case 0x1A: TARGET(op_1A) /* "xadd AB" -- mem[reg[A]] += reg[B]. reg[B] = what mem[reg[A]] was */
+				old = mem[regs[in->a]];
+				writeMem(regs[in->a], old + regs[in->b]);
+				regs[in->b] = old;
+				if (Trace::enabled) output->print(" 0x%02X\t\tmem[regs[0x%01X]] += regs[0x%01X], regs[0x%01X] = 0x%02X\n", in->next1, in->a, in->b, in->b, old);
+				NEXT_ADVANCE();
+			case 0x20: TARGET(op_20) /* "and AB" -- reg[A] &= reg[B] */
+				regs[in->a] &= regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] &= regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x30: TARGET(op_30) /* "or AB" -- reg[A] |= reg[B] */
+				regs[in->a] |= regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] |= regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x40: TARGET(op_40) /* "xor AB" -- reg[A] ^= reg[B] */
+				regs[in->a] ^= regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] ^= regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x50: TARGET(op_50) /* "shl AB" -- reg[A] << (reg[B] % 8) */
+				regs[in->a] = regs[in->a] << (regs[in->b] & (AddrBits - 1));
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] << regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x51: TARGET(op_51) /* "shr AB" -- reg[A] >> (reg[B] % 8) */
+				regs[in->a] = regs[in->a] >> (regs[in->b] & (AddrBits - 1));
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] >> regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x52: TARGET(op_52) /* "rol AB" -- reg[A] = (reg[A] >> 8-(reg[B]%8)) + (reg[A] << (reg[B]%8))*/
+				regs[in->a] = (regs[in->a] >> (AddrBits - (regs[in->b] & (AddrBits - 1)))) + (regs[in->a] << (regs[in->b] & (AddrBits - 1)));
+				if (Trace::enabled) output->print(" 0x%02X\t\treg[0x%01X] = (reg[0x%01X] >> 8-(reg[0x%01X]%%8)) + (reg[0x%01X] << (reg[0x%01X]%%8))\n", in->next1, in->a, in->a, in->b, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x53: TARGET(op_53) /* ror AB* -- reg[A] = (reg[A] << 8-(reg[B]%8)) + (reg[A] >> (reg[B] % 8)) */
+				regs[in->a] = (regs[in->a] << (AddrBits - (regs[in->b] & (AddrBits - 1)))) + (regs[in->a] >> (regs[in->b] & (AddrBits - 1)));
+				if (Trace::enabled) output->print(" 0x%02X\t\treg[0x%01X] = (reg[0x%01X] << 8-(reg[0x%01X]%%8)) + (reg[0x%01X] >> (reg[0x%01X]%%8))\n", in->next1, in->a, in->a, in->b, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0x70: TARGET(op_70) /* "jmp adr" -- jmp [adr] */
+				regs[0xF] = in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X\t\t(jmp) Jumping to [0x%02X]\n", in->next1, in->imm1);
+				NEXT_JUMP();
+			case 0x71: TARGET(op_71) /* "jl AB adr" -- jmp [adr], if reg[A] < reg[B] */ 
+				if (regs[in->a] < regs[in->b]) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jl) Jumping to [0x%02X]\n", in->next1, in->next2, in->imm1);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X 0x%02X\t(jl) No jump.\n", next1, next2);
-					regs[0xF] += 2;
-					break;
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jl) No jump.\n", in->next1, in->next2);
+					NEXT_ADVANCE();
 				}
-			case 0x72: /* "jle AB adr" -- jmp [adr], if reg[A] <= reg[B] */
-				if (regs[next1 >> 4] <= regs[next1 & 0xF]) {
-					regs[0xF] = next2;
-					if (verbose) printf(" 0x%02X 0x%02X\t(jle) Jumping to [0x%02X]\n", next1, next2, next2);
-					continue;
+			case 0x72: TARGET(op_72) /* "jle AB adr" -- jmp [adr], if reg[A] <= reg[B] */
+				if (regs[in->a] <= regs[in->b]) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jle) Jumping to [0x%02X]\n", in->next1, in->next2, in->imm1);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X 0x%02X\t(jle) No jump.\n", next1, next2);
-					regs[0xF] += 2;
-					break;
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jle) No jump.\n", in->next1, in->next2);
+					NEXT_ADVANCE();
 				}
-			case 0x73: /* "je AB adr" -- jmp [adr], if reg[A] == reg[B] */
-				if (regs[next1 >> 4] == regs[next1 & 0xF]) {
-					regs[0xF] = next2;
-					if (verbose) printf(" 0x%02X 0x%02X\t(je) Jumping to [0x%02X]\n", next1, next2, next2);
-					continue;
+			case 0x73: TARGET(op_73) /* "je AB adr" -- jmp [adr], if reg[A] == reg[B] */
+				if (regs[in->a] == regs[in->b]) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(je) Jumping to [0x%02X]\n", in->next1, in->next2, in->imm1);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X 0x%02X\t(je) No jump.\n", next1, next2);
-					regs[0xF] += 2;
-					break;
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(je) No jump.\n", in->next1, in->next2);
+					NEXT_ADVANCE();
 				}
-			case 0x74: /* "jge AB adr" -- jmp [adr], if reg[A] >= reg[B] */
-				if (regs[next1 >> 4] >= regs[next1 & 0xF]) {
-					regs[0xF] = next2;
-					if (verbose) printf(" 0x%02X 0x%02X\t(jge) Jumping to [0x%02X]\n", next1, next2, next2);
-					continue;
+			case 0x74: TARGET(op_74) /* "jge AB adr" -- jmp [adr], if reg[A] >= reg[B] */
+				if (regs[in->a] >= regs[in->b]) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jge) Jumping to [0x%02X]\n", in->next1, in->next2, in->imm1);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X 0x%02X\t(jge) No jump.\n", next1, next2);
-					regs[0xF] += 2;
-					break;
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jge) No jump.\n", in->next1, in->next2);
+					NEXT_ADVANCE();
 				}
-			case 0x75: /* "jg AB adr" -- jmp [adr], if reg[A] > reg[B] */
-				if (regs[next1 >> 4] > regs[next1 & 0xF]) {
-					regs[0xF] = next2;
-					if (verbose) printf(" 0x%02X 0x%02X\t(jg) Jumping to [0x%02X]\n", next1, next2, next2);
-					continue;
+			case 0x75: TARGET(op_75) /* "jg AB adr" -- jmp [adr], if reg[A] > reg[B] */
+				if (regs[in->a] > regs[in->b]) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jg) Jumping to [0x%02X]\n", in->next1, in->next2, in->imm1);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X 0x%02X\t(jg) No jump.\n", next1, next2);
-					regs[0xF] += 2;
-					break;
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jg) No jump.\n", in->next1, in->next2);
+					NEXT_ADVANCE();
 				}
-			case 0x76: /* "jne AB adr" -- jmp [adr], if reg[A] != reg[B] */
-				if (regs[next1 >> 4] != regs[next1 & 0xF]) {
-					regs[0xF] = next2;
-					if (verbose) printf(" 0x%02X 0x%02X\t(jne) Jumping to [0x%02X]\n", next1, next2, next2);
-					continue;
+			case 0x76: TARGET(op_76) /* "jne AB adr" -- jmp [adr], if reg[A] != reg[B] */
+				if (regs[in->a] != regs[in->b]) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jne) Jumping to [0x%02X]\n", in->next1, in->next2, in->imm1);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X 0x%02X\t(jne) No jump.\n", next1, next2);
-					regs[0xF] += 2;
-					break;
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X 0x%02X\t(jne) No jump.\n", in->next1, in->next2);
+					NEXT_ADVANCE();
 				}
-			case 0x77: /* "skipIfNZ AB" -- jmp [reg[0xF] + B + 2], if reg[A] != 0 */
-				if (regs[next1 >> 4] != 0x0) {
-					regs[0xF] += (next1 & 0xF) + 2;
-					if (verbose) printf(" 0x%02X\t\t(skipIfNZ) Skipping to [0x%02X]\n", next1, regs[0xF]);
-					continue;
+			case 0x77: TARGET(op_77) /* "skipIfNZ AB" -- jmp [reg[0xF] + B + 2], if reg[A] != 0 */
+				if (regs[in->a] != 0x0) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] += in->b + 2;
+					if (Trace::enabled) output->print(" 0x%02X\t\t(skipIfNZ) Skipping to [0x%02X]\n", in->next1, regs[0xF]);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X\t\t(skipIfNZ) No skip.\n", next1);
-					++regs[0xF];
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X\t\t(skipIfNZ) No skip.\n", in->next1);
 				}
-				break;
-			case 0x78: /* "skipIfZ AB" -- jmp [reg[0xF] + B + 2], if reg[A] == 0 */
-				if (regs[next1 >> 4] == 0x0) {
-					regs[0xF] += (next1 & 0xF) + 2;
-					if (verbose) printf(" 0x%02X\t\t(skipIfZ) Skipping to [0x%02X]\n", next1, regs[0xF]);
-					continue;
+				NEXT_ADVANCE();
+			case 0x78: TARGET(op_78) /* "skipIfZ AB" -- jmp [reg[0xF] + B + 2], if reg[A] == 0 */
+				if (regs[in->a] == 0x0) {
+					PROFILE_BRANCH(taken);
+					regs[0xF] += in->b + 2;
+					if (Trace::enabled) output->print(" 0x%02X\t\t(skipIfZ) Skipping to [0x%02X]\n", in->next1, regs[0xF]);
+					NEXT_JUMP();
 				} else {
-					if (verbose) printf(" 0x%02X\t\t(skipIfZ) No skip.\n", next1);
-					++regs[0xF];
+					PROFILE_BRANCH(notTaken);
+					if (Trace::enabled) output->print(" 0x%02X\t\t(skipIfZ) No skip.\n", in->next1);
 				}
-				break;
+				NEXT_ADVANCE();
 			case 0x80: /* "pushA" -- push reg[A] */
 			case 0x81:
 			case 0x82:
@@ -296,14 +763,16 @@ unsigned char ByteSyzed::run(void) {
 			case 0x8C:
 			case 0x8D:
 			case 0x8E:
-			case 0x8F:
+			case 0x8F: TARGET(op_8R)
 				/* Push if not at the edge of memory */
-				if(regs[0xE] > 0) {
-					mem[--regs[0xE]] = regs[opcode & 0xF];
-					if (verbose) printf("\t\t\tPushed regs[0x%01X]=0x%02X to [0x%02X]\n", opcode & 0xF, mem[regs[0xE]], regs[0xE]);
-					break;
+				if(regs[0xE] >= addrBytes) {
+					regs[0xE] -= addrBytes; /* Decrement first, so "push 0xE" pushes the new stack pointer */
+					writeWord(regs[0xE], regs[in->a]);
+					if (Trace::enabled) output->print("\t\t\tPushed regs[0x%01X]=0x%02X to [0x%02X]\n", in->a, readWord(regs[0xE]), regs[0xE]);
+					NEXT_ADVANCE();
 				} else {
-					printf("\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", regs[opcode & 0xF]);
+					output->print("\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", regs[in->a]);
+					status = faulted;
 					return(regs[0x0]);
 				}
 			case 0x90: /* "popA" -- pop reg[A] */
@@ -321,236 +790,1146 @@ unsigned char ByteSyzed::run(void) {
 			case 0x9C:
 			case 0x9D:
 			case 0x9E:
-			case 0x9F:
+			case 0x9F: TARGET(op_9R)
 				/* Pop if not at the edge of memory */
-				if (regs[0xE] != (sizeof(mem)/sizeof(unsigned char))-1) {
-					regs[opcode & 0xF] = mem[regs[0xE]];
-					if (verbose) printf("\t\t\tPopped 0x%02X from [0x%02X] into regs[0x%01X]\n", regs[opcode & 0xF], regs[0xE], opcode & 0xF);
-					++regs[0xE];
-					if ((opcode & 0xF) == 0xF) continue; else break; /* Have to compensate for the idea of immediately changing the program counter */
+				if (regs[0xE] < n_mem - addrBytes) {
+					regs[in->a] = readWord(regs[0xE]);
+					if (Trace::enabled) output->print("\t\t\tPopped 0x%02X from [0x%02X] into regs[0x%01X]\n", regs[in->a], regs[0xE], in->a);
+					regs[0xE] += addrBytes;
+					if (in->a == 0xF) { NEXT_JUMP(); } else { NEXT_ADVANCE(); } /* Have to compensate for the idea of immediately changing the program counter */
 				} else {
-					printf("\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", opcode & 0xF);
+					output->print("\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", in->a);
+					status = faulted;
 					return(regs[0x0]);
 				}
-			case 0xA0: /* "add AB" -- reg[A] += reg[B] */
-				regs[next1 >> 4] += regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] += regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0xA1: /* "add AB adr" -- reg[A] = reg[B] + mem[adr] */
-				regs[next1 >> 4] = regs[next1 & 0xF] + mem[next2];
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] + mem[0x%02X]\n", next1, next2, next1 >> 4, next1 & 0xF, next2);
-				break;
-			case 0xA2: /* "add adr AB" -- mem[adr] = reg[A] + reg[B] */
-				mem[next1] = regs[next2 >> 4] + regs[next2 & 0xF];
-				if (verbose) printf(" 0x%02X 0x%02X\tmem[0x%02X] = regs[0x%01X] + regs[0x%01X]\n", next1, next2, next1, next2 >> 4, next2 & 0xF);
-				regs[0xF] += 2;
-				break;
-			case 0xA3: /* "add AB val" -- reg[A] = reg[B] + val */
-				regs[next1 >> 4] = regs[next1 & 0xF] + next2;
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] + 0x%02X\n", next1, next2, next1 >> 4, next1 & 0xF, next2);
-				break;
-			case 0xA4: /* "lea AB val" -- reg[A] = B*val */
-				regs[next1 >> 4] = (next1 & 0xF)*next2;
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X * 0x%02X\n", next1, next2, next1 >> 4, next1 & 0xF, next2);
-				break;
-			case 0xA5: /* "lea AB val" -- reg[A] = B + val */
-				regs[next1 >> 4] = (next1 & 0xF) + next2;
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X + 0x%02X\n", next1, next2, next1 >> 4, next1 & 0xF, next2);
-				break;
-			case 0xA6: /* "lea AB val1 val2" -- reg[A] = B*val1 + val2 */
-				regs[next1 >> 4] = (next1 & 0xF) * next2 + next3;
-				regs[0xF] += 3;
-				if (verbose) printf(" 0x%02X 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X * 0x%02X + 0x%02X\n", next1, next2, next3, next1 >> 4, next1 & 0xF, next2, next3);
-				break;
-			case 0xA7: /* "sub AB" -- reg[A] -= reg[B] */
-				regs[next1 >> 4] -= regs[next1 & 0xF];
-				++regs[0xF];
-				if (verbose) printf(" 0x%02X\t\tregs[0x%01X] -= regs[0x%01X]\n", next1, next1 >> 4, next1 & 0xF);
-				break;
-			case 0xA8: /* "sub AB adr" -- reg[A] = reg[B] - mem[adr] */
-				regs[next1 >> 4] = regs[next1 & 0xF] - mem[next2];
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] - mem[0x%02X]\n", next1, next2, next1 >> 4, next1 & 0xF, next2);
-				break;
-			case 0xA9: /* "sub AB adr" -- reg[A] = mem[adr] - reg[B] */
-				regs[next1 >> 4] = mem[next2] - regs[next1 & 0xF];
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = mem[0x%02X] - regs[0x%01X]\n", next1, next2, next1 >> 4, next2, next1 & 0xF);
-				break;
-			case 0xAA: /* "sub adr AB" -- mem[adr] = reg[A] - reg[B] */
-				mem[next1] = regs[next2 >> 4] - regs[next2 & 0xF];
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tmem[0x%02X] = regs[0x%01X] - regs[0x%01X]\n", next1, next2, next1, next2 >> 4, next2 & 0xF);
-				break;
-			case 0xAB: /* "sub AB val" -- reg[A] = reg[B] - val */
-				regs[next1 >> 4] = regs[next1 & 0xF] - next2;
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] - 0x%02X\n", next1, next2, next1 >> 4, next1 & 0xF, next2);
-				break;
-			case 0xAC: /* "sub AB val" -- reg[A] = val - reg[B] */
-				regs[next1 >> 4] = next2 - regs[next1 & 0xF];
-				regs[0xF] += 2;
-				if (verbose) printf(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%02X - regs[0x%01X]\n", next1, next2, next1 >> 4, next2, next1 & 0xF);
-				break;			
-			case 0xC2: /* "call adr" -- call [adr] */
-				if (regs[0xE] > 0) { /* If not at the edge of memory */
-					mem[--regs[0xE]] = regs[0xF] + 2; /* push the return address onto the stack */
-					regs[0xF] = next1;
-					if (verbose) printf(" 0x%02X\t\tCalling [0x%02X]\n", next1, next1);
-					continue;
+			case 0xA0: TARGET(op_A0) /* "add AB" -- reg[A] += reg[B] */
+				regs[in->a] += regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] += regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0xA1: TARGET(op_A1) /* "add AB adr" -- reg[A] = reg[B] + mem[adr] */
+				regs[in->a] = regs[in->b] + mem[in->imm1];
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] + mem[0x%02X]\n", in->next1, in->next2, in->a, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0xA2: TARGET(op_A2) /* "add adr AB" -- mem[adr] = reg[A] + reg[B] */
+				writeMem(in->imm1, regs[in->a] + regs[in->b]);
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tmem[0x%02X] = regs[0x%01X] + regs[0x%01X]\n", in->next1, in->next2, in->imm1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0xA3: TARGET(op_A3) /* "add AB val" -- reg[A] = reg[B] + val */
+				regs[in->a] = regs[in->b] + in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] + 0x%02X\n", in->next1, in->next2, in->a, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0xA4: TARGET(op_A4) /* "lea AB val" -- reg[A] = B*val */
+				regs[in->a] = in->b * in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X * 0x%02X\n", in->next1, in->next2, in->a, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0xA5: TARGET(op_A5) /* "lea AB val" -- reg[A] = B + val */
+				regs[in->a] = in->b + in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X + 0x%02X\n", in->next1, in->next2, in->a, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0xA6: TARGET(op_A6) /* "lea AB val1 val2" -- reg[A] = B*val1 + val2 */
+				regs[in->a] = in->b * in->imm1 + in->imm2;
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X * 0x%02X + 0x%02X\n", in->next1, in->next2, in->imm2, in->a, in->b, in->imm1, in->imm2);
+				NEXT_ADVANCE();
+			case 0xA7: TARGET(op_A7) /* "sub AB" -- reg[A] -= reg[B] */
+				regs[in->a] -= regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X\t\tregs[0x%01X] -= regs[0x%01X]\n", in->next1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0xA8: TARGET(op_A8) /* "sub AB adr" -- reg[A] = reg[B] - mem[adr] */
+				regs[in->a] = regs[in->b] - mem[in->imm1];
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] - mem[0x%02X]\n", in->next1, in->next2, in->a, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0xA9: TARGET(op_A9) /* "sub AB adr" -- reg[A] = mem[adr] - reg[B] */
+				regs[in->a] = mem[in->imm1] - regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = mem[0x%02X] - regs[0x%01X]\n", in->next1, in->next2, in->a, in->imm1, in->b);
+				NEXT_ADVANCE();
+			case 0xAA: TARGET(op_AA) /* "sub adr AB" -- mem[adr] = reg[A] - reg[B] */
+				writeMem(in->imm1, regs[in->a] - regs[in->b]);
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tmem[0x%02X] = regs[0x%01X] - regs[0x%01X]\n", in->next1, in->next2, in->imm1, in->a, in->b);
+				NEXT_ADVANCE();
+			case 0xAB: TARGET(op_AB) /* "sub AB val" -- reg[A] = reg[B] - val */
+				regs[in->a] = regs[in->b] - in->imm1;
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] - 0x%02X\n", in->next1, in->next2, in->a, in->b, in->imm1);
+				NEXT_ADVANCE();
+			case 0xAC: TARGET(op_AC) /* "sub AB val" -- reg[A] = val - reg[B] */
+				regs[in->a] = in->imm1 - regs[in->b];
+				if (Trace::enabled) output->print(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%02X - regs[0x%01X]\n", in->next1, in->next2, in->a, in->imm1, in->b);
+				NEXT_ADVANCE();
+			case 0xC2: TARGET(op_C2) /* "call adr" -- call [adr] */
+				if (regs[0xE] >= addrBytes) { /* If not at the edge of memory */
+					regs[0xE] -= addrBytes;
+					writeWord(regs[0xE], regs[0xF] + 1 + addrBytes); /* push the return address onto the stack */
+					if (Trace::profiled) {
+						++profile->calls[in->imm1];
+						if (++profile->depth > profile->maxDepth) profile->maxDepth = profile->depth;
+					}
+					regs[0xF] = in->imm1;
+					if (Trace::enabled) output->print(" 0x%02X\t\tCalling [0x%02X]\n", in->next1, in->imm1);
+					NEXT_JUMP();
 				} else {
-					printf(" 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", next1, regs[0xF] + 2);
+					output->print(" 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", in->next1, (Word)(regs[0xF] + 1 + addrBytes));
+					status = faulted;
 					return regs[0x0];
 				}
-			case 0xC3: /* "ret" -- return */
-				if (regs[0xE] < (sizeof(mem)/sizeof(unsigned char) - 1)) { /* If not at the edge of memory */
-					regs[0xF] = mem[regs[0xE]++]; /* pop the return address of the stack */
-					if (verbose) printf("\t\t\tReturning to [0x%02X]\n", regs[0xF]);
-					continue;
+			case 0xC3: TARGET(op_C3) /* "ret" -- return */
+				if (regs[0xE] < n_mem - addrBytes) { /* If not at the edge of memory */
+					regs[0xF] = readWord(regs[0xE]); /* pop the return address of the stack */
+					regs[0xE] += addrBytes;
+					if (Trace::profiled) ++profile->returns, --profile->depth;
+					if (Trace::enabled) output->print("\t\t\tReturning to [0x%02X]\n", regs[0xF]);
+					NEXT_JUMP();
 				} else {
-					printf("\nSegmentation fault. At the edge of memory, unable to pop return address.\n");
+					output->print("\nSegmentation fault. At the edge of memory, unable to pop return address.\n");
+					status = faulted;
 					return regs[0x0];
 				}
-			case 0xD0: /* "nop" -- do nothing */
-				if (verbose) printf("\t\t\tDoing nothing\n");
-				break;
-			case 0xE0: /* "putchar" -- putchar(regs[0x1]) */
-				if (verbose) printf("\t\t\tEmulator Output. putchar(regs[0x1]) = '%c'\n", (regs[0x1] != '\n')? regs[0x1] : 1);
-				else printf("%c",regs[0x1]);
-				break;
-			case 0xE1: /* "getchar" -- regs[0x0] = getchar(int) */
-				if (verbose) printf("\t\t\tEmulator Input. regs[0x0] = getchar(int)\n");
-				if (prompt) printf("Enter an integer value (of a char): ");
+			case 0xD0: TARGET(op_D0) /* "nop" -- do nothing */
+				if (Trace::enabled) output->print("\t\t\tDoing nothing\n");
+				NEXT_ADVANCE();
+			case 0xE0: TARGET(op_E0) /* "putchar" -- putchar(regs[0x1]) */
+				if (Trace::enabled) output->print("\t\t\tEmulator Output. putchar(regs[0x1]) = '%c'\n", (regs[0x1] != '\n')? regs[0x1] : 1);
+				else output->put(regs[0x1]);
+				NEXT_ADVANCE();
+			case 0xE1: TARGET(op_E1) /* "getchar" -- regs[0x0] = getchar(int) */
+				if (!input->ready()) { /* Stops on the getchar, as if it had not been fetched */
+					--steps;
+					if (Trace::profiled) --profile->executed[regs[0xF]], --profile->opcodes[0xE1];
+					if (Trace::watched) watch->held = steps + 1; /* Counted once, when it runs */
+					if (Trace::enabled) output->print("\t\t\tEmulator Input. Waiting for input\n");
+					status = waitingForInput;
+					return regs[0x0];
+				}
+				if (Trace::enabled) output->print("\t\t\tEmulator Input. regs[0x0] = getchar(int)\n");
+				if (prompt) output->print("Enter an integer value (of a char): ");
+				output->flush(); /* Everything printed so far shows before waiting on input */
 				int tempInt;
-				scanf("%i", &tempInt);
-				regs[0x0] = (unsigned char)(tempInt % 256);
-				break;
-			case 0xE2: /* "printstr char[],0" -- puts(mem[++regs[0xF]]), while mem[regs[0xF]] != 0 */
-				if (verbose) printf("\t\t\tEmulator String Output: ");
-				while(mem[++regs[0xF]] != 0) printf("%c", mem[regs[0xF]]);
-				if (verbose) printf("\n");
-				break;
-			case 0xE8: /* "dumpRegs[0x0]" -- dumpRegs(0x0) */
-				if (verbose) printf("\t\t\tEmulator Register Dump. Dumping register 0x0.\n");
+				if (!input->read(tempInt)) tempInt = 0; /* No more input reads as 0 */
+				regs[0x0] = (Word)(tempInt % 256);
+				NEXT_ADVANCE();
+			case 0xE2: TARGET(op_E2) /* "printstr char[],0" -- puts(mem[++regs[0xF]]), while mem[regs[0xF]] != 0 */
+				if (Trace::enabled) output->print("\t\t\tEmulator String Output: ");
+				while(mem[++regs[0xF]] != 0) output->put(mem[regs[0xF]]);
+				if (Trace::enabled) output->print("\n");
+				NEXT_ADVANCE();
+			case 0xE3: TARGET(op_E3) /* "spawn adr" -- starts another core at adr, regs[0x0] = its id. A single core has none to start, so 0 (see MultiCore.h) */
+				regs[0x0] = 0;
+				if (Trace::enabled) output->print(" 0x%02X\t\tEmulator Spawn. No free core to start at [0x%02X], regs[0x0] = 0x00\n", in->next1, in->imm1);
+				NEXT_ADVANCE();
+			case 0xE4: TARGET(op_E4) /* "join" -- waits for core regs[0x1] to stop, regs[0x0] = its regs[0x0]. A single core has none to wait for, so 0 */
+				regs[0x0] = 0;
+				if (Trace::enabled) output->print("\t\t\tEmulator Join. No core 0x%02X to wait for, regs[0x0] = 0x00\n", regs[0x1]);
+				NEXT_ADVANCE();
+			case 0xE8: TARGET(op_E8) /* "dumpRegs[0x0]" -- dumpRegs(0x0) */
+				if (Trace::enabled) output->print("\t\t\tEmulator Register Dump. Dumping register 0x0.\n");
 				dumpRegs(0x0);
-				break;
-			case 0xE9: /* "dumpRegs[0x1]" -- dumpRegs(0x1) */
-				if (verbose) printf("\t\t\tEmulator Register Dump. Dumping register 0x1.\n");
+				NEXT_ADVANCE();
+			case 0xE9: TARGET(op_E9) /* "dumpRegs[0x1]" -- dumpRegs(0x1) */
+				if (Trace::enabled) output->print("\t\t\tEmulator Register Dump. Dumping register 0x1.\n");
 				dumpRegs(0x1);
-				break;
-			case 0xEA: /* "dumpMem" -- dumpMemRange(0, 0xFF)*/
-				if (verbose) printf("\t\t\tEmulator Memory Dump. Dumping all memory.\n");
-				dumpMemRange(0, sizeof(mem)/sizeof(unsigned char) - 1);
-				break;
-			case 0xEB: /* "dumpMemRange" -- dumpMemRange(regs[0x1], regs[0x2]) */
-				if (verbose) printf("\t\t\tEmulator Memory Range Dump. Dumping memory range [0x%02X] to [0x%02X]\n", regs[0x1], regs[0x2]);
+				NEXT_ADVANCE();
+			case 0xEA: TARGET(op_EA) /* "dumpMem" -- dumpMemRange(0, 0xFF)*/
+				if (Trace::enabled) output->print("\t\t\tEmulator Memory Dump. Dumping all memory.\n");
+				dumpMemRange(0, n_mem - 1);
+				NEXT_ADVANCE();
+			case 0xEB: TARGET(op_EB) /* "dumpMemRange" -- dumpMemRange(regs[0x1], regs[0x2]) */
+				if (Trace::enabled) output->print("\t\t\tEmulator Memory Range Dump. Dumping memory range [0x%02X] to [0x%02X]\n", regs[0x1], regs[0x2]);
 				dumpMemRange(regs[0x1], regs[0x2]);
-				break;
-			case 0xEC: /* "dumpRegs" -- dumpRegs(regs[0x1]) */
-				if (verbose) printf("\t\t\tEmulator Register Dump. Dumping register 0x%01X.\n", regs[0x1]);
+				NEXT_ADVANCE();
+			case 0xEC: TARGET(op_EC) /* "dumpRegs" -- dumpRegs(regs[0x1]) */
+				if (Trace::enabled) output->print("\t\t\tEmulator Register Dump. Dumping register 0x%01X.\n", regs[0x1]);
 				dumpRegs(regs[0x1]);
-				break;
-			case 0xED: /* "dump id" -- dump(id) */
-				if (verbose) printf(" 0x%02X\t\tEmulator Generic Dump. Dump id = 0x%02X\n", next1, next1);
-				dump(next1);
-				++regs[0xF];
-				break;
-			case 0xEE: /* "exit" -- return regs[0x0] */
-				if (verbose) printf("\t\t\tEmulator Exit. Returning 0x%02X\n", regs[0x0]);
+				NEXT_ADVANCE();
+			case 0xED: TARGET(op_ED) /* "dump id" -- dump(id) */
+				if (Trace::enabled) output->print(" 0x%02X\t\tEmulator Generic Dump. Dump id = 0x%02X\n", in->next1, in->imm1);
+				dump(in->imm1);
+				NEXT_ADVANCE();
+			case 0xEE: TARGET(op_EE) /* "exit" -- return regs[0x0] */
+				if (Trace::enabled) output->print("\t\t\tEmulator Exit. Returning 0x%02X\n", regs[0x0]);
+				status = exited;
 				return regs[0x0];
-			case 0xEF: /* "fileDump" -- dumps to debug.txt (for debugging) */
-				if (verbose) printf("\t\t\tEmulator Debug. Dumping to file debug.txt\n");
+			case 0xEF: TARGET(op_EF) /* "fileDump" -- dumps to debug.txt (for debugging) */
+				if (Trace::enabled) output->print("\t\t\tEmulator Debug. Dumping to file debug.txt\n");
 				fileDump();
-				break;
-			default: /* Invalid opcode. Exit the emulator. */
-				printf("\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", opcode, regs[0xF]);
+				NEXT_ADVANCE();
+			default: TARGET(op_xx) /* Invalid opcode. Exit the emulator. */
+				output->print("\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", in->opcode, regs[0xF]);
+				status = faulted;
 				return regs[0x0];
 		}
-		++regs[0xF]; /* increment the program counter */
 	}
 	return regs[0x0]; /* I don't know how you'd get here */
 }
 
+#undef TARGET
+#undef FETCH
+#undef NEXT_JUMP
+#undef NEXT_ADVANCE
+#undef PROFILE_BRANCH
+
+/* Runs the loaded program with the switch engine */
+template <int AddrBits>
+template <class Trace>
+unsigned char ByteSyzedT<AddrBits>::runSwitch(void) {
+	if (Trace::enabled) output->print("Running...\n");
+	boot();
+	if (Trace::recorded) traceBegin(true);
+	unsigned char exitCode = execute<Trace, false>();
+	if (Trace::recorded) traceEnd();
+	output->flush();
+	return exitCode;
+}
+
+#if BYTESYZED_THREADED
+/* Runs the loaded program with the threaded engine */
+template <int AddrBits>
+template <class Trace>
+unsigned char ByteSyzedT<AddrBits>::runThreaded(void) {
+	if (Trace::enabled) output->print("Running...\n");
+	boot();
+	if (Trace::recorded) traceBegin(true);
+	unsigned char exitCode = execute<Trace, true>();
+	if (Trace::recorded) traceEnd();
+	output->flush();
+	return exitCode;
+}
+#endif
+
+/* Operates the ByteSyzed CPU with the fastest engine this build has */
+template <int AddrBits>
+template <class Trace>
+unsigned char ByteSyzedT<AddrBits>::run(void) {
+	if (Trace::profiled) profile->depth = 0;
+	if (!Trace::enabled && !Trace::profiled && !Trace::recorded && !Trace::watched && translating) return runBlocks(); /* The block engine does not trace, profile, record or watch */
+#if BYTESYZED_THREADED
+	return runThreaded<Trace>();
+#else
+	return runSwitch<Trace>();
+#endif
+}
+
+/* Operates the ByteSyzed CPU, tracing if verbose is set, recording if trace is set, counting if profile is set, watching if watch is set */
+template <int AddrBits>
+unsigned char ByteSyzedT<AddrBits>::run(void) {
+	if (verbose) return run<Verbose>();
+	if (trace != NULL) return run<Recorded>();
+	if (profile != NULL) return run<Profiled>();
+	if (watch != NULL) return run<Watched>();
+	return run<Silent>();
+}
+
+/* Empties the block cache */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::flushBlocks(void) {
+	memset(blocks, 0, sizeof(blocks)); /* count 0 is not translated */
+	memset(codeMap, 0, sizeof(codeMap));
+	blockOpsUsed = 0;
+	++blockFlushes;
+}
+
+/* How an opcode uses its A and B fields: bits for read A, read B, write A, write B, shows all registers */
+template <int AddrBits>
+int ByteSyzedT<AddrBits>::registerFields(unsigned char opcode) {
+	switch (opcode & 0xF0) {
+		case 0x00: return writesA; /* "movA val" */
+		case 0x80: return readsA; /* "pushA" */
+		case 0x90: return writesA; /* "popA" */
+	}
+	switch (opcode) {
+		case 0x10: case 0x11: case 0xA1: case 0xA3: case 0xA8: case 0xA9: case 0xAB: case 0xAC:
+			return writesA | readsB;
+		case 0x12: case 0x13: case 0x19: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0xA2: case 0xAA:
+			return readsA | readsB; /* "cas AB" writes regs[0x0], which is not counted */
+		case 0x1A:
+			return readsA | readsB | writesB;
+		case 0x14:
+			return writesA | writesB;
+		case 0x15: case 0x16:
+			return readsA | writesA;
+		case 0x17: case 0x18: case 0xA4: case 0xA5: case 0xA6:
+			return writesA;
+		case 0x20: case 0x30: case 0x40: case 0x50: case 0x51: case 0x52: case 0x53: case 0xA0: case 0xA7:
+			return readsA | readsB | writesA;
+		case 0x77: case 0x78:
+			return readsA;
+		case 0xE8: case 0xE9: case 0xEA: case 0xEB: case 0xEC: case 0xED: case 0xEF:
+			return showsRegs;
+	}
+	return 0;
+}
+
+/* Translates the basic block starting at an address into micro-ops */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::translate(Word address) {
+	/* At most two micro-ops per instruction plus the fall through, start over if they might not fit */
+	if (blockOpsUsed + 2 * maxBlockInstructions + 1 > n_blockOps) flushBlocks();
+
+	Block & block = blocks[address];
+	block.first = blockOpsUsed;
+	block.next[0] = block.next[1] = -1;
+
+	Word pc = address;
+	for (unsigned char step = 1; ; ++step) {
+		if (decoded[pc].length == 0) decode(pc);
+		const Decoded & in = decoded[pc];
+
+		/* A write to any of these bytes drops the block */
+		for (int index = 0; index < in.length; ++index)
+			codeMap[(Word)(pc + index)] = 1;
+
+		const int fields = registerFields(in.opcode);
+		const bool readsPC = ((fields & readsA) && in.a == 0xF) || ((fields & readsB) && in.b == 0xF)
+			|| in.opcode == 0x17 || in.opcode == 0x18 || (fields & showsRegs);
+		const bool writesPC = ((fields & writesA) && in.a == 0xF) || ((fields & writesB) && in.b == 0xF);
+
+		MicroOp op = {in.opcode, in.a, in.b, in.imm1, in.imm2, pc, in.length, step};
+		bool ends = false; /* The instruction ends the block */
+
+		if (opcodeLength[in.opcode] == 0) { /* Invalid opcode */
+			op.kind = uInvalid, op.imm1 = in.opcode;
+			ends = true;
+		} else if (in.opcode <= 0x0F) { /* "movF val" is a jump */
+			op.kind = writesPC? 0x70 : uMovImm;
+			ends = writesPC;
+		} else if ((in.opcode & 0xF0) == 0x80 || (in.opcode & 0xF0) == 0x90) {
+			op.kind = in.opcode & 0xF0; /* One kind for every push and one for every pop */
+		} else if (!writesPC) {
+			switch (in.opcode) { /* Fold what is constant once the address is known */
+				case 0x14: /* "mov AB val" */
+					op.kind = uMovImm;
+					blockOps[blockOpsUsed++] = op;
+					op.a = in.b;
+					break;
+				case 0x15: op.kind = uAddImm, op.imm1 = in.b; break; /* "inc AB" */
+				case 0x16: op.kind = uAddImm, op.imm1 = (Word)(0 - in.b); break; /* "dec AB" */
+				case 0x17: op.kind = uMovImm, op.imm1 = pc + in.b; break; /* "pco AB" */
+				case 0x18: op.kind = uMovImm, op.imm1 = pc - in.b; break; /* "pco AB" */
+				case 0xA4: op.kind = uMovImm, op.imm1 = in.b * in.imm1; break; /* "lea AB val" */
+				case 0xA5: op.kind = uMovImm, op.imm1 = in.b + in.imm1; break; /* "lea AB val" */
+				case 0xA6: op.kind = uMovImm, op.imm1 = in.b * in.imm1 + in.imm2; break; /* "lea AB val1 val2" */
+				case 0xE3: case 0xE4: op.kind = uMovImm, op.a = 0x0, op.imm1 = 0; break; /* "spawn adr", "join", a single core gets 0 */
+			}
+		}
+
+		switch (in.opcode) {
+			case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0x77: case 0x78:
+			case 0xC2: case 0xC3: case 0xE2: case 0xEE:
+				ends = true;
+		}
+
+		/* Between blocks the program counter is kept out of regs[0xF], put it back for whoever reads it */
+		if (readsPC && op.kind != uMovImm && op.kind != uAddImm) {
+			MicroOp sync = {uSyncPC, 0, 0, 0, 0, pc, 0, step};
+			blockOps[blockOpsUsed++] = sync;
+		}
+		if (op.kind != 0xD0) blockOps[blockOpsUsed++] = op; /* nop has nothing to run */
+		if (ends) break;
+
+		/* The program counter is whatever the instruction left there ("popF" does not step past itself) */
+		if (writesPC) {
+			MicroOp jump = {uJumpReg, 0, 0, (Word)((in.opcode == 0x9F)? 0 : in.length), 0, pc, 0, step};
+			blockOps[blockOpsUsed++] = jump;
+			break;
+		}
+
+		pc += in.length;
+		if (step == maxBlockInstructions) { /* Long enough, continue in the next block */
+			MicroOp next = {uFallThrough, 0, 0, 0, 0, pc, 0, step};
+			blockOps[blockOpsUsed++] = next;
+			break;
+		}
+	}
+
+	block.count = blockOpsUsed - block.first;
+	block.steps = blockOps[blockOpsUsed - 1].step;
+}
+
+/* Block engine helpers. NEXT_OP runs the next micro-op of the block, threaded like execute() when the build allows */
+#if BYTESYZED_THREADED
+#define TARGET(label) label:
+#define NEXT_OP() { ++op; goto *dispatch[op->kind]; }
+#else
+#define TARGET(label)
+#define NEXT_OP() continue
+#endif
+
+/* Continues with the basic block engine from the current program counter. Silent, use resume<Verbose>() for a trace */
+template <int AddrBits>
+unsigned char ByteSyzedT<AddrBits>::resumeBlocks(void) {
+#if BYTESYZED_THREADED
+#define L(label) &&op_##label /* op_xx handles uInvalid, op_60 and up are the micro-op kinds */
+	static void * const dispatch[256] = {
+/*	    0      1      2      3      4      5      6      7      8      9      A      B      C      D      E      F */
+/* 0 */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 1 */	L(10), L(11), L(12), L(13), L(14), L(15), L(16), L(17), L(18), L(19), L(1A), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 2 */	L(20), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 3 */	L(30), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 4 */	L(40), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 5 */	L(50), L(51), L(52), L(53), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 6 */	L(60), L(61), L(62), L(63), L(64), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 7 */	L(70), L(71), L(72), L(73), L(74), L(75), L(76), L(77), L(78), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 8 */	L(80), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* 9 */	L(90), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* A */	L(A0), L(A1), L(A2), L(A3), L(A4), L(A5), L(A6), L(A7), L(A8), L(A9), L(AA), L(AB), L(AC), L(xx), L(xx), L(xx),
+/* B */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* C */	L(xx), L(xx), L(C2), L(C3), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* D */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx),
+/* E */	L(E0), L(E1), L(E2), L(xx), L(xx), L(xx), L(xx), L(xx), L(E8), L(E9), L(EA), L(EB), L(EC), L(ED), L(EE), L(EF),
+/* F */	L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx), L(xx)
+	};
+#undef L
+#endif
+
+	Word pc = regs[0xF]; /* Kept here between blocks, see uSyncPC */
+	unsigned long long executed = steps; /* steps, kept here until the engine stops */
+	const unsigned long long limit = stepLimit;
+	Block * block = &blocks[pc];
+	if (block->count == 0) translate(pc);
+	const MicroOp * op;
+	Word old; /* What an atomic found in memory */
+
+	/* Continues to run until invalid opcode, seg faults, or emulator exits */
+	while (true) {
+		/* Too few steps left for the whole block, the instruction engine stops exactly where they run out */
+		if (executed + block->steps > limit) {
+			regs[0xF] = pc, steps = executed;
+			unsigned char exitCode = execute<Silent, BYTESYZED_THREADED != 0>();
+			output->flush();
+			return exitCode;
+		}
+
+		const unsigned char flushes = blockFlushes;
+		op = &blockOps[block->first];
+		int link = -1; /* Successor taken, -1 if it is only known at run time */
+
+		for (;; ++op) {
+#if BYTESYZED_THREADED
+			goto *dispatch[op->kind];
+#endif
+			switch (op->kind) {
+				case uMovImm: TARGET(op_60) regs[op->a] = op->imm1; NEXT_OP();
+				case uAddImm: TARGET(op_61) regs[op->a] += op->imm1; NEXT_OP();
+				case uSyncPC: TARGET(op_62) regs[0xF] = op->pc; NEXT_OP();
+				case 0x10: TARGET(op_10) regs[op->a] = regs[op->b]; NEXT_OP();
+				case 0x11: TARGET(op_11) regs[op->a] = mem[regs[op->b]]; NEXT_OP();
+				case 0x12: TARGET(op_12) writeMem(regs[op->a], regs[op->b]); break;
+				case 0x13: TARGET(op_13) writeMem(regs[op->a], mem[regs[op->b]]); break;
+				case 0x14: TARGET(op_14) regs[op->a] = op->imm1, regs[op->b] = op->imm1; NEXT_OP();
+				case 0x15: TARGET(op_15) regs[op->a] += op->b; NEXT_OP();
+				case 0x16: TARGET(op_16) regs[op->a] -= op->b; NEXT_OP();
+				case 0x17: TARGET(op_17) regs[op->a] = regs[0xF] + op->b; NEXT_OP();
+				case 0x18: TARGET(op_18) regs[op->a] = regs[0xF] - op->b; NEXT_OP();
+				case 0x19: TARGET(op_19) /* "cas AB" */
+					old = mem[regs[op->a]];
+					if (old != regs[0x0]) { regs[0x0] = old; NEXT_OP(); }
+					writeMem(regs[op->a], regs[op->b]);
+					regs[0x0] = old;
+					break;
+				case 0x1A: TARGET(op_1A) /* "xadd AB" */
+					old = mem[regs[op->a]];
+					writeMem(regs[op->a], old + regs[op->b]);
+					regs[op->b] = old;
+					break;
+				case 0x20: TARGET(op_20) regs[op->a] &= regs[op->b]; NEXT_OP();
+				case 0x30: TARGET(op_30) regs[op->a] |= regs[op->b]; NEXT_OP();
+				case 0x40: TARGET(op_40) regs[op->a] ^= regs[op->b]; NEXT_OP();
+				case 0x50: TARGET(op_50) regs[op->a] = regs[op->a] << (regs[op->b] & (AddrBits - 1)); NEXT_OP();
+				case 0x51: TARGET(op_51) regs[op->a] = regs[op->a] >> (regs[op->b] & (AddrBits - 1)); NEXT_OP();
+				case 0x52: TARGET(op_52) regs[op->a] = (regs[op->a] >> (AddrBits - (regs[op->b] & (AddrBits - 1)))) + (regs[op->a] << (regs[op->b] & (AddrBits - 1))); NEXT_OP();
+				case 0x53: TARGET(op_53) regs[op->a] = (regs[op->a] << (AddrBits - (regs[op->b] & (AddrBits - 1)))) + (regs[op->a] >> (regs[op->b] & (AddrBits - 1))); NEXT_OP();
+				case 0x80: TARGET(op_80) /* "pushA" */
+					if (regs[0xE] >= addrBytes) {
+						regs[0xE] -= addrBytes;
+						writeWord(regs[0xE], regs[op->a]);
+						break;
+					}
+					output->print("\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", regs[op->a]);
+					status = faulted;
+					goto halt;
+				case 0x90: TARGET(op_90) /* "popA" */
+					if (regs[0xE] < n_mem - addrBytes) {
+						regs[op->a] = readWord(regs[0xE]);
+						regs[0xE] += addrBytes;
+						NEXT_OP();
+					}
+					output->print("\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", op->a);
+					status = faulted;
+					goto halt;
+				case 0xA0: TARGET(op_A0) regs[op->a] += regs[op->b]; NEXT_OP();
+				case 0xA1: TARGET(op_A1) regs[op->a] = regs[op->b] + mem[op->imm1]; NEXT_OP();
+				case 0xA2: TARGET(op_A2) writeMem(op->imm1, regs[op->a] + regs[op->b]); break;
+				case 0xA3: TARGET(op_A3) regs[op->a] = regs[op->b] + op->imm1; NEXT_OP();
+				case 0xA4: TARGET(op_A4) regs[op->a] = op->b * op->imm1; NEXT_OP();
+				case 0xA5: TARGET(op_A5) regs[op->a] = op->b + op->imm1; NEXT_OP();
+				case 0xA6: TARGET(op_A6) regs[op->a] = op->b * op->imm1 + op->imm2; NEXT_OP();
+				case 0xA7: TARGET(op_A7) regs[op->a] -= regs[op->b]; NEXT_OP();
+				case 0xA8: TARGET(op_A8) regs[op->a] = regs[op->b] - mem[op->imm1]; NEXT_OP();
+				case 0xA9: TARGET(op_A9) regs[op->a] = mem[op->imm1] - regs[op->b]; NEXT_OP();
+				case 0xAA: TARGET(op_AA) writeMem(op->imm1, regs[op->a] - regs[op->b]); break;
+				case 0xAB: TARGET(op_AB) regs[op->a] = regs[op->b] - op->imm1; NEXT_OP();
+				case 0xAC: TARGET(op_AC) regs[op->a] = op->imm1 - regs[op->b]; NEXT_OP();
+				case 0xE0: TARGET(op_E0) output->put(regs[0x1]); NEXT_OP();
+				case 0xE1: TARGET(op_E1) /* "getchar" */
+					if (!input->ready()) goto wait;
+					if (prompt) output->print("Enter an integer value (of a char): ");
+					output->flush();
+					int tempInt;
+					if (!input->read(tempInt)) tempInt = 0; /* No more input reads as 0 */
+					regs[0x0] = (Word)(tempInt % 256);
+					NEXT_OP();
+				case 0xE8: TARGET(op_E8) dumpRegs(0x0); NEXT_OP();
+				case 0xE9: TARGET(op_E9) dumpRegs(0x1); NEXT_OP();
+				case 0xEA: TARGET(op_EA) dumpMemRange(0, n_mem - 1); NEXT_OP();
+				case 0xEB: TARGET(op_EB) dumpMemRange(regs[0x1], regs[0x2]); NEXT_OP();
+				case 0xEC: TARGET(op_EC) dumpRegs(regs[0x1]); NEXT_OP();
+				case 0xED: TARGET(op_ED) dump(op->imm1); NEXT_OP();
+				case 0xEF: TARGET(op_EF) fileDump(); NEXT_OP();
+
+				/* Block ends */
+				case 0x70: TARGET(op_70) pc = op->imm1, link = 1; goto done;
+				case 0x71: TARGET(op_71) if (regs[op->a] < regs[op->b]) pc = op->imm1, link = 1; else pc = op->pc + 2 + addrBytes, link = 0; goto done;
+				case 0x72: TARGET(op_72) if (regs[op->a] <= regs[op->b]) pc = op->imm1, link = 1; else pc = op->pc + 2 + addrBytes, link = 0; goto done;
+				case 0x73: TARGET(op_73) if (regs[op->a] == regs[op->b]) pc = op->imm1, link = 1; else pc = op->pc + 2 + addrBytes, link = 0; goto done;
+				case 0x74: TARGET(op_74) if (regs[op->a] >= regs[op->b]) pc = op->imm1, link = 1; else pc = op->pc + 2 + addrBytes, link = 0; goto done;
+				case 0x75: TARGET(op_75) if (regs[op->a] > regs[op->b]) pc = op->imm1, link = 1; else pc = op->pc + 2 + addrBytes, link = 0; goto done;
+				case 0x76: TARGET(op_76) if (regs[op->a] != regs[op->b]) pc = op->imm1, link = 1; else pc = op->pc + 2 + addrBytes, link = 0; goto done;
+				case 0x77: TARGET(op_77) if (regs[op->a] != 0x0) pc = op->pc + op->b + 2, link = 1; else pc = op->pc + 2, link = 0; goto done;
+				case 0x78: TARGET(op_78) if (regs[op->a] == 0x0) pc = op->pc + op->b + 2, link = 1; else pc = op->pc + 2, link = 0; goto done;
+				case 0xC2: TARGET(op_C2) /* "call adr" */
+					if (regs[0xE] >= addrBytes) {
+						regs[0xE] -= addrBytes;
+						writeWord(regs[0xE], op->pc + 1 + addrBytes);
+						pc = op->imm1;
+						if (blockFlushes == flushes) link = 1;
+						goto done;
+					}
+					output->print(" 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", (unsigned char) op->imm1, (Word)(op->pc + 1 + addrBytes)); /* The byte after the opcode, as the other engines print it */
+					status = faulted;
+					goto halt;
+				case 0xC3: TARGET(op_C3) /* "ret" */
+					if (regs[0xE] < n_mem - addrBytes) {
+						pc = readWord(regs[0xE]);
+						regs[0xE] += addrBytes;
+						goto done;
+					}
+					output->print("\nSegmentation fault. At the edge of memory, unable to pop return address.\n");
+					status = faulted;
+					goto halt;
+				case 0xE2: TARGET(op_E2) /* "printstr char[],0" */
+					pc = op->pc;
+					while(mem[++pc] != 0) output->put(mem[pc]);
+					++pc;
+					goto done;
+				case 0xEE: TARGET(op_EE) status = exited; goto halt; /* "exit" */
+				case uFallThrough: TARGET(op_63) pc = op->pc, link = 0; goto done;
+				case uJumpReg: TARGET(op_64) pc = regs[0xF] + op->imm1; goto done;
+				default: TARGET(op_xx) /* uInvalid */
+					output->print("\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", op->imm1, op->pc);
+					status = faulted;
+					goto halt;
+			}
+
+			/* Only memory writes get here. If one hit translated code this block is stale, leave it */
+			if (blockFlushes != flushes) {
+				pc = (op->kind == 0x1A && op->b == 0xF)? regs[0xF] + op->length : op->pc + op->length; /* "xadd AF" also jumps */
+				goto done;
+			}
+		}
+
+	done:
+		executed += op->step;
+
+		/* Follow the link if this exit was taken before */
+		if (link >= 0 && block->next[link] >= 0) {
+			block = &blocks[block->next[link]];
+			continue;
+		}
+
+		Block * next = &blocks[pc];
+		if (next->count == 0) translate(pc);
+		if (link >= 0 && blockFlushes == flushes) block->next[link] = pc; /* Unless translating flushed this block */
+		block = next;
+	}
+
+halt:
+	regs[0xF] = op->pc; /* Stops on the instruction, like the other engines */
+	steps = executed + op->step;
+	output->flush();
+	return regs[0x0];
+
+wait: /* Stops on a getchar that has no input yet, without counting it */
+	regs[0xF] = op->pc;
+	steps = executed + op->step - 1;
+	status = waitingForInput;
+	output->flush();
+	return regs[0x0];
+}
+
+#undef TARGET
+#undef NEXT_OP
+
+/* Runs the loaded program with the basic block engine. Silent, use run<Verbose>() for a trace */
+template <int AddrBits>
+unsigned char ByteSyzedT<AddrBits>::runBlocks(void) {
+	boot();
+	return resumeBlocks();
+}
+
+/* Boots, then runs at most maxSteps instructions */
+template <int AddrBits>
+typename ByteSyzedT<AddrBits>::Status ByteSyzedT<AddrBits>::run(unsigned long long maxSteps) {
+	if (profile != NULL) profile->depth = 0;
+	boot();
+	return step(maxSteps);
+}
+
+/* Continues for at most count more instructions. A machine that stopped with outOfSteps or waitingForInput picks up where it was on the next step */
+template <int AddrBits>
+typename ByteSyzedT<AddrBits>::Status ByteSyzedT<AddrBits>::step(unsigned long long count) {
+	stepLimit = (count < ~0ULL - steps)? steps + count : ~0ULL;
+	status = running;
+	if (verbose) resume<Verbose>();
+	else if (trace != NULL) resume<Recorded>();
+	else if (profile != NULL) resume<Profiled>();
+	else if (watch != NULL) resume<Watched>();
+	else resume<Silent>();
+	stepLimit = ~0ULL;
+	return status;
+}
+
+/* Continues from the current state with the fastest engine for the policy. Unlike run, nothing is booted and the caches are kept, so write mem through writeMem or restoreSnapshot (or call invalidateDecoded) */
+template <int AddrBits>
+template <class Trace>
+unsigned char ByteSyzedT<AddrBits>::resume(void) {
+	if (!Trace::enabled && !Trace::profiled && !Trace::recorded && !Trace::watched && translating) return resumeBlocks();
+	if (Trace::recorded) traceBegin(false);
+	unsigned char exitCode = execute<Trace, BYTESYZED_THREADED != 0>();
+	if (Trace::recorded) traceEnd();
+	output->flush();
+	return exitCode;
+}
+
+/* Starts a recorded run with the registers and memory, so the records after it can be followed. A run that picks up where the last recorded one stopped needs none */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::traceBegin(bool running) {
+	if (!running && traceSteps == steps) return;
+	TraceRecord & record = trace->next();
+	memset(&record, 0, sizeof(record));
+	record.step = steps;
+	record.pc = regs[0xF];
+	record.flags = TraceRecord::segment;
+	record.bytes[0] = AddrBits;
+	record.bytes[1] = prompt;
+	record.bytes[2] = running;
+
+	/* Registers as 2 bytes each, little endian, then memory */
+	unsigned char state[2 * n_regs];
+	for (int index = 0; index < n_regs; ++index)
+		state[2 * index] = (unsigned char) regs[index], state[2 * index + 1] = (unsigned char)(regs[index] >> 8);
+	trace->write(state, sizeof(state));
+	trace->write(mem, n_mem);
+}
+
+/* Starts the record of an instruction just fetched. What it writes is filled in by traceFinish */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::traceStep(const Decoded * in) {
+	TraceRecord & record = trace->next();
+	record.step = steps - 1;
+	record.pc = regs[0xF];
+	for (int index = 0; index < maxLength; ++index)
+		record.bytes[index] = mem[(Word)(regs[0xF] + index)];
+	record.flags = 0;
+	record.reg = 0;
+	record.regValue = record.address = record.memValue = record.unused = 0;
+	if (in->opcode == 0x19 || in->opcode == 0x1A) record.address = regs[in->a]; /* The atomics may overwrite the register with their address */
+	traceRecord = &record;
+	traceIn = in;
+}
+
+/* Fills in the register and memory the last instruction wrote. Every instruction writes at most one of each, besides moving the stack pointer (which the reader works out) */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::traceFinish(void) {
+	TraceRecord & record = *traceRecord;
+	const Decoded * in = traceIn;
+	traceRecord = NULL;
+
+	switch (in->opcode & 0xF0) {
+		case 0x80: /* "pushA", the stack slot */
+			record.flags = TraceRecord::wroteMem | TraceRecord::wroteWord;
+			record.address = regs[0xE], record.memValue = readWord(regs[0xE]);
+			return;
+		case 0x90: /* "popA", the value popped ("popE" has moved past it since) */
+			record.flags = TraceRecord::wroteReg;
+			record.reg = in->a, record.regValue = (in->a == 0xE)? (Word)(regs[0xE] - addrBytes) : regs[in->a];
+			return;
+	}
+	switch (in->opcode) {
+		case 0x12: case 0x13: /* "mov AB", to mem[reg[A]] */
+			record.flags = TraceRecord::wroteMem;
+			record.address = (in->a == 0xF)? record.pc : regs[in->a]; /* The program counter has moved past it since */
+			record.memValue = mem[record.address];
+			return;
+		case 0xA2: case 0xAA: /* "add adr AB", "sub adr AB" */
+			record.flags = TraceRecord::wroteMem;
+			record.address = in->imm1, record.memValue = mem[in->imm1];
+			return;
+		case 0xC2: /* "call adr", the return address */
+			record.flags = TraceRecord::wroteMem | TraceRecord::wroteWord;
+			record.address = regs[0xE], record.memValue = readWord(regs[0xE]);
+			return;
+		case 0xC3: /* "ret", where it returned to */
+			record.flags = TraceRecord::wroteReg;
+			record.reg = 0xF, record.regValue = regs[0xF];
+			return;
+		case 0xE1: case 0xE3: case 0xE4: /* "getchar", "spawn adr", "join" */
+			record.flags = TraceRecord::wroteReg;
+			record.reg = 0x0, record.regValue = regs[0x0];
+			return;
+		case 0x19: /* "cas AB", what it found, and the byte whether it swapped or not (the decoder works out which) */
+			record.flags = TraceRecord::wroteReg | TraceRecord::wroteMem;
+			record.reg = 0x0, record.regValue = regs[0x0];
+			record.memValue = mem[record.address];
+			return;
+		case 0x1A: /* "xadd AB" */
+			record.flags = TraceRecord::wroteReg | TraceRecord::wroteMem;
+			record.reg = in->b, record.regValue = regs[in->b];
+			if (in->b == 0xF) record.regValue -= in->length; /* Moved past the instruction since */
+			record.memValue = mem[record.address];
+			return;
+		case 0x14: /* "mov AB val", both get the value */
+			record.flags = TraceRecord::wroteReg;
+			record.reg = in->a, record.regValue = in->imm1;
+			return;
+	}
+	if (registerFields(in->opcode) & writesA) {
+		record.flags = TraceRecord::wroteReg;
+		record.reg = in->a, record.regValue = regs[in->a];
+		if (in->a == 0xF && in->opcode != 0x0F) record.regValue -= in->length; /* Moved past the instruction since, only "movF val" jumps */
+	}
+}
+
+/* Finishes the record of the instruction the run stopped on, and hands everything to trace */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::traceEnd(void) {
+	if (traceRecord != NULL) {
+		if (status == faulted || status == waitingForInput) { /* Wrote nothing */
+			traceRecord->flags = (status == faulted)? TraceRecord::faulted : TraceRecord::waited;
+			traceRecord = NULL;
+		}
+		else traceFinish();
+	}
+	traceSteps = steps;
+	trace->flush();
+}
+
+/* Copies the machine state */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::saveSnapshot(Snapshot & snapshot) const {
+	memcpy(snapshot.regs, regs, sizeof(regs));
+	memcpy(snapshot.mem, mem, sizeof(mem));
+	snapshot.progStart = progStart;
+	snapshot.steps = steps;
+	snapshot.inputPosition = input->tell();
+}
+
+/* Puts a saved state back. Memory is compared first, so restoring over a machine that only changed its data keeps every decoded instruction and block */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::restoreSnapshot(const Snapshot & snapshot) {
+	memset(dirty, 1, sizeof(dirty)); /* Nothing is known about how memory got here, compare all of it */
+	resetTo(snapshot);
+}
+
+/*
+*	Puts back a snapshot the machine matched when its pages were last marked
+*	clean. Pages no store touched since are skipped without a look, a dirty
+*	page is compared whole first (most are written back with the value they
+*	started with, a loop counter or a stack slot), and only bytes that
+*	differ are written, so the caches stay for code that did not change.
+*/
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::resetTo(const Snapshot & snapshot) {
+	memcpy(regs, snapshot.regs, sizeof(regs));
+	for (int page = 0; page < n_dirty; ++page) {
+		if (!dirty[page]) continue;
+		const int first = page << dirtyShift, last = first + (1 << dirtyShift);
+		if (memcmp(mem + first, snapshot.mem + first, 1 << dirtyShift) == 0) continue;
+		for (int index = first; index < last; ++index) {
+			if (mem[index] != snapshot.mem[index]) writeMem(index, snapshot.mem[index]);
+		}
+	}
+	clearDirty();
+	progStart = snapshot.progStart;
+	steps = snapshot.steps;
+	traceSteps = ~0ULL;
+	if (snapshot.inputPosition >= 0) input->seek(snapshot.inputPosition);
+}
+
+/* Marks every page clean, once memory matches a snapshot */
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::clearDirty(void) {
+	memset(dirty, 0, sizeof(dirty));
+}
+
 /* Zeroes out memory. */
-void ByteSyzed::wipeMemory(void) {
-	/* Iterate through memory and set to zero */
-	for (int index = 0; index < sizeof(mem)/sizeof(unsigned char); ++index) {
-		mem[index] = 0;
+template <int AddrBits>
+void ByteSyzedT<AddrBits>::wipeMemory(void) {
+	memset(mem, 0, sizeof(mem));
+	memset(regs, 0, sizeof(regs));
+	invalidateDecoded();
+}
+
+/* A whole file in memory. Files that fit in local are read into it, larger ones are mapped (a mapping costs more than a read of a few kilobytes) */
+struct FileBytes {
+	const char * bytes;
+	size_t size;
+	bool mapped; /* bytes is an mmap (or a malloc without mmap), not local */
+	char local[8192];
+};
+
+/* Reads or maps a whole file. Returns false (and prints why) if it cannot */
+static bool openFileBytes(const char * fileName, FileBytes & file, EmulatorOutput * output) {
+	file.bytes = NULL, file.size = 0, file.mapped = false;
+#if defined(_WIN32)
+	FILE * stream = fopen(fileName, "rb");
+	if (stream == NULL) {
+		output->print("Can't open %s. Unable to load.\n", fileName);
+		return false;
+	}
+	fseek(stream, 0, SEEK_END);
+	long size = ftell(stream);
+	fseek(stream, 0, SEEK_SET);
+	char * bytes = (size <= (long) sizeof(file.local))? file.local : (char *) malloc(size);
+	file.mapped = (bytes != file.local);
+	file.size = fread(bytes, 1, size, stream);
+	file.bytes = bytes;
+	fclose(stream);
+#else
+	int descriptor = open(fileName, O_RDONLY);
+	if (descriptor < 0) {
+		output->print("Can't open %s. Unable to load.\n", fileName);
+		return false;
 	}
 
-	/* Iterate through registers and set to zero */
-	for (int index = 0; index < sizeof(regs)/sizeof(unsigned char); ++index) {
-		regs[index] = 0;
+	/* One read usually gets all of a small file. If it filled local, the file may be bigger, map it */
+	ssize_t count = read(descriptor, file.local, sizeof(file.local));
+	if (0 <= count && count < (ssize_t) sizeof(file.local)) {
+		file.bytes = file.local, file.size = count;
+	} else {
+		struct stat status;
+		if (fstat(descriptor, &status) == 0) {
+			void * mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (mapping != MAP_FAILED) file.bytes = (const char *) mapping, file.size = status.st_size, file.mapped = true;
+		}
 	}
+	close(descriptor); /* A mapping stays valid */
+
+	if (file.bytes == NULL) {
+		output->print("Can't read %s. Unable to load.\n", fileName);
+		return false;
+	}
+#endif
+	return true;
 }
 
-/* Load from file. Returns false if it fails to load from file. */
-bool ByteSyzed::loadFromFile(const char * inputFileName) {
-	/* File pointer */
-	FILE * file = fopen(inputFileName, "r");
+/* Undoes openFileBytes */
+static void closeFileBytes(FileBytes & file) {
+	if (!file.mapped) return;
+#if defined(_WIN32)
+	free((void *) file.bytes);
+#else
+	munmap((void *) file.bytes, file.size);
+#endif
+}
+
+/* Reads one integer the way scanf's "%i" does: optional sign, then 0x hex, 0 octal or decimal. Returns false if there is none */
+static bool readInteger(const char * & text, const char * end, int & value) {
+	const char * at = text;
+	bool negative = false;
+	if (at < end && (*at == '+' || *at == '-')) negative = (*at++ == '-');
+
+	int base = 10;
+	bool prefix = false; /* "0x" on its own still reads as 0 */
+	if (at < end && *at == '0') {
+		base = 8;
+		if (at + 1 < end && (at[1] == 'x' || at[1] == 'X')) base = 16, at += 2, prefix = true;
+	}
+
+	const char * digits = at;
+	unsigned long long number = 0;
+	for (; at < end; ++at) {
+		int digit;
+		if ('0' <= *at && *at <= '9') digit = *at - '0';
+		else if ('a' <= *at && *at <= 'f') digit = *at - 'a' + 10;
+		else if ('A' <= *at && *at <= 'F') digit = *at - 'A' + 10;
+		else break;
+		if (digit >= base) break;
+		if (number <= 0x7FFFFFFFFFFFFFFFULL) number = number * base + digit; /* Past long it only has to saturate */
+	}
+	if (at == digits && !prefix) return false;
+
+	/* Saturates like strtol, then wraps into an int like scanf */
+	if (number > 0x7FFFFFFFFFFFFFFFULL) number = negative? 0x8000000000000000ULL : 0x7FFFFFFFFFFFFFFFULL;
+	value = (int)(negative? 0 - number : number);
+	text = at;
+	return true;
+}
+
+/* Reads up to 4 integers from a line, returning what sscanf("%i %i %i %i") would: how many, or -1 for a blank line */
+static int readLine(const char * text, const char * end, int val[4]) {
+	int n = 0;
+	for (; n < 4; ++n) {
+		while (text < end && isspace((unsigned char) *text)) ++text;
+		if (text == end) return (n == 0)? -1 : n;
+		if (!readInteger(text, end, val[n])) break;
+	}
+	return n;
+}
+
+/* Load from file. Returns false if it fails to load from file. Binary images (see saveImage) are recognized by their magic number. */
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::loadFromFile(const char * inputFileName) {
+	/* The whole file */
+	FileBytes file;
 
 	/* If the file exists */
-	if (file == NULL) {
-		printf("Can't open %s. Unable to load.\n", inputFileName);
+	if (!openFileBytes(inputFileName, file, output)) {
 		return false;
 	} else {
-		if (loadVerbose) printf("Opened %s\n", inputFileName);
+		if (loadVerbose) output->print("Opened %s\n", inputFileName);
+	}
+
+	if (file.size >= imageHeaderSize && memcmp(file.bytes, imageMagic, 4) == 0) {
+		bool loaded = loadFromImage((const unsigned char *) file.bytes, (int) file.size);
+		closeFileBytes(file);
+		return loaded;
 	}
 
-	char inLine[1024]; /* Line buffer */
 	int val[4]; /* Will hold the read numbers */
 	int n, loadCount=0; /* loadCount is the total number of instructions loaded */
+	bool loaded = true;
 
 	/* While reading valid info from file */
-	while (fgets(inLine, 1024, file) != NULL) {
-		/* n is the number of successful integers read from sscanf */
-		switch (n = sscanf(inLine, "%i %i %i %i", &val[0],&val[1],&val[2],&val[3])) {
+	for (const char * line = file.bytes, * end = file.bytes + file.size; line < end && loaded; ) {
+		/* Lines longer than 1023 characters come in pieces, as they did through fgets */
+		const char * limit = (end - line > 1023)? line + 1023 : end;
+		const char * next = (const char *) memchr(line, '\n', limit - line);
+		next = (next != NULL)? next + 1 : limit;
+
+		/* n is the number of successfully read integers */
+		switch (n = readLine(line, next, val)) {
 			case -1: /* In case of newline */
-				if (loadVerbose) printf("  Read newline.\n");
+				if (loadVerbose) output->print("  Read newline.\n");
 				break;
 			case 0: /* If no numbers were read */
-				if (loadVerbose) printf("  No instructions in line.\n");
+				if (loadVerbose) output->print("  No instructions in line.\n");
 				break;
-			case 1:	/* If numbers were successfully read */
-			case 2:
-			case 3:
-			case 4:
-				if (loadVerbose) printf("  Read %s", inLine);
+			default: /* If numbers were successfully read */
+				if (loadVerbose) output->print("  Read %.*s", (int)(next - line), line);
 				/* Load the n successfully read numbers */
 				for (int index = 0; index < n ; ++index) {
 					/* Check to see if the number read is outside of valid limits */
-					if (val[index] < 0 || val[index] >= sizeof(mem)/sizeof(unsigned char)) {
-						printf("  Error. Invalid value %i. Cannot fit into byte (Check input file).\n", val[index]);
-						return false;
+					if (val[index] < 0 || val[index] > 0xFF) {
+						output->print("  Error. Invalid value %i. Cannot fit into byte (Check input file).\n", val[index]);
+						loaded = false;
+						break;
 					}
 
 					/* Check the address to be loaded is within bounds of memory */ 
-					if (((int) progStart) + loadCount + index >= sizeof(mem)/sizeof(unsigned char)) {
-						printf("  Error. Starting at 0x%02X, the number of instructions loaded (%i) exceed maximum memory.\n", progStart, ((int) progStart)+loadCount+index);
-						return false;
+					if (((int) progStart) + loadCount + index >= n_mem) {
+						output->print("  Error. Starting at 0x%02X, the number of instructions loaded (%i) exceed maximum memory.\n", progStart, ((int) progStart)+loadCount+index);
+						loaded = false;
+						break;
 					}
 
 					/* Load the value into the ByteSyzed CPU */
 					mem[progStart + loadCount + index]=((char)(val[index]));
-					if (loadVerbose) printf("    Loaded 0x%02X to mem[0x%02X].\n",val[index], progStart + loadCount + index);
+					if (loadVerbose) output->print("    Loaded 0x%02X to mem[0x%02X].\n",val[index], progStart + loadCount + index);
 				}
 
 				/* Update the load count */
 				loadCount += n;
 				break;
-			default: /* I don't know how you can get here */
-				printf("Error. sscanf returned n = %i\n", n);
-				return false;
 			}
+
+		line = next;
 	}
 
-	if (loadVerbose) printf("Instructions loaded.\n\n");
+	closeFileBytes(file);
+	if (!loaded) return false;
 
-	fclose(file);
+	if (loadVerbose) output->print("Instructions loaded.\n\n");
+	loadedFirst = progStart;
+	loadedCount = loadCount;
+
+	invalidateDecoded();
 	return true;
-}
\ No newline at end of file
+}
+
+/*
+*	Binary image layout (multi-byte fields little endian):
+*	  0  magic "BSZ" and format version 1
+*	  4  flags: imageHasRegs, imageHasChecksum
+*	  5  load address of the first program byte (its low byte)
+*	  6  entry point, becomes progStart (the starting program counter, its low byte)
+*	  7  address bits of the machine, 0 for the 8 bit one
+*	  8  number of program bytes (2 bytes)
+*	  10 high byte of the load address, 0 for the 8 bit machine
+*	  11 high byte of the entry point, 0 for the 8 bit machine
+*	  12 registers, 16 of addrBytes bytes each, if imageHasRegs (0xE and 0xF are still set by boot)
+*	  .. CRC-32 of the registers and program bytes, 4 bytes, if imageHasChecksum
+*	  .. program bytes
+*/
+template <int AddrBits>
+const char ByteSyzedT<AddrBits>::imageMagic[4] = {'B', 'S', 'Z', 1};
+
+/* CRC-32 (the zip/PNG one), bit by bit since images are at most a few hundred bytes */
+static unsigned int crc32(unsigned int crc, const unsigned char * bytes, int count) {
+	crc = ~crc;
+	for (int index = 0; index < count; ++index) {
+		crc ^= bytes[index];
+		for (int bit = 0; bit < 8; ++bit)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+/* Loads a binary image held in memory. Returns false if it is not a valid image. */
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::loadFromImage(const unsigned char * image, int size) {
+	if (size < imageHeaderSize || memcmp(image, imageMagic, 4) != 0) {
+		output->print("Error. Not a ByteSyzed image.\n");
+		return false;
+	}
+
+	int bits = (image[7] != 0)? image[7] : 8;
+	if (bits != AddrBits) {
+		output->print("Error. Image is for a %i bit machine, this one is %i bit.\n", bits, AddrBits);
+		return false;
+	}
+
+	unsigned char flags = image[4];
+	int load = image[5] | (image[10] << 8), entry = image[6] | (image[11] << 8);
+	int count = image[8] | (image[9] << 8);
+	int regsSize = (flags & imageHasRegs)? n_regs * addrBytes : 0;
+	int checksumSize = (flags & imageHasChecksum)? 4 : 0;
+	const unsigned char * body = image + imageHeaderSize; /* Registers, then the program */
+	const unsigned char * program = body + regsSize + checksumSize;
+
+	if (size < imageHeaderSize + regsSize + checksumSize + count) {
+		output->print("Error. Image is cut short.\n");
+		return false;
+	}
+	if (load + count > n_mem) {
+		output->print("Error. Starting at 0x%02X, the number of instructions loaded (%i) exceed maximum memory.\n", load, load + count);
+		return false;
+	}
+	if (entry >= n_mem) {
+		output->print("Error. Entry point 0x%02X is past the end of memory.\n", entry);
+		return false;
+	}
+	if (checksumSize) {
+		const unsigned char * stored = body + regsSize;
+		unsigned int expected = stored[0] | (stored[1] << 8) | (stored[2] << 16) | ((unsigned int) stored[3] << 24);
+		if (crc32(crc32(0, body, regsSize), program, count) != expected) {
+			output->print("Error. Image checksum does not match.\n");
+			return false;
+		}
+	}
+
+	memcpy(mem + load, program, count);
+	for (int index = 0; index < regsSize; ++index) {
+		if (index % addrBytes == 0) regs[index / addrBytes] = 0;
+		regs[index / addrBytes] |= (Word)(body[index] << (8 * (index % addrBytes)));
+	}
+	progStart = entry;
+	loadedFirst = (Word) load;
+	loadedCount = count;
+	if (loadVerbose) output->print("Loaded image of %i bytes to mem[0x%02X], entry point 0x%02X.\n\n", count, load, entry);
+
+	invalidateDecoded();
+	return true;
+}
+
+/* Saves count bytes of memory from first as a binary image, with progStart as the entry point. Returns false if it cannot write the file. */
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::saveImage(const char * fileName, Word first, int count, bool withRegs) {
+	if (count < 0 || count > 0xFFFF || first + count > n_mem) {
+		output->print("Error. Image of %i bytes from 0x%02X does not fit in memory.\n", count, first);
+		return false;
+	}
+
+	unsigned char header[imageHeaderSize] = {0};
+	memcpy(header, imageMagic, 4);
+	header[4] = imageHasChecksum | (withRegs? imageHasRegs : 0);
+	header[5] = first & 0xFF;
+	header[6] = progStart & 0xFF;
+	header[7] = (AddrBits != 8)? AddrBits : 0;
+	header[8] = count & 0xFF, header[9] = count >> 8;
+	header[10] = first >> 8, header[11] = progStart >> 8;
+
+	/* Registers little endian, so the image reads the same on any host */
+	unsigned char regBytes[n_regs * addrBytes];
+	for (int index = 0; index < n_regs * addrBytes; ++index)
+		regBytes[index] = (unsigned char)(regs[index / addrBytes] >> (8 * (index % addrBytes)));
+
+	unsigned int crc = crc32(crc32(0, regBytes, withRegs? sizeof(regBytes) : 0), mem + first, count);
+	unsigned char checksum[4] = {(unsigned char) crc, (unsigned char)(crc >> 8), (unsigned char)(crc >> 16), (unsigned char)(crc >> 24)};
+
+	FILE * file = fopen(fileName, "wb");
+	if (file == NULL) {
+		output->print("Can't open %s. Unable to save.\n", fileName);
+		return false;
+	}
+	fwrite(header, 1, sizeof(header), file);
+	if (withRegs) fwrite(regBytes, 1, sizeof(regBytes), file);
+	fwrite(checksum, 1, sizeof(checksum), file);
+	fwrite(mem + first, 1, count, file);
+	return fclose(file) == 0;
+}
+
+/* Loads a byte image at progStart. Returns false if it does not fit in memory. */
+template <int AddrBits>
+bool ByteSyzedT<AddrBits>::loadFromMemory(const unsigned char * image, int count) {
+	if (count < 0 || ((int) progStart) + count > n_mem) {
+		output->print("Error. Image of %i bytes does not fit at 0x%02X.\n", count, progStart);
+		return false;
+	}
+
+	for (int index = 0; index < count; ++index)
+		mem[progStart + index] = image[index];
+	loadedFirst = progStart;
+	loadedCount = count;
+
+	invalidateDecoded();
+	return true;
+}
+
+/* Every address width there is, with the three trace policies, is built here */
+#if BYTESYZED_THREADED
+#define INSTANTIATE_THREADED(Machine, Trace) template unsigned char Machine::runThreaded<Machine::Trace>(void);
+#else
+#define INSTANTIATE_THREADED(Machine, Trace)
+#endif
+#define INSTANTIATE(Machine, Trace) \
+	template unsigned char Machine::runSwitch<Machine::Trace>(void); \
+	template unsigned char Machine::resume<Machine::Trace>(void); \
+	INSTANTIATE_THREADED(Machine, Trace)
+INSTANTIATE(ByteSyzedT<8>, Silent)
+INSTANTIATE(ByteSyzedT<8>, Verbose)
+INSTANTIATE(ByteSyzedT<8>, Profiled)
+INSTANTIATE(ByteSyzedT<8>, Recorded)
+INSTANTIATE(ByteSyzedT<8>, Watched)
+INSTANTIATE(ByteSyzedT<16>, Silent)
+INSTANTIATE(ByteSyzedT<16>, Verbose)
+INSTANTIATE(ByteSyzedT<16>, Profiled)
+INSTANTIATE(ByteSyzedT<16>, Recorded)
+INSTANTIATE(ByteSyzedT<16>, Watched)
+
+/* GCC calls an explicit instantiation of run<Trace> ambiguous next to the plain run(), so those are built by taking their addresses */
+#define INSTANTIATE_RUN(Machine, name) \
+	extern unsigned char (Machine::* const name[5])(void); \
+	unsigned char (Machine::* const name[5])(void) = {&Machine::run<Machine::Silent>, &Machine::run<Machine::Verbose>, &Machine::run<Machine::Profiled>, &Machine::run<Machine::Recorded>, \
+		&Machine::run<Machine::Watched>};
+INSTANTIATE_RUN(ByteSyzedT<8>, runPolicies8)
+INSTANTIATE_RUN(ByteSyzedT<16>, runPolicies16)
+
+template class ByteSyzedT<8>;
+template class ByteSyzedT<16>;
\ No newline at end of file
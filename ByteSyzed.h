@@ -8,34 +8,400 @@
 *
 *	Written by Charles Emerson (cjemerson AT alaska.edu)
 *	Created: 10/1/2017
-*	Last Edited: 10/1/2017
+*	Last Edited: 10/17/2026
 */
 
 #ifndef BYTESYZED_H
 #define BYTESYZED_H
 
 #include <stdio.h>
+#include <string>
+#include <vector>
 
-/* Base on Lawlor's tiny CPU class */
-class ByteSyzed {
+/* The threaded engine needs the GCC/Clang "labels as values" extension. Build with -DBYTESYZED_THREADED=0 to use the switch engine only. */
+#ifndef BYTESYZED_THREADED
+#if defined(__GNUC__)
+#define BYTESYZED_THREADED 1
+#else
+#define BYTESYZED_THREADED 0
+#endif
+#endif
+
+/* Where the emulator writes: program output, traces, dumps and messages. Bytes gather in a buffer and are handed to drain in large pieces */
+class EmulatorOutput {
+public:
+	virtual ~EmulatorOutput() {}
+	void put(char byte) { if (used == bufferSize) flush(); buffer[used++] = byte; } /* One byte, e.g. putchar */
+	void write(const char * bytes, size_t count); /* Several bytes */
+	void print(const char * format, ...); /* printf into the buffer */
+	void flush(void) { drain(buffer, used); used = 0; } /* Hands over everything buffered */
+
+protected:
+	virtual void drain(const char * bytes, size_t count) = 0; /* Takes a full buffer, or whatever is left on flush */
+
+private:
+	enum {bufferSize=16384};
+	char buffer[bufferSize];
+	size_t used = 0;
+};
+
+/* Buffered output to a FILE, stdout by default */
+class FileOutput : public EmulatorOutput {
+public:
+	FILE * file;
+	explicit FileOutput(FILE * file = stdout) : file(file) {}
+	~FileOutput() { flush(); }
+
+protected:
+	void drain(const char * bytes, size_t count);
+};
+
+/* Output kept in memory, e.g. for tests or the batch runner */
+class MemoryOutput : public EmulatorOutput {
+public:
+	~MemoryOutput() {}
+	const std::string & text(void) { flush(); return buffered; } /* Everything written so far */
+	void clear(void) { flush(); buffered.clear(); }
+
+protected:
+	void drain(const char * bytes, size_t count) { buffered.append(bytes, count); }
+
+private:
+	std::string buffered;
+};
+
+/* Where getchar reads from */
+class EmulatorInput {
 public:
+	virtual ~EmulatorInput() {}
+	virtual bool read(int & value) = 0; /* Next number, false once there are none */
+	virtual bool ready(void) { return true; } /* False if read would have to wait for a number that is not there yet. getchar then suspends the machine (waitingForInput) */
+	virtual long tell(void) { return -1; } /* Where reading is, for snapshots. -1 if it can't be told */
+	virtual bool seek(long /* position */) { return false; } /* Goes back (or forward) to a position from tell */
+};
+
+/* Numbers typed on (or piped into) a FILE, stdin by default */
+class FileInput : public EmulatorInput {
+public:
+	FILE * file;
+	explicit FileInput(FILE * file = stdin) : file(file) {}
+	bool read(int & value) { return fscanf(file, "%i", &value) == 1; }
+	long tell(void) { return ftell(file); } /* -1 on a pipe or terminal */
+	bool seek(long position) { return fseek(file, position, SEEK_SET) == 0; }
+};
+
+/* Numbers supplied up front, so a program can run without a terminal */
+class QueueInput : public EmulatorInput {
+public:
+	std::vector<int> values; /* Read front first */
+	size_t next = 0; /* Next one to read */
+	bool waits = false; /* If set, more numbers are coming: an empty queue is not ready, instead of reading 0 */
+	void push(int value) { values.push_back(value); }
+	void push(const char * text); /* Queues every number in text, whitespace separated (decimal, 0x hex or 0 octal) */
+	void clear(void) { values.clear(), next = 0; }
+	bool read(int & value) {
+		if (next == values.size()) return false;
+		value = values[next++];
+		return true;
+	}
+	bool ready(void) { return !waits || next < values.size(); }
+	long tell(void) { return (long) next; }
+	bool seek(long position) {
+		if (position < 0 || position > (long) values.size()) return false;
+		next = position;
+		return true;
+	}
+};
+
+/*
+*	One instruction of a recorded run (see ByteSyzedT::Recorded): where it
+*	was, its bytes, and the register and memory cell it wrote, so the run
+*	can be followed without formatting anything while it runs. Tracer.h
+*	writes them to a file and turns them back into the verbose trace.
+*/
+struct TraceRecord {
+	unsigned long long step; /* Instructions executed before this one */
+	unsigned short pc; /* Address of the instruction */
+	unsigned char bytes[4]; /* Opcode and operand bytes, as fetched */
+	unsigned char flags; /* What it wrote, and how it ended */
+	unsigned char reg; /* Register written, with wroteReg */
+	unsigned short regValue; /* Value it got */
+	unsigned short address; /* Memory written, with wroteMem */
+	unsigned short memValue; /* Byte it got (with wroteWord, the stack slot starting there) */
+	unsigned short unused;
+	enum {wroteReg=1, wroteMem=2, wroteWord=4, faulted=8, waited=16, /* Faulted, or waited for input and runs again */
+		segment=0x80}; /* Not an instruction: the machine state follows, see Tracer.cpp */
+};
+
+/* Where recorded runs put their trace. Records gather in a buffer and are handed to drain in large pieces */
+class TraceOutput {
+public:
+	virtual ~TraceOutput() {}
+	TraceRecord & next(void) { if (used == bufferSize) flush(); return buffer[used++]; } /* Room for one more record */
+	void write(const void * bytes, size_t count) { flush(); drain((const char *) bytes, count); } /* Bytes that are not records, after the records so far */
+	void flush(void) { if (used != 0) drain((const char *) buffer, used * sizeof(TraceRecord)); used = 0; } /* Hands over every record buffered */
+
+protected:
+	virtual void drain(const char * bytes, size_t count) = 0; /* Takes a full buffer, or whatever is left on flush */
+
+private:
+	enum {bufferSize=2048}; /* Records, 48 KiB */
+	TraceRecord buffer[bufferSize];
+	size_t used = 0;
+};
+
+extern FileOutput standardOutput; /* Buffered stdout, where every instance writes unless told otherwise */
+extern FileInput standardInput; /* stdin */
+
+/* Types that grow with the address width. Registers hold an address, so they are as wide as one */
+template <int AddrBits> struct ByteSyzedTypes;
+template <> struct ByteSyzedTypes<8> {
+	typedef unsigned char Word; /* A register, an address */
+	typedef unsigned short OpIndex; /* Index into blockOps */
+	typedef short Link; /* Block entry address, or -1 */
+};
+template <> struct ByteSyzedTypes<16> {
+	typedef unsigned short Word;
+	typedef unsigned int OpIndex;
+	typedef int Link;
+};
+
+/*
+*	Base on Lawlor's tiny CPU class. AddrBits is the address width: memory
+*	holds 2^AddrBits bytes and registers are AddrBits wide. Address operands
+*	(jumps, calls and the mem[adr] forms) take AddrBits/8 bytes, little
+*	endian, and the stack holds whole registers. ByteSyzedT<8> is the
+*	original 256 byte machine, every encoding unchanged.
+*/
+template <int AddrBits>
+class ByteSyzedT {
+public:
+	typedef typename ByteSyzedTypes<AddrBits>::Word Word;
+	enum {addrBits=AddrBits, addrBytes=AddrBits / 8}; /* Bytes in an address operand and a stack slot */
 	enum {n_regs=16};
-	unsigned char regs[n_regs]; /* "registers" -- temporary working space of machine */
-	enum {n_mem=256};
+	Word regs[n_regs]; /* "registers" -- temporary working space of machine */
+	enum {n_mem=1 << AddrBits};
 	unsigned char mem[n_mem]; /* "memory"-- program memory and potentially hard coded values */
 
-	unsigned char progStart = 0x00;
+	/* Predecoded instruction, built the first time its address is executed */
+	struct Decoded {
+		unsigned char length; /* Instruction length in bytes. 0 means not decoded (yet) */
+		unsigned char opcode; /* Selects the handler */
+		unsigned char a, b; /* Register (or nibble) operands */
+		Word imm1, imm2; /* Immediate or address operands */
+		unsigned char next1, next2; /* Raw bytes following the opcode (for the trace) */
+	};
+	Decoded decoded[n_mem]; /* Predecode cache, one entry per memory address */
+	bool cached = true; /* Something may be decoded or translated. invalidateDecoded skips emptying the caches while it is clear */
+	bool translating = true; /* Silent runs use the basic block engine. Clear it for code that changes between short runs, which the instruction engine only decodes again where it changed */
+	static const unsigned char opcodeLength[256]; /* Instruction length by opcode with 8 bit addresses, 0 if invalid */
+	static int instructionLength(unsigned char opcode) { /* Instruction length at this address width, 0 if invalid */
+		return opcodeLength[opcode] + ((opcodeLength[opcode] != 0 && takesAddress(opcode))? addrBytes - 1 : 0);
+	}
+	static bool takesAddress(unsigned char opcode) { /* Has an adr operand */
+		return (0x70 <= opcode && opcode <= 0x76) || opcode == 0xA1 || opcode == 0xA2 || opcode == 0xA8 || opcode == 0xA9 || opcode == 0xAA || opcode == 0xC2 || opcode == 0xE3;
+	}
+	enum {maxLength=4}; /* Longest instruction, "lea AB val1 val2" and the conditional jumps with 16 bit addresses */
+	enum {readsA=1, readsB=2, writesA=4, writesB=8, showsRegs=16}; /* Bits of registerFields */
+	static int registerFields(unsigned char opcode); /* How an opcode uses its A and B fields. Pushes, pops, call and ret also move regs[0xE], which is not counted */
+
+	/* Micro-op of a translated basic block. kind is the opcode, or one of the kinds below */
+	struct MicroOp {
+		unsigned char kind;
+		unsigned char a, b; /* Register (or nibble) operands */
+		Word imm1, imm2; /* Immediate or address operands, folded constants */
+		Word pc; /* Address of the instruction it came from */
+		unsigned char length; /* Length of that instruction */
+		unsigned char step; /* Instructions of the block finished once this one is */
+	};
+	enum { /* Micro-op kinds, numbered in unused opcode space */
+		uMovImm = 0x60, /* regs[a] = imm1 (movA, mov AB val, pco and lea fold into this) */
+		uAddImm = 0x61, /* regs[a] += imm1 (inc and dec fold into this) */
+		uSyncPC = 0x62, /* regs[0xF] = pc, before an instruction that reads the program counter */
+		uFallThrough = 0x63, /* Block ends without a branch, continues at pc */
+		uJumpReg = 0x64, /* Block ends after writing the program counter, continues at regs[0xF] + imm1 */
+		uInvalid = 0x65 /* Invalid opcode */
+	};
+
+	/* Basic block, cached by entry address. Ends at a jump, skip, call, ret, exit or a write to the program counter */
+	struct Block {
+		typename ByteSyzedTypes<AddrBits>::OpIndex first; /* First micro-op in blockOps */
+		unsigned char count; /* Number of micro-ops, 0 means not translated (yet) */
+		unsigned char steps; /* Instructions in the block, when it runs to its end */
+		typename ByteSyzedTypes<AddrBits>::Link next[2]; /* Linked successors (fall through, taken) by entry address, -1 until first taken */
+	};
+	enum {n_blockOps=4 * n_mem, maxBlockInstructions=64};
+	Block blocks[n_mem]; /* Block cache, one entry per entry address */
+	MicroOp blockOps[n_blockOps]; /* Micro-ops of every cached block */
+	typename ByteSyzedTypes<AddrBits>::OpIndex blockOpsUsed;
+	unsigned char codeMap[n_mem]; /* Nonzero where a byte was translated into a block */
+	unsigned char blockFlushes; /* Bumped on every flushBlocks, so a running block can tell it is gone */
+
+	/* Memory pages written since the last clearDirty, so a reset compares those and no others */
+	enum {dirtyShift=(AddrBits > 8)? 8 : 5, n_dirty=n_mem >> dirtyShift};
+	unsigned char dirty[n_dirty]; /* Nonzero where a page may differ. invalidateDecoded marks every page */
+
+	/* Execution counts gathered by profiled runs. Counts add up over runs until clear */
+	struct Profile {
+		unsigned long long executed[n_mem]; /* Instructions executed at each address */
+		unsigned long long opcodes[256]; /* Instructions executed by opcode */
+		unsigned long long taken[n_mem], notTaken[n_mem]; /* Conditional jumps and skips (0x71 to 0x78) by address */
+		unsigned long long calls[n_mem]; /* Calls by target address */
+		unsigned long long returns;
+		int depth, maxDepth; /* Call depth during the last run, and the deepest it got */
+
+		void clear(void); /* Zeroes every count */
+		void report(EmulatorOutput & out, const unsigned char * mem) const; /* Prints tables, mem gives the bytes at each address */
+		bool save(const char * fileName) const; /* Writes every nonzero count as CSV */
+	};
+	Profile * profile = NULL; /* Where profiled runs count. Must be set for run<Profiled>() */
+
+	/* Watchpoints, an access heatmap and the stack high-water mark, gathered by watched runs until clear. Allocate with new at 16 bits, about 1.6 MB */
+	struct Watch {
+		enum {read=1, write=2, execute=4, counted=8}; /* Bits of points. counted is on everywhere while the heatmap is */
+		enum {maxEvents=1024};
+
+		/* A watchpoint hit, taken before the instruction runs */
+		struct Event {
+			unsigned long long step; /* Steps counting the instruction */
+			Word pc; /* Instruction that made the access */
+			Word address;
+			unsigned char kind; /* read, write or execute */
+			unsigned char value; /* mem[address] before the instruction */
+		};
+
+		unsigned char points[n_mem]; /* What raises an event at each address, and counted */
+		bool stop = false; /* Stops the run at the first event, before the instruction, with watchHit. Resuming runs it without stopping again */
+		std::vector<Event> events; /* The first maxEvents hits */
+		unsigned long long lost; /* Hits past maxEvents */
+		unsigned long long reads[n_mem], writes[n_mem], executes[n_mem]; /* Heatmap, of counted addresses */
+		Word stackLowest; /* Lowest address the stack reached, the high-water mark of regs[0xE] */
+		unsigned long long held; /* Step of the instruction that stopped the run, it raises nothing when resumed */
+
+		Watch() { clear(); }
+		void clear(void); /* Removes every watchpoint, event and count */
+		void watch(Word first, Word last, int kinds); /* Raises events on kinds (read, write, execute) of access to first..last */
+		void heatmap(bool on); /* Counts accesses to every address (an instruction fetch is one execute, at its first byte) */
+		void report(EmulatorOutput & out, Word programFirst, Word programLast) const; /* Prints events, heatmap and the stack against the program */
+		bool save(const char * fileName, Word programFirst, Word programLast) const; /* The same as CSV */
+	};
+	Watch * watch = NULL; /* Where watched runs look up and count accesses. Must be set for run<Watched>() */
+	bool watchStep(const Decoded * in); /* Checks the accesses of the instruction about to run. True if it should stop first */
+
+	/* Machine state, to rerun or fork a machine without loading it again */
+	struct Snapshot {
+		Word regs[n_regs];
+		unsigned char mem[n_mem];
+		Word progStart;
+		unsigned long long steps;
+		long inputPosition; /* input->tell() when saved, -1 if the input can't tell */
+	};
+
+	Word progStart = 0x00;
 	bool prompt = true; /* Prints "Enter value: " prompt for getchar*/
 	bool verbose = true; /* Prints out summary of the instruction executed */
 	bool loadVerbose = false; /* Prints out a summary of the loadFromFile. Generally leave false, this gets annoying.  */
+	int loadedCount = 0; /* Number of bytes the last load put into memory */
+	Word loadedFirst = 0x00; /* Where the last load put its first byte. progStart unless an image loads away from its entry point */
+	unsigned long long steps = 0; /* Number of instructions executed by the last run */
+
+	/* Why the last run or step stopped, named like the lockstep engine's */
+	enum Status {
+		running, /* Not stopped yet */
+		exited, /* exit (0xEE) */
+		faulted, /* Invalid opcode or stack fault */
+		outOfSteps, /* Reached stepLimit. The program counter is at the next instruction */
+		waitingForInput, /* getchar found input not ready. The program counter is at the getchar, which runs again on the next step */
+		watchHit /* A watchpoint was hit with Watch::stop set. The program counter is at the instruction, which has not run */
+	};
+	Status status = running;
+	unsigned long long stepLimit = ~0ULL; /* Engines stop with outOfSteps once steps reaches it. Set by step() */
+	EmulatorOutput * output = &standardOutput; /* Where program output, dumps and messages go. Flushed when a run ends and before getchar */
+	EmulatorInput * input = &standardInput; /* Where getchar reads from. No more input reads as 0 */
+	const char * dumpFileName = "debug.txt"; /* Written by fileDump. NULL disables fileDump */
+	EmulatorOutput * dumpOutput = NULL; /* If set, fileDump writes here instead of dumpFileName */
+	TraceOutput * trace = NULL; /* Where recorded runs write their trace. Set, run() and step() record unless verbose is set */
 	
-	unsigned char run(void); /* Executes the loaded program instructions */
+	/* Trace policies. The engines are built once per policy, so a silent run has no tracing or profiling in it at all. */
+	struct Silent { enum { enabled = false, profiled = false, recorded = false, watched = false }; };
+	struct Verbose { enum { enabled = true, profiled = false, recorded = false, watched = false }; }; /* Prints out summary of the instruction executed */
+	struct Profiled { enum { enabled = false, profiled = true, recorded = false, watched = false }; }; /* Counts into profile */
+	struct Recorded { enum { enabled = false, profiled = false, recorded = true, watched = false }; }; /* Writes a TraceRecord per instruction into trace */
+	struct Watched { enum { enabled = false, profiled = false, recorded = false, watched = true }; }; /* Looks every memory access up in watch */
+
+	unsigned char run(void); /* Executes the loaded program instructions, Verbose if verbose is set, else Recorded if trace is set, else Profiled if profile is set, else Watched if watch is set */
+	template <class Trace> unsigned char run(void); /* Executes with the given trace policy */
+	template <class Trace> unsigned char runSwitch(void); /* Executes using the portable switch engine */
+#if BYTESYZED_THREADED
+	template <class Trace> unsigned char runThreaded(void); /* Executes using the computed goto engine */
+#endif
+	void boot(void); /* Sets up the program counter and stack pointer for a run */
+	template <class Trace, bool Threaded> unsigned char execute(void); /* Engine loop, runs from the current program counter */
+	unsigned char runBlocks(void); /* Executes using the basic block engine (silent only) */
+	Status run(unsigned long long maxSteps); /* Boots, then runs at most maxSteps instructions */
+	Status step(unsigned long long count); /* Continues for at most count more instructions, then stops until the next step. Picks the policy like run() */
+	template <class Trace> unsigned char resume(void); /* Continues from the current state, without booting or emptying the caches */
+	unsigned char resumeBlocks(void); /* Continues using the basic block engine */
+	void saveSnapshot(Snapshot & snapshot) const; /* Copies the machine state */
+	void restoreSnapshot(const Snapshot & snapshot); /* Puts a saved state back. Only bytes that differ are written, so cached code that did not change stays */
+	void resetTo(const Snapshot & snapshot); /* restoreSnapshot for a machine that matched snapshot at its last clearDirty. Only the dirty pages are compared */
+	void clearDirty(void); /* Marks every page clean, call once memory matches a snapshot */
 	void dump(unsigned char id); /* Print out memory and/or all registers. Has a disabled dump. */
-	void dumpMemRange(unsigned char first, unsigned char last); /* Prints a memory range */
-	void dumpRegs(unsigned char id); /* Prints an individual register or all registers */
+	void dumpMemRange(Word first, Word last); /* Prints a memory range */
+	void dumpRegs(Word id); /* Prints an individual register or all registers */
 	void fileDump(); /* File dump, for debugging suite */
 	void wipeMemory(void); /* Zeroes out memory and registers */
-	bool loadFromFile(const char * inputFileName); /* Loads from file */
+	bool loadFromFile(const char * inputFileName); /* Loads from file, text or binary image */
+	bool loadFromMemory(const unsigned char * image, int count); /* Loads a byte image */
+	bool loadFromImage(const unsigned char * image, int size); /* Loads a binary image (the file format saveImage writes) */
+	bool saveImage(const char * fileName, Word first, int count, bool withRegs = false); /* Saves memory as a binary image */
+
+	/* Binary image format, see ByteSyzed.cpp for the layout */
+	static const char imageMagic[4];
+	enum {imageHeaderSize=12, imageHasRegs=1, imageHasChecksum=2};
+
+	/* Recording. A run starts with the machine state, then each instruction finishes its record once the next one is fetched or the run stops */
+	TraceRecord * traceRecord = NULL; /* Record of the instruction being executed */
+	const Decoded * traceIn; /* That instruction */
+	unsigned long long traceSteps = ~0ULL; /* steps when the last recorded run stopped, ~0 once the state may have changed since */
+	void traceBegin(bool running); /* Writes the machine state, unless the trace already follows on from it. running is set when run() prints "Running..." */
+	void traceStep(const Decoded * in); /* Finishes the last record and starts one for in */
+	void traceFinish(void); /* Fills in what the instruction wrote, from the state it left */
+	void traceEnd(void); /* Finishes the last record and hands the trace over */
+
+	void decode(Word address); /* Fills the predecode cache entry of an address */
+	static void decodeBytes(const unsigned char * bytes, Decoded & in); /* Decodes an instruction from its (up to maxLength) bytes */
+	void invalidateDecoded(void); /* Empties the predecode and block caches. Call after writing to mem directly */
+	void translate(Word address); /* Translates the basic block starting at an address */
+	void flushBlocks(void); /* Empties the block cache */
+
+	/* Writes a byte to memory and drops the cached decodes and blocks that read that byte */
+	void writeMem(Word address, unsigned char value) {
+		mem[address] = value;
+		dirty[address >> dirtyShift] = 1;
+		for (int back = 0; back < maxLength; ++back)
+			decoded[(Word)(address - back)].length = 0;
+		if (codeMap[address]) flushBlocks(); /* Self-modifying code is rare, start over */
+	}
+
+	/* Stack slots and address operands, addrBytes little endian bytes */
+	Word readWord(Word address) const {
+		Word value = 0;
+		for (int index = 0; index < addrBytes; ++index)
+			value |= (Word)(mem[(Word)(address + index)] << (8 * index));
+		return value;
+	}
+	void writeWord(Word address, Word value) {
+		for (int index = 0; index < addrBytes; ++index)
+			writeMem(address + index, (unsigned char)(value >> (8 * index)));
+	}
 };
 
+typedef ByteSyzedT<8> ByteSyzed; /* The original 256 byte machine */
+typedef ByteSyzedT<16> ByteSyzed16; /* 64 KiB, 16 bit registers. About 5 MB with its caches, allocate it with new */
+
+/* Built once in ByteSyzed.cpp */
+extern template class ByteSyzedT<8>;
+extern template class ByteSyzedT<16>;
+
 #endif
\ No newline at end of file
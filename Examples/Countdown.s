@@ -0,0 +1,25 @@
+; Counts down from 9 to 0, then calls a function that prints a greeting.
+; Assemble with "assemble Countdown.s Countdown.bsz", the image loads at 0x10.
+
+count = 9
+
+	.org 0x10
+start:
+	mov r2, count		; Counter
+	mov r4, 0
+loop:
+	add r1, r2, '0'		; The digit, r1 = r2 + '0'
+	putchar
+	mov r1, ' '
+	putchar
+	je r2, r4, done
+	dec r2, 1
+	jmp loop
+done:
+	call greet
+	mov r0, 0
+	exit
+
+greet:
+	printstr "\nHello from the assembler!\n"
+	ret
\ No newline at end of file
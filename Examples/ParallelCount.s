@@ -0,0 +1,53 @@
+; Four cores add 1 to a shared counter 50 times each with xadd, then core 0
+; joins the others and exits with the counter, 200 (0xC8). Work that finds no
+; free core is done by core 0 itself, so the total is the same on any number
+; of cores. Assemble with "assemble ParallelCount.s ParallelCount.txt" and run
+; with "--cores 4 ParallelCount.txt".
+
+times = 50
+
+start:
+	mov r7, 0		; Zero, for the spawn checks
+	mov r1, 0xC0		; Stack of the first worker
+	spawn worker
+	jne r0, r7, second
+	call count		; No free core, count here
+second:
+	mov r1, 0xB0
+	spawn worker
+	jne r0, r7, third
+	call count
+third:
+	mov r1, 0xA0
+	spawn worker
+	jne r0, r7, wait
+	call count
+wait:
+	call count		; Core 0's own share
+	mov r1, 1
+	join
+	mov r1, 2
+	join
+	mov r1, 3
+	join
+	mov r2, counter
+	mov r0, [r2]
+	exit
+
+worker:
+	call count
+	exit
+
+count:				; Adds 1 to counter times times
+	mov r5, 0
+	mov r6, times
+	mov r2, counter
+loop:
+	mov r3, 1
+	xadd [r2], r3		; r3 = what counter was, no other core can add in between
+	inc r5, 1
+	jne r5, r6, loop
+	ret
+
+counter:
+	.byte 0
\ No newline at end of file
@@ -0,0 +1,215 @@
+/*	Journal.cpp
+*
+*	ByteSyzed Execution Journal Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Journal.h"
+#include <algorithm>
+#include <string.h>
+
+/* Runs a booted machine, recording, until it exits, faults, waits for input or has run maxSteps in all. Calling again continues */
+template <int AddrBits>
+typename JournalT<AddrBits>::Status JournalT<AddrBits>::record(Machine & cpu, unsigned long long maxSteps) {
+	EmulatorInput * original = cpu.input;
+	RecordingInput recording(original, inputs);
+	cpu.input = &recording;
+
+	if (checkpoints.empty()) {
+		checkpoints.push_back(Snapshot());
+		cpu.saveSnapshot(checkpoints.back());
+	}
+
+	/* Stepping stops at every multiple of interval to checkpoint. Step budgets are exact, so the run is the same as one without stops */
+	Status stopped;
+	do {
+		unsigned long long next = (cpu.steps / interval + 1) * interval;
+		stopped = cpu.step(std::min(next, maxSteps) - std::min(cpu.steps, maxSteps));
+		if (stopped == Machine::outOfSteps && cpu.steps == next) {
+			checkpoints.push_back(Snapshot());
+			cpu.saveSnapshot(checkpoints.back());
+		}
+	} while (stopped == Machine::outOfSteps && cpu.steps < maxSteps);
+
+	cpu.input = original;
+	status = stopped;
+	steps = cpu.steps;
+	return stopped;
+}
+
+/* Restores the last checkpoint at or before step and runs the rest of the way on the recorded numbers */
+template <int AddrBits>
+bool JournalT<AddrBits>::seek(Machine & cpu, QueueInput & replay, unsigned long long step) {
+	auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), step,
+		[](unsigned long long step, const Snapshot & checkpoint) { return step < checkpoint.steps; });
+	if (after == checkpoints.begin()) return false;
+	const Snapshot & from = *(after - 1);
+
+	replay.values = inputs;
+	replay.waits = false; /* Past the recorded numbers it reads 0, as the recorded run would have */
+	cpu.input = &replay;
+	cpu.restoreSnapshot(from); /* Seeks replay to the checkpoint's place in inputs */
+	cpu.step(step - from.steps);
+	return true;
+}
+
+/* Little endian fields, so a journal reads the same on any host */
+static void putBytes(std::vector<unsigned char> & out, unsigned long long value, int count) {
+	for (int index = 0; index < count; ++index)
+		out.push_back((unsigned char)(value >> (8 * index)));
+}
+static unsigned long long getBytes(const unsigned char * & in, int count) {
+	unsigned long long value = 0;
+	for (int index = 0; index < count; ++index)
+		value |= (unsigned long long) in[index] << (8 * index);
+	in += count;
+	return value;
+}
+
+/*
+*	Journal layout (multi-byte fields little endian):
+*	  0  magic "BSJ" and format version 1
+*	  4  address bits of the machine
+*	  5  status the recorded run stopped with
+*	  6  2 bytes, 0
+*	  8  interval (8 bytes)
+*	  16 steps where the run stopped (8 bytes)
+*	  24 number of inputs (4 bytes)
+*	  28 number of checkpoints (4 bytes)
+*	  32 inputs, 4 bytes each
+*	  .. checkpoints, each: steps (8 bytes), index into inputs (4 bytes),
+*	     progStart and the 16 registers (addrBytes each), number of ranges
+*	     (4 bytes), then every range of memory that changed since the
+*	     checkpoint before (zeroed memory for the first): start (4 bytes),
+*	     length (4 bytes) and the bytes
+*/
+template <int AddrBits>
+const char JournalT<AddrBits>::journalMagic[4] = {'B', 'S', 'J', 1};
+
+/* Writes the journal. Memory is stored as what changed between checkpoints, which is usually little */
+template <int AddrBits>
+bool JournalT<AddrBits>::save(const char * fileName) const {
+	enum {addrBytes=Machine::addrBytes, n_mem=Machine::n_mem, joinGap=8}; /* Ranges closer than joinGap are written as one */
+	std::vector<unsigned char> out(journalMagic, journalMagic + 4);
+	out.push_back(AddrBits);
+	out.push_back((unsigned char) status);
+	putBytes(out, 0, 2);
+	putBytes(out, interval, 8);
+	putBytes(out, steps, 8);
+	putBytes(out, inputs.size(), 4);
+	putBytes(out, checkpoints.size(), 4);
+	for (int index = 0; index < (int) inputs.size(); ++index)
+		putBytes(out, (unsigned int) inputs[index], 4);
+
+	static const unsigned char zeroes[n_mem] = {0};
+	const unsigned char * before = zeroes;
+	for (int index = 0; index < (int) checkpoints.size(); ++index) {
+		const Snapshot & checkpoint = checkpoints[index];
+		putBytes(out, checkpoint.steps, 8);
+		putBytes(out, checkpoint.inputPosition, 4);
+		putBytes(out, checkpoint.progStart, addrBytes);
+		for (int reg = 0; reg < Machine::n_regs; ++reg)
+			putBytes(out, checkpoint.regs[reg], addrBytes);
+
+		size_t countAt = out.size();
+		putBytes(out, 0, 4);
+		unsigned int ranges = 0;
+		for (int address = 0; address < n_mem; ) {
+			if (checkpoint.mem[address] == before[address]) {
+				++address;
+				continue;
+			}
+			int end = address + 1, same = 0;
+			for (int scan = end; scan < n_mem && same < joinGap; ++scan) {
+				if (checkpoint.mem[scan] != before[scan]) end = scan + 1, same = 0;
+				else ++same;
+			}
+			putBytes(out, address, 4);
+			putBytes(out, end - address, 4);
+			out.insert(out.end(), checkpoint.mem + address, checkpoint.mem + end);
+			++ranges;
+			address = end;
+		}
+		for (int byte = 0; byte < 4; ++byte)
+			out[countAt + byte] = (unsigned char)(ranges >> (8 * byte));
+		before = checkpoint.mem;
+	}
+
+	FILE * file = fopen(fileName, "wb");
+	if (file == NULL) return false;
+	bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+	return (fclose(file) == 0) && written;
+}
+
+/* Reads a journal written by save. Messages say what is wrong with one that does not load */
+template <int AddrBits>
+bool JournalT<AddrBits>::load(const char * fileName, EmulatorOutput * messages) {
+	enum {addrBytes=Machine::addrBytes, n_mem=Machine::n_mem, headerSize=32};
+	FILE * file = fopen(fileName, "rb");
+	if (file == NULL) {
+		messages->print("Can't open %s.\n", fileName);
+		return false;
+	}
+	std::vector<unsigned char> bytes;
+	unsigned char chunk[65536];
+	size_t count;
+	while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		bytes.insert(bytes.end(), chunk, chunk + count);
+	fclose(file);
+
+	if (bytes.size() < headerSize || memcmp(bytes.data(), journalMagic, 4) != 0) {
+		messages->print("Error. Not a ByteSyzed journal.\n");
+		return false;
+	}
+	if (bytes[4] != AddrBits) {
+		messages->print("Error. Journal is for a %i bit machine, this one is %i bit.\n", bytes[4], AddrBits);
+		return false;
+	}
+
+	const unsigned char * in = bytes.data() + 5, * end = bytes.data() + bytes.size();
+	clear();
+	status = (Status) getBytes(in, 1);
+	getBytes(in, 2);
+	interval = getBytes(in, 8);
+	steps = getBytes(in, 8);
+	unsigned long long inputCount = getBytes(in, 4), checkpointCount = getBytes(in, 4);
+	if ((unsigned long long)(end - in) < inputCount * 4) {
+		messages->print("Error. Journal is cut short.\n");
+		return false;
+	}
+	for (unsigned long long index = 0; index < inputCount; ++index)
+		inputs.push_back((int)(unsigned int) getBytes(in, 4));
+
+	/* Each checkpoint starts as the one before and has its ranges written over it */
+	Snapshot checkpoint;
+	memset(&checkpoint, 0, sizeof(checkpoint));
+	for (unsigned long long index = 0; index < checkpointCount; ++index) {
+		if (end - in < 16 + addrBytes * (1 + Machine::n_regs)) break;
+		checkpoint.steps = getBytes(in, 8);
+		checkpoint.inputPosition = (long) getBytes(in, 4);
+		checkpoint.progStart = getBytes(in, addrBytes);
+		for (int reg = 0; reg < Machine::n_regs; ++reg)
+			checkpoint.regs[reg] = getBytes(in, addrBytes);
+
+		unsigned long long ranges = getBytes(in, 4);
+		for (; ranges > 0 && end - in >= 8; --ranges) {
+			unsigned long long start = getBytes(in, 4), length = getBytes(in, 4);
+			if (start + length > n_mem || (unsigned long long)(end - in) < length) break;
+			memcpy(checkpoint.mem + start, in, length);
+			in += length;
+		}
+		if (ranges > 0) break;
+		checkpoints.push_back(checkpoint);
+	}
+	if (checkpoints.size() != checkpointCount) {
+		messages->print("Error. Journal is cut short.\n");
+		clear();
+		return false;
+	}
+	return true;
+}
+
+template class JournalT<8>;
+template class JournalT<16>;
\ No newline at end of file
@@ -0,0 +1,65 @@
+/*	Journal.h
+*
+*	ByteSyzed Execution Journal Header.
+*
+*	Records a run as the only things that can differ between two runs of
+*	the same machine, the numbers getchar read, plus a snapshot every
+*	interval instructions. Replaying restores a checkpoint and feeds the
+*	recorded numbers back, so any step of a long run can be reached by
+*	running at most interval instructions.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "ByteSyzed.h"
+#include <vector>
+
+/* Reads through another input and keeps every number it hands out. tell() is how many, so a snapshot knows where in the journal it is */
+class RecordingInput : public EmulatorInput {
+public:
+	EmulatorInput * source;
+	std::vector<int> & values;
+	RecordingInput(EmulatorInput * source, std::vector<int> & values) : source(source), values(values) {}
+	bool read(int & value) {
+		if (!source->read(value)) value = 0; /* Reads as 0 either way, and a replay has to read the same */
+		values.push_back(value);
+		return true;
+	}
+	bool ready(void) { return source->ready(); }
+	long tell(void) { return (long) values.size(); }
+};
+
+template <int AddrBits>
+class JournalT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Snapshot Snapshot;
+	typedef typename Machine::Status Status;
+
+	unsigned long long interval = 1000000; /* Instructions between checkpoints */
+	std::vector<int> inputs; /* Every number getchar read, in order */
+	std::vector<Snapshot> checkpoints; /* Every interval instructions, the first where recording began. inputPosition is an index into inputs */
+	Status status = Machine::running; /* How the recorded run stopped */
+	unsigned long long steps = 0; /* Where it stopped */
+
+	Status record(Machine & cpu, unsigned long long maxSteps = ~0ULL); /* Runs a booted machine, recording, until it stops or has run maxSteps in all. Calling again continues */
+	bool seek(Machine & cpu, QueueInput & replay, unsigned long long step); /* Puts cpu where the recorded run was after step instructions, reading the recorded numbers through replay. cpu.status is outOfSteps if it got there, false if no checkpoint is that early */
+	void clear(void) { inputs.clear(), checkpoints.clear(), status = Machine::running, steps = 0; }
+	bool save(const char * fileName) const; /* Writes the journal, see Journal.cpp for the layout */
+	bool load(const char * fileName, EmulatorOutput * messages = &standardOutput); /* Reads a journal written by save */
+
+	static const char journalMagic[4];
+};
+
+typedef JournalT<8> Journal;
+typedef JournalT<16> Journal16;
+
+/* Built once in Journal.cpp */
+extern template class JournalT<8>;
+extern template class JournalT<16>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,375 @@
+/*	Lockstep.cpp
+*
+*	ByteSyzed Lockstep Engine Definition.
+*
+*	Every step picks the running machine with the lowest program counter
+*	and runs its instruction on every machine that is at the same address
+*	with the same instruction bytes. The rest wait, which lets machines
+*	that split at a branch line back up once they reach common code.
+*	Instructions touching memory through a register, the stack, input and
+*	output go machine by machine. Everything else is row arithmetic under
+*	a mask of the machines taking part.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Lockstep.h"
+#include <stdarg.h>
+#include <stdlib.h>
+
+/* printf onto the end of a machine's output */
+static void appendf(std::string & text, const char * format, ...) {
+	char line[128];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	text.append(line, length);
+}
+
+/* Wipes every machine, loads the image into all of them and boots them */
+template <int Lanes>
+void Lockstep<Lanes>::load(const unsigned char * image, int count, unsigned char progStart) {
+	for (int index = 0; index < ByteSyzed::n_regs; ++index) regs[index] = splat(0);
+	for (int index = 0; index < ByteSyzed::n_mem; ++index) mem[index] = splat(0);
+	for (int index = 0; index < count && progStart + index < ByteSyzed::n_mem; ++index)
+		mem[progStart + index] = splat(image[index]);
+
+	/* Same start as ByteSyzed::boot */
+	regs[0xF] = splat(progStart);
+	regs[0xE] = splat(ByteSyzed::n_mem - 1);
+	mem[ByteSyzed::n_mem - 1] = splat(progStart);
+
+	live = splat(0xFF);
+	shared = 0;
+	for (int lane = 0; lane < Lanes; ++lane) {
+		status[lane] = running;
+		steps[lane] = own[lane] = 0;
+		output[lane].clear();
+		inputs[lane].clear();
+	}
+}
+
+/* Numbers getchar reads on one machine. Like scanf("%i"), reading stops at the first thing that is not a number */
+template <int Lanes>
+void Lockstep<Lanes>::setInput(int lane, const char * input) {
+	inputs[lane].clear();
+	inputs[lane].push(input);
+}
+
+/* Same text as ByteSyzed::dumpRegs, without verbose */
+template <int Lanes>
+void Lockstep<Lanes>::dumpRegs(int lane, unsigned char id) {
+	if (id < ByteSyzed::n_regs) {
+		appendf(output[lane], "regs[0x%01X] = 0x%02X\n", id, regs[id][lane]);
+	} else {
+		for (int index = 0; index < ByteSyzed::n_regs; ++index)
+			appendf(output[lane], "0x%01X : 0x%02X\n", index, regs[index][lane]);
+	}
+}
+
+/* Same text as ByteSyzed::dumpMemRange, without verbose */
+template <int Lanes>
+void Lockstep<Lanes>::dumpMemRange(int lane, unsigned char first, unsigned char last) {
+	for (int index = first; index <= last; ++index)
+		appendf(output[lane], "0x%02X : 0x%02X\n", index, mem[index][lane]);
+	for (int index = first; index >= last; --index)
+		appendf(output[lane], "0x%02X : 0x%02X\n", index, mem[index][lane]);
+}
+
+/* Runs every machine of the group through the block that follows, one at a time */
+#define EACH_LANE for (int lane = 0; lane < Lanes; ++lane) if (group[lane])
+
+/* Runs until every machine stops */
+template <int Lanes>
+void Lockstep<Lanes>::run(unsigned long long maxSteps) {
+	const Row zero = splat(0);
+	bool converged = false; /* Every running machine is at the leader's address */
+	int leader = -1;
+	unsigned long long ownMax = 0; /* At least the largest own[] of a running machine */
+	for (int lane = 0; lane < Lanes; ++lane)
+		if (live[lane] && own[lane] > ownMax) ownMax = own[lane];
+
+	for (;;) {
+		/* Leader: the running machine with the lowest program counter */
+		if (!converged) {
+			leader = -1;
+			for (int lane = 0; lane < Lanes; ++lane)
+				if (live[lane] && (leader < 0 || regs[0xF][lane] < regs[0xF][leader])) leader = lane;
+			if (leader < 0) return;
+		}
+
+		unsigned char pc = regs[0xF][leader];
+		unsigned char bytes[4];
+		for (int index = 0; index < 4; ++index)
+			bytes[index] = mem[(unsigned char)(pc + index)][leader];
+		ByteSyzed::Decoded in;
+		ByteSyzed::decodeBytes(bytes, in);
+		unsigned char length = (ByteSyzed::opcodeLength[in.opcode] != 0)? ByteSyzed::opcodeLength[in.opcode] : 1;
+
+		/* Group: running machines at the same address, with the same instruction there */
+		Row group = live & (regs[0xF] == splat(pc));
+		for (int index = 0; index < length; ++index)
+			group = group & (mem[(unsigned char)(pc + index)] == splat(bytes[index]));
+		bool all = same(group, live); /* The common case, counted once for everyone */
+		if (all) ++shared; else EACH_LANE ++own[lane];
+		converged = all;
+
+		Row & ra = regs[in.a];
+		Row & rb = regs[in.b];
+		Row & pcs = regs[0xF];
+		bool advance = true; /* Step the group past the instruction afterwards */
+
+		switch (in.opcode) {
+			case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			case 0x08: case 0x09: case 0x0A: case 0x0B: case 0x0C: case 0x0D: case 0x0E: case 0x0F: /* "movA val" */
+				put(ra, splat(in.imm1), group);
+				advance = (in.a != 0xF);
+				break;
+			case 0x10: put(ra, rb, group); break; /* "mov AB" -- reg[A] = reg[B] */
+			case 0x11: EACH_LANE ra[lane] = mem[rb[lane]][lane]; break; /* "mov AB" -- reg[A] = mem[regs[B]] */
+			case 0x12: EACH_LANE mem[ra[lane]][lane] = rb[lane]; break; /* "mov AB" -- mem[reg[A]] = reg[B] */
+			case 0x13: EACH_LANE mem[ra[lane]][lane] = mem[rb[lane]][lane]; break; /* "mov AB" -- mem[reg[A]] = mem[reg[B]] */
+			case 0x14: put(ra, splat(in.imm1), group), put(rb, splat(in.imm1), group); break; /* "mov AB val" */
+			case 0x15: put(ra, ra + splat(in.b), group); break; /* "inc AB" */
+			case 0x16: put(ra, ra - splat(in.b), group); break; /* "dec AB" */
+			case 0x17: put(ra, splat(pc + in.b), group); break; /* "pco AB" -- reg[A] = regs[0xF] + B */
+			case 0x18: put(ra, splat(pc - in.b), group); break; /* "pco AB" -- reg[A] = regs[0xF] - B */
+			case 0x19: /* "cas AB" -- if mem[reg[A]] == regs[0x0] then mem[reg[A]] = reg[B]. regs[0x0] = what mem[reg[A]] was */
+				EACH_LANE {
+					unsigned char address = ra[lane], found = mem[address][lane];
+					if (found == regs[0x0][lane]) mem[address][lane] = rb[lane];
+					regs[0x0][lane] = found;
+				}
+				break;
+			case 0x1A: /* "xadd AB" -- mem[reg[A]] += reg[B]. reg[B] = what mem[reg[A]] was */
+				EACH_LANE {
+					unsigned char address = ra[lane], found = mem[address][lane];
+					mem[address][lane] = found + rb[lane];
+					rb[lane] = found;
+				}
+				break;
+			case 0x20: put(ra, ra & rb, group); break; /* "and AB" */
+			case 0x30: put(ra, ra | rb, group); break; /* "or AB" */
+			case 0x40: put(ra, ra ^ rb, group); break; /* "xor AB" */
+			case 0x50: /* "shl AB" */
+			case 0x51: { /* "shr AB" */
+				Row shifted;
+				for (int lane = 0; lane < Lanes; ++lane)
+					shifted[lane] = (in.opcode == 0x50)? ra[lane] << (rb[lane] & 0x7) : ra[lane] >> (rb[lane] & 0x7);
+				put(ra, shifted, group);
+				break;
+			}
+			case 0x52: /* "rol AB" */
+			case 0x53: { /* "ror AB" */
+				Row rotated;
+				for (int lane = 0; lane < Lanes; ++lane) {
+					if (in.opcode == 0x52)
+						rotated[lane] = (ra[lane] >> (8 - (rb[lane] & 0x7))) + (ra[lane] << (rb[lane] & 0x7));
+					else
+						rotated[lane] = (ra[lane] << (8 - (rb[lane] & 0x7))) + (ra[lane] >> (rb[lane] & 0x7));
+				}
+				put(ra, rotated, group);
+				break;
+			}
+			case 0x70: /* "jmp adr" */
+				put(pcs, splat(in.imm1), group);
+				advance = false;
+				break;
+			case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: { /* "jl" "jle" "je" "jge" "jg" "jne" AB adr */
+				Row taken;
+				switch (in.opcode) {
+					case 0x71: taken = (ra < rb); break;
+					case 0x72: taken = (ra <= rb); break;
+					case 0x73: taken = (ra == rb); break;
+					case 0x74: taken = (ra >= rb); break;
+					case 0x75: taken = (ra > rb); break;
+					default: taken = (ra != rb); break;
+				}
+				taken = taken & group;
+				converged = converged && (same(taken, zero) || same(taken, group));
+				put(pcs, pcs + splat(length), group & ~taken);
+				put(pcs, splat(in.imm1), taken);
+				advance = false;
+				break;
+			}
+			case 0x77: /* "skipIfNZ AB" */
+			case 0x78: { /* "skipIfZ AB" */
+				Row taken = group & ((in.opcode == 0x77)? (ra != zero) : (ra == zero));
+				converged = converged && (same(taken, zero) || same(taken, group));
+				put(pcs, pcs + splat(in.b + 2), taken);
+				put(pcs, pcs + splat(length), group & ~taken);
+				advance = false;
+				break;
+			}
+			case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: case 0x85: case 0x86: case 0x87:
+			case 0x88: case 0x89: case 0x8A: case 0x8B: case 0x8C: case 0x8D: case 0x8E: case 0x8F: /* "pushA" */
+				EACH_LANE {
+					if (regs[0xE][lane] > 0) {
+						--regs[0xE][lane]; /* Decrement first, so "push 0xE" pushes the new stack pointer */
+						mem[regs[0xE][lane]][lane] = ra[lane];
+					} else {
+						appendf(output[lane], "\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", ra[lane]);
+						retire(lane, faulted);
+					}
+				}
+				break;
+			case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: case 0x97:
+			case 0x98: case 0x99: case 0x9A: case 0x9B: case 0x9C: case 0x9D: case 0x9E: case 0x9F: /* "popA" */
+				EACH_LANE {
+					if (regs[0xE][lane] != ByteSyzed::n_mem - 1) {
+						ra[lane] = mem[regs[0xE][lane]][lane];
+						++regs[0xE][lane];
+					} else {
+						appendf(output[lane], "\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", in.a);
+						retire(lane, faulted);
+					}
+				}
+				advance = (in.a != 0xF);
+				converged = converged && advance; /* Popped addresses may differ */
+				break;
+			case 0xA0: put(ra, ra + rb, group); break; /* "add AB" */
+			case 0xA1: put(ra, rb + mem[in.imm1], group); break; /* "add AB adr" */
+			case 0xA2: put(mem[in.imm1], ra + rb, group); break; /* "add adr AB" */
+			case 0xA3: put(ra, rb + splat(in.imm1), group); break; /* "add AB val" */
+			case 0xA4: put(ra, splat(in.b * in.imm1), group); break; /* "lea AB val" -- reg[A] = B*val */
+			case 0xA5: put(ra, splat(in.b + in.imm1), group); break; /* "lea AB val" -- reg[A] = B + val */
+			case 0xA6: put(ra, splat(in.b * in.imm1 + in.imm2), group); break; /* "lea AB val1 val2" */
+			case 0xA7: put(ra, ra - rb, group); break; /* "sub AB" */
+			case 0xA8: put(ra, rb - mem[in.imm1], group); break; /* "sub AB adr" */
+			case 0xA9: put(ra, mem[in.imm1] - rb, group); break; /* "sub AB adr" */
+			case 0xAA: put(mem[in.imm1], ra - rb, group); break; /* "sub adr AB" */
+			case 0xAB: put(ra, rb - splat(in.imm1), group); break; /* "sub AB val" */
+			case 0xAC: put(ra, splat(in.imm1) - rb, group); break; /* "sub AB val" */
+			case 0xC2: /* "call adr" */
+				EACH_LANE {
+					if (regs[0xE][lane] > 0) {
+						--regs[0xE][lane];
+						mem[regs[0xE][lane]][lane] = pc + 2;
+						pcs[lane] = in.imm1;
+					} else {
+						appendf(output[lane], " 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", in.next1, (unsigned char)(pc + 2));
+						retire(lane, faulted);
+					}
+				}
+				advance = false;
+				break;
+			case 0xC3: /* "ret" */
+				EACH_LANE {
+					if (regs[0xE][lane] < ByteSyzed::n_mem - 1) {
+						pcs[lane] = mem[regs[0xE][lane]++][lane];
+					} else {
+						appendf(output[lane], "\nSegmentation fault. At the edge of memory, unable to pop return address.\n");
+						retire(lane, faulted);
+					}
+				}
+				advance = false;
+				converged = false; /* Return addresses may differ */
+				break;
+			case 0xD0: break; /* "nop" */
+			case 0xE0: EACH_LANE output[lane] += (char) regs[0x1][lane]; break; /* "putchar" */
+			case 0xE1: /* "getchar", 0 once the input runs out */
+				EACH_LANE {
+					int value;
+					if (!inputs[lane].read(value)) value = 0;
+					regs[0x0][lane] = (unsigned char)(value % 256);
+				}
+				break;
+			case 0xE2: /* "printstr char[],0" */
+				EACH_LANE {
+					while (mem[++pcs[lane]][lane] != 0) output[lane] += (char) mem[pcs[lane]][lane];
+				}
+				converged = false; /* Strings may differ in length */
+				break;
+			case 0xE3: case 0xE4: put(regs[0x0], zero, group); break; /* "spawn adr", "join", a single core gets 0 */
+			case 0xE8: EACH_LANE dumpRegs(lane, 0x0); break; /* "dumpRegs[0x0]" */
+			case 0xE9: EACH_LANE dumpRegs(lane, 0x1); break; /* "dumpRegs[0x1]" */
+			case 0xEA: EACH_LANE dumpMemRange(lane, 0, ByteSyzed::n_mem - 1); break; /* "dumpMem" */
+			case 0xEB: EACH_LANE dumpMemRange(lane, regs[0x1][lane], regs[0x2][lane]); break; /* "dumpMemRange" */
+			case 0xEC: EACH_LANE dumpRegs(lane, regs[0x1][lane]); break; /* "dumpRegs" */
+			case 0xED: /* "dump id", as ByteSyzed::dump */
+				EACH_LANE {
+					if (in.imm1 == 0xFD || in.imm1 == 0xFE) dumpMemRange(lane, 0, ByteSyzed::n_mem - 1);
+					if (in.imm1 == 0xFD || in.imm1 == 0xFF) dumpRegs(lane, 0xFF);
+					if (in.imm1 < ByteSyzed::n_regs) dumpRegs(lane, in.imm1);
+				}
+				break;
+			case 0xEE: /* "exit" */
+				EACH_LANE retire(lane, exited);
+				advance = false;
+				break;
+			case 0xEF: break; /* "fileDump", off as in the batch runner */
+			default: /* Invalid opcode */
+				EACH_LANE {
+					appendf(output[lane], "\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", in.opcode, pc);
+					retire(lane, faulted);
+				}
+				advance = false;
+				break;
+		}
+
+		if (advance) put(pcs, pcs + splat(length), group & live);
+		if (in.a == 0xF || in.b == 0xF) converged = false; /* May have written different addresses to the program counter */
+		if (converged && !live[leader]) converged = false; /* The leader stopped */
+
+		/* Out of steps. Running machines only need a look once the furthest along could be */
+		if (all) {
+			if (shared + ownMax >= maxSteps) {
+				ownMax = 0;
+				for (int lane = 0; lane < Lanes; ++lane) {
+					if (!live[lane]) continue;
+					if (own[lane] + shared >= maxSteps) retire(lane, outOfSteps);
+					else if (own[lane] > ownMax) ownMax = own[lane];
+				}
+				if (converged && !live[leader]) converged = false;
+			}
+		} else {
+			EACH_LANE {
+				if (!live[lane]) continue;
+				if (own[lane] + shared >= maxSteps) retire(lane, outOfSteps);
+				else if (own[lane] > ownMax) ownMax = own[lane];
+			}
+		}
+	}
+}
+
+#undef EACH_LANE
+
+/* Runs one program once per input, Lanes machines at a time */
+template <int Lanes>
+std::vector<BatchRunner::Result> Lockstep<Lanes>::sweep(const unsigned char * image, int count, const std::vector<std::string> & inputs, unsigned long long maxSteps, unsigned char progStart) {
+	std::vector<BatchRunner::Result> results(inputs.size());
+	Lockstep * machines = new Lockstep(); /* Heap, it is Lanes * 272 bytes and more */
+	bool fits = (count >= 0 && progStart + count <= ByteSyzed::n_mem);
+
+	for (int first = 0; first < (int) inputs.size(); first += Lanes) {
+		machines->load(image, fits? count : 0, progStart);
+		for (int lane = 0; lane < Lanes; ++lane) {
+			if (fits && first + lane < (int) inputs.size())
+				machines->setInput(lane, inputs[first + lane].c_str());
+			else
+				machines->stop(lane);
+		}
+		machines->run(maxSteps);
+
+		for (int lane = 0; lane < Lanes && first + lane < (int) inputs.size(); ++lane) {
+			BatchRunner::Result & result = results[first + lane];
+			result.loaded = fits;
+			result.status = (ByteSyzed::Status) machines->status[lane]; /* Both name them in the same order */
+			result.exitCode = machines->regs[0x0][lane];
+			result.steps = machines->steps[lane];
+			for (int index = 0; index < ByteSyzed::n_regs; ++index) result.regs[index] = machines->regs[index][lane];
+			for (int index = 0; index < ByteSyzed::n_mem; ++index) result.mem[index] = machines->mem[index][lane];
+			result.output = machines->output[lane];
+		}
+	}
+
+	delete machines;
+	return results;
+}
+
+/* The lane counts the engine is meant for */
+template class Lockstep<16>;
+template class Lockstep<32>;
+template class Lockstep<64>;
\ No newline at end of file
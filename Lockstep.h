@@ -0,0 +1,122 @@
+/*	Lockstep.h
+*
+*	ByteSyzed Lockstep Engine Header.
+*
+*	Runs Lanes (16, 32 or 64) copies of a ByteSyzed machine side by side,
+*	stored as a struct of arrays: byte r of every machine's registers sits
+*	in one row, as does byte a of every machine's memory. The machines
+*	that are at the same instruction run it together, and the ALU opcodes
+*	work on whole rows at once (SSE/AVX2 byte lanes, whichever the
+*	compiler targets). Made for running one program with many inputs.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "ByteSyzed.h"
+#include "BatchRunner.h"
+#include <string.h>
+#include <string>
+#include <vector>
+
+/* Rows are built from GCC/Clang vector types when available, so row arithmetic compiles to SIMD. Build with -DBYTESYZED_VECTOR=0 to use plain loops */
+#ifndef BYTESYZED_VECTOR
+#if defined(__GNUC__)
+#define BYTESYZED_VECTOR 1
+#else
+#define BYTESYZED_VECTOR 0
+#endif
+#endif
+
+/* Chunk of machines handled by one vector instruction: 32 with AVX2, 16 with SSE2, 1 without vectors */
+#if BYTESYZED_VECTOR
+template <int Width> struct LaneChunk;
+template <> struct LaneChunk<16> { typedef unsigned char Type __attribute__((vector_size(16))); };
+template <> struct LaneChunk<32> { typedef unsigned char Type __attribute__((vector_size(32), aligned(16))); }; /* 16, so plain new (before C++17) is enough */
+#if defined(__AVX2__)
+enum {laneChunkMax=32};
+#else
+enum {laneChunkMax=16};
+#endif
+#define LANEROW_CHUNK typename LaneChunk<(Lanes < laneChunkMax)? Lanes : laneChunkMax>::Type
+#define LANEROW_TRUE(test) ((Chunk)(test)) /* Vector comparisons already give all ones where true */
+#else
+#define LANEROW_CHUNK unsigned char
+#define LANEROW_TRUE(test) ((test)? 0xFF : 0x00)
+#endif
+
+/* One byte per machine, Lanes machines, with the element-wise operators the engine uses. Comparisons give 0xFF where true */
+template <int Lanes>
+struct LaneRow {
+	typedef LANEROW_CHUNK Chunk;
+	enum {chunks = Lanes / sizeof(Chunk)};
+	Chunk chunk[chunks];
+
+	unsigned char & operator[](int lane) { return ((unsigned char *) chunk)[lane]; }
+	unsigned char operator[](int lane) const { return ((const unsigned char *) chunk)[lane]; }
+
+#define LANEROW_OP(op, value) \
+	LaneRow operator op(const LaneRow & right) const { \
+		LaneRow row; \
+		for (int index = 0; index < chunks; ++index) row.chunk[index] = value(chunk[index] op right.chunk[index]); \
+		return row; \
+	}
+	LANEROW_OP(+, (Chunk)) LANEROW_OP(-, (Chunk)) LANEROW_OP(&, (Chunk)) LANEROW_OP(|, (Chunk)) LANEROW_OP(^, (Chunk))
+	LANEROW_OP(==, LANEROW_TRUE) LANEROW_OP(!=, LANEROW_TRUE) LANEROW_OP(<, LANEROW_TRUE)
+	LANEROW_OP(<=, LANEROW_TRUE) LANEROW_OP(>, LANEROW_TRUE) LANEROW_OP(>=, LANEROW_TRUE)
+#undef LANEROW_OP
+	LaneRow operator~() const {
+		LaneRow row;
+		for (int index = 0; index < chunks; ++index) row.chunk[index] = ~chunk[index];
+		return row;
+	}
+
+	/* Row with value on every machine */
+	static LaneRow splat(unsigned char value) {
+		LaneRow row;
+		for (int index = 0; index < chunks; ++index) row.chunk[index] = (Chunk)(Chunk() + value);
+		return row;
+	}
+};
+#undef LANEROW_CHUNK
+#undef LANEROW_TRUE
+
+template <int Lanes>
+class Lockstep {
+public:
+	typedef LaneRow<Lanes> Row; /* One byte per machine */
+	enum {lanes=Lanes};
+	enum Status {running, exited, faulted, outOfSteps}; /* Why a machine stopped */
+
+	Row regs[ByteSyzed::n_regs]; /* regs[r][lane] is register r of a machine */
+	Row mem[ByteSyzed::n_mem]; /* mem[address][lane] is memory of a machine */
+	Row live; /* 0xFF for machines still running */
+	unsigned char status[Lanes]; /* Status of every machine */
+	unsigned long long steps[Lanes]; /* Instructions executed by every machine, set as it stops */
+	std::string output[Lanes]; /* Everything every machine printed */
+
+	void load(const unsigned char * image, int count, unsigned char progStart = 0x00); /* Wipes every machine, loads the image into all of them and boots them */
+	void setInput(int lane, const char * input); /* Numbers getchar reads on one machine, whitespace separated */
+	void stop(int lane) { retire(lane, exited); } /* Takes a machine out before running, e.g. an unused lane */
+	void run(unsigned long long maxSteps); /* Runs until every machine stops. Machines running past maxSteps stop with outOfSteps */
+
+	/* Runs one program once per input, Lanes machines at a time. Results are in input order */
+	static std::vector<BatchRunner::Result> sweep(const unsigned char * image, int count, const std::vector<std::string> & inputs, unsigned long long maxSteps, unsigned char progStart = 0x00);
+
+private:
+	QueueInput inputs[Lanes]; /* Numbers getchar reads, per machine */
+	unsigned long long own[Lanes]; /* Steps a machine ran outside of steps every running machine ran */
+	unsigned long long shared; /* Steps every running machine ran together */
+
+	static Row splat(unsigned char value) { return Row::splat(value); } /* Row with value on every machine */
+	static void put(Row & row, const Row & value, const Row & mask) { row = (row & ~mask) | (value & mask); } /* Writes value where mask is set */
+	static bool same(const Row & left, const Row & right) { return memcmp(&left, &right, sizeof(Row)) == 0; }
+	void retire(int lane, unsigned char why) { status[lane] = why, live[lane] = 0, steps[lane] = own[lane] + shared; } /* Stops a machine */
+	void dumpRegs(int lane, unsigned char id); /* Same text as ByteSyzed::dumpRegs, without verbose */
+	void dumpMemRange(int lane, unsigned char first, unsigned char last); /* Same text as ByteSyzed::dumpMemRange, without verbose */
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+/*	MachinePool.cpp
+*
+*	ByteSyzed Machine Pool Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "MachinePool.h"
+
+/* Reads the program every machine starts with */
+template <int AddrBits>
+bool MachinePoolT<AddrBits>::loadFile(const char * fileName, Word progStart, EmulatorOutput * messages) {
+	return load(fileName, NULL, 0, progStart, messages);
+}
+
+/* Same, from a byte image loaded at progStart */
+template <int AddrBits>
+bool MachinePoolT<AddrBits>::loadImage(const unsigned char * image, int count, Word progStart, EmulatorOutput * messages) {
+	return load(NULL, image, count, progStart, messages);
+}
+
+/* Loads into a new machine and keeps it booted as the state to hand out. The machines of an earlier program are dropped */
+template <int AddrBits>
+bool MachinePoolT<AddrBits>::load(const char * fileName, const unsigned char * image, int count, Word progStart, EmulatorOutput * messages) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (idle.size() != owned.size()) {
+		messages->print("Error. %i machines of the pool are still out, release them before loading.\n", (int)(owned.size() - idle.size()));
+		return false;
+	}
+
+	std::unique_ptr<Machine> cpu(new Machine()); /* Heap, it is a few kilobytes (megabytes at 16 bits) */
+	cpu->output = messages;
+	cpu->wipeMemory();
+	cpu->progStart = progStart;
+	bool loaded = (fileName != NULL)? cpu->loadFromFile(fileName) : cpu->loadFromMemory(image, count);
+	if (!loaded) return false;
+
+	cpu->boot();
+	booted.reset(new typename Machine::Snapshot);
+	cpu->saveSnapshot(*booted);
+	booted->inputPosition = -1; /* Each run brings its own input */
+	cpu->clearDirty();
+	defaults(*cpu);
+
+	idle.clear();
+	owned.clear();
+	idle.push_back(cpu.get());
+	owned.push_back(std::move(cpu));
+	return true;
+}
+
+/* Makes machines until count are free */
+template <int AddrBits>
+void MachinePoolT<AddrBits>::reserve(int count) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!booted) return;
+	while ((int) idle.size() < count)
+		idle.push_back(make());
+}
+
+/* A new machine in the booted state. Hold lock */
+template <int AddrBits>
+typename MachinePoolT<AddrBits>::Machine * MachinePoolT<AddrBits>::make(void) {
+	Machine * cpu = new Machine();
+	owned.push_back(std::unique_ptr<Machine>(cpu));
+	cpu->wipeMemory();
+	cpu->restoreSnapshot(*booted);
+	cpu->status = Machine::running;
+	defaults(*cpu);
+	return cpu;
+}
+
+/* Settings, input and output as the pool hands them out */
+template <int AddrBits>
+void MachinePoolT<AddrBits>::defaults(Machine & cpu) const {
+	cpu.verbose = verbose;
+	cpu.prompt = prompt;
+	cpu.dumpFileName = dumpFileName;
+	cpu.output = &standardOutput;
+	cpu.input = &standardInput;
+	cpu.dumpOutput = NULL;
+	cpu.trace = NULL;
+	cpu.profile = NULL;
+	cpu.watch = NULL;
+	cpu.stepLimit = ~0ULL;
+	cpu.translating = true;
+}
+
+/* A machine booted on the program, ready for step() */
+template <int AddrBits>
+typename MachinePoolT<AddrBits>::Machine * MachinePoolT<AddrBits>::acquire(void) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!booted) return NULL;
+	if (idle.empty()) return make();
+	Machine * cpu = idle.back();
+	idle.pop_back();
+	return cpu;
+}
+
+/* Takes a machine back. The reset happens here, on the thread that ran it, so acquire only takes the lock */
+template <int AddrBits>
+void MachinePoolT<AddrBits>::release(Machine * cpu) {
+	if (cpu == NULL) return;
+	defaults(*cpu); /* The run's input and output may be gone by now */
+	cpu->resetTo(*booted);
+	cpu->status = Machine::running;
+	std::lock_guard<std::mutex> guard(lock);
+	idle.push_back(cpu);
+}
+
+template class MachinePoolT<8>;
+template class MachinePoolT<16>;
\ No newline at end of file
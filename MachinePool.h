@@ -0,0 +1,67 @@
+/*	MachinePool.h
+*
+*	ByteSyzed Machine Pool Header.
+*
+*	Hands out machines already loaded with one program and booted, for
+*	runs too short to pay for a wipe, a load and empty caches each time.
+*	The program is read once. A machine handed back is reset from the
+*	booted state through its dirty pages (see ByteSyzedT::resetTo): only
+*	memory the run wrote is compared and put back, and decoded
+*	instructions and translated blocks stay unless the run wrote over its
+*	own code. acquire and release may be called from any thread.
+*
+*	MachinePool pool;
+*	pool.loadFile("program.txt");
+*	ByteSyzed * cpu = pool.acquire();
+*	cpu->step(maxSteps); (or resume, resumeBlocks, not run, which boots)
+*	pool.release(cpu);
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef MACHINEPOOL_H
+#define MACHINEPOOL_H
+
+#include "ByteSyzed.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+template <int AddrBits>
+class MachinePoolT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+
+	/* Settings a machine has whenever it is handed out. release puts them back, whatever the run changed */
+	bool verbose = false;
+	bool prompt = false;
+	const char * dumpFileName = NULL; /* Machines would fight over one file, set dumpOutput per run instead */
+
+	bool loadFile(const char * fileName, Word progStart = 0x00, EmulatorOutput * messages = &standardOutput); /* Reads the program every machine starts with. False if it does not load, or a machine is still out */
+	bool loadImage(const unsigned char * image, int count, Word progStart = 0x00, EmulatorOutput * messages = &standardOutput); /* Same, from a byte image */
+	void reserve(int count); /* Makes machines until count are free, so the first acquires do not pay for them */
+	Machine * acquire(void); /* A machine booted on the program, ready for step(). NULL if nothing is loaded */
+	void release(Machine * cpu); /* Takes a machine back and resets it */
+	int created(void) const { return (int) owned.size(); } /* Machines made so far */
+
+private:
+	std::unique_ptr<typename Machine::Snapshot> booted; /* State every machine is handed out in */
+	std::vector<std::unique_ptr<Machine> > owned;
+	std::vector<Machine *> idle; /* Reset and waiting */
+	std::mutex lock; /* Around owned and idle */
+
+	bool load(const char * fileName, const unsigned char * image, int count, Word progStart, EmulatorOutput * messages);
+	Machine * make(void); /* A new machine in the booted state. Hold lock */
+	void defaults(Machine & cpu) const; /* Settings, input and output as the pool hands them out, with no per-run hooks */
+};
+
+typedef MachinePoolT<8> MachinePool;
+typedef MachinePoolT<16> MachinePool16;
+
+/* Built once in MachinePool.cpp */
+extern template class MachinePoolT<8>;
+extern template class MachinePoolT<16>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,407 @@
+/*	MultiCore.cpp
+*
+*	ByteSyzed Multi-Core Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "MultiCore.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+/* Zeroes memory and every core */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::wipeMemory(void) {
+	for (int index = 0; index < n_mem; ++index)
+		mem[index].store(0, std::memory_order_relaxed);
+	for (int id = 0; id < maxCores; ++id) {
+		memset(cores[id].regs, 0, sizeof(cores[id].regs));
+		cores[id].state.store(idle, std::memory_order_relaxed);
+		cores[id].status = Machine::running;
+		cores[id].steps = 0;
+	}
+}
+
+/* Copies the memory and progStart of a machine a program was loaded into */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::load(const Machine & cpu) {
+	for (int index = 0; index < n_mem; ++index)
+		mem[index].store(cpu.mem[index], std::memory_order_relaxed);
+	progStart = cpu.progStart;
+}
+
+/* Zeroes memory and copies an image to first */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::load(const unsigned char * image, int count, Word first) {
+	wipeMemory();
+	for (int index = 0; index < count; ++index)
+		mem[(Word)(first + index)].store(image[index], std::memory_order_relaxed);
+}
+
+template <int AddrBits>
+typename MultiCoreT<AddrBits>::Word MultiCoreT<AddrBits>::loadWord(Word address) const {
+	Word value = 0;
+	for (int index = 0; index < addrBytes; ++index)
+		value |= (Word)(load((Word)(address + index)) << (8 * index));
+	return value;
+}
+
+template <int AddrBits>
+void MultiCoreT<AddrBits>::storeWord(Word address, Word value) {
+	for (int index = 0; index < addrBytes; ++index)
+		store((Word)(address + index), (unsigned char)(value >> (8 * index)));
+}
+
+template <int AddrBits>
+void MultiCoreT<AddrBits>::print(const char * format, ...) {
+	char buffer[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	if (length > 0) output->write(buffer, (length < (int) sizeof(buffer))? length : sizeof(buffer) - 1);
+}
+
+/* One register if id names one, else all of them */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::printRegs(const Word * regs, Word id) {
+	if (id < n_regs) {
+		print("regs[0x%01X] = 0x%02X\n", id, regs[id]);
+		return;
+	}
+	for (int index = 0; index < n_regs; ++index)
+		print("0x%01X : 0x%02X\n", index, regs[index]);
+}
+
+/* Up from first to last, then down from first to last, as the engines print it */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::printMem(Word first, Word last) {
+	for (int index = first; index <= last; ++index)
+		print("0x%02X : 0x%02X\n", index, load(index));
+	for (int index = first; index >= last; --index)
+		print("0x%02X : 0x%02X\n", index, load(index));
+}
+
+/* Memory, then the dumping core's registers, in the format of ByteSyzed::fileDump */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::fileDump(const Word * regs) {
+	if (dumpOutput != NULL) {
+		for (int index = 0; index < n_mem; ++index)
+			dumpOutput->print("%02X\n", load(index));
+		for (int index = 0; index < n_regs; ++index)
+			dumpOutput->print("%02X\n", regs[index]);
+		return;
+	}
+	if (dumpFileName == NULL) return;
+
+	FILE * file = fopen(dumpFileName, "w");
+	if (file == NULL) return;
+	for (int index = 0; index < n_mem; ++index)
+		fprintf(file, "%02X\n", load(index));
+	for (int index = 0; index < n_regs; ++index)
+		fprintf(file, "%02X\n", regs[index]);
+	fclose(file);
+}
+
+/* Stops a core. Anything but a spawned core exiting stops every other core too, the first one to do so is the run's result */
+template <int AddrBits>
+typename MultiCoreT<AddrBits>::Status MultiCoreT<AddrBits>::stop(int id, Status status) {
+	cores[id].status = status;
+	if (id != 0 && status == Machine::exited) return status;
+	int first = -1;
+	if (stoppedByCore.compare_exchange_strong(first, id)) stopping.store(true, std::memory_order_release);
+	return status;
+}
+
+/*
+*	Runs one core, one instruction at a time straight from shared memory
+*	(another core may write code at any time, so nothing is cached). An
+*	instruction that writes regs[0xF] still moves past itself afterwards,
+*	except the ones that jump, as in the engines.
+*/
+template <int AddrBits>
+typename MultiCoreT<AddrBits>::Status MultiCoreT<AddrBits>::execute(int id) {
+	Core & core = cores[id];
+	Word * regs = core.regs;
+
+	while (true) {
+		if (stopping.load(std::memory_order_relaxed)) return core.status; /* Another core ended the run */
+		if (core.steps >= stepLimit) return stop(id, Machine::outOfSteps);
+
+		const Word pc = regs[0xF];
+		unsigned char bytes[Machine::maxLength];
+		for (int index = 0; index < Machine::maxLength; ++index)
+			bytes[index] = load((Word)(pc + index));
+		typename Machine::Decoded in;
+		Machine::decodeBytes(bytes, in);
+		const Word a = in.a, b = in.b;
+		bool jumps = false;
+		++core.steps;
+
+		switch (in.opcode) {
+			case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			case 0x08: case 0x09: case 0x0A: case 0x0B: case 0x0C: case 0x0D: case 0x0E: case 0x0F: /* "movA val" */
+				regs[a] = in.imm1;
+				jumps = (a == 0xF);
+				break;
+			case 0x10: regs[a] = regs[b]; break; /* "mov AB" */
+			case 0x11: regs[a] = load(regs[b]); break;
+			case 0x12: store(regs[a], (unsigned char) regs[b]); break;
+			case 0x13: store(regs[a], load(regs[b])); break;
+			case 0x14: regs[a] = in.imm1, regs[b] = in.imm1; break; /* "mov AB val" */
+			case 0x15: regs[a] += b; break; /* "inc AB" */
+			case 0x16: regs[a] -= b; break; /* "dec AB" */
+			case 0x17: regs[a] = pc + b; break; /* "pco AB" */
+			case 0x18: regs[a] = pc - b; break;
+			case 0x19: { /* "cas AB", one step for every core */
+				Word address = regs[a];
+				unsigned char found = (unsigned char) regs[0x0];
+				if (regs[0x0] != found) found = mem[address].load(std::memory_order_seq_cst); /* Wider than a byte, never equal */
+				else mem[address].compare_exchange_strong(found, (unsigned char) regs[b], std::memory_order_seq_cst);
+				regs[0x0] = found;
+				break;
+			}
+			case 0x1A: { /* "xadd AB" */
+				Word address = regs[a];
+				regs[b] = mem[address].fetch_add((unsigned char) regs[b], std::memory_order_seq_cst);
+				break;
+			}
+			case 0x20: regs[a] &= regs[b]; break;
+			case 0x30: regs[a] |= regs[b]; break;
+			case 0x40: regs[a] ^= regs[b]; break;
+			case 0x50: regs[a] = regs[a] << (regs[b] & (AddrBits - 1)); break; /* "shl AB" */
+			case 0x51: regs[a] = regs[a] >> (regs[b] & (AddrBits - 1)); break; /* "shr AB" */
+			case 0x52: regs[a] = (regs[a] >> (AddrBits - (regs[b] & (AddrBits - 1)))) + (regs[a] << (regs[b] & (AddrBits - 1))); break; /* "rol AB" */
+			case 0x53: regs[a] = (regs[a] << (AddrBits - (regs[b] & (AddrBits - 1)))) + (regs[a] >> (regs[b] & (AddrBits - 1))); break; /* "ror AB" */
+			case 0x70: regs[0xF] = in.imm1, jumps = true; break; /* "jmp adr" */
+			case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: { /* Conditional jumps */
+				Word left = regs[a], right = regs[b];
+				bool taken = (in.opcode == 0x71)? left < right : (in.opcode == 0x72)? left <= right : (in.opcode == 0x73)? left == right
+					: (in.opcode == 0x74)? left >= right : (in.opcode == 0x75)? left > right : left != right;
+				if (taken) regs[0xF] = in.imm1, jumps = true;
+				break;
+			}
+			case 0x77: case 0x78: /* "skipIfNZ AB", "skipIfZ AB" */
+				if ((regs[a] != 0) == (in.opcode == 0x77)) regs[0xF] = pc + b + 2, jumps = true;
+				break;
+			case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: case 0x85: case 0x86: case 0x87:
+			case 0x88: case 0x89: case 0x8A: case 0x8B: case 0x8C: case 0x8D: case 0x8E: case 0x8F: /* "pushA" */
+				if (regs[0xE] < addrBytes) {
+					std::lock_guard<std::mutex> guard(outputLock);
+					print("\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", regs[a]);
+					return stop(id, Machine::faulted);
+				}
+				regs[0xE] -= addrBytes;
+				storeWord(regs[0xE], regs[a]);
+				break;
+			case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: case 0x97:
+			case 0x98: case 0x99: case 0x9A: case 0x9B: case 0x9C: case 0x9D: case 0x9E: case 0x9F: /* "popA" */
+				if (regs[0xE] >= n_mem - addrBytes) {
+					std::lock_guard<std::mutex> guard(outputLock);
+					print("\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", a);
+					return stop(id, Machine::faulted);
+				}
+				regs[a] = loadWord(regs[0xE]);
+				regs[0xE] += addrBytes;
+				jumps = (a == 0xF);
+				break;
+			case 0xA0: regs[a] += regs[b]; break;
+			case 0xA1: regs[a] = regs[b] + load(in.imm1); break;
+			case 0xA2: store(in.imm1, (unsigned char)(regs[a] + regs[b])); break;
+			case 0xA3: regs[a] = regs[b] + in.imm1; break;
+			case 0xA4: regs[a] = b * in.imm1; break; /* "lea AB val" */
+			case 0xA5: regs[a] = b + in.imm1; break;
+			case 0xA6: regs[a] = b * in.imm1 + in.imm2; break;
+			case 0xA7: regs[a] -= regs[b]; break;
+			case 0xA8: regs[a] = regs[b] - load(in.imm1); break;
+			case 0xA9: regs[a] = load(in.imm1) - regs[b]; break;
+			case 0xAA: store(in.imm1, (unsigned char)(regs[a] - regs[b])); break;
+			case 0xAB: regs[a] = regs[b] - in.imm1; break;
+			case 0xAC: regs[a] = in.imm1 - regs[b]; break;
+			case 0xC2: /* "call adr" */
+				if (regs[0xE] < addrBytes) {
+					std::lock_guard<std::mutex> guard(outputLock);
+					print(" 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", in.next1, (Word)(pc + 1 + addrBytes));
+					return stop(id, Machine::faulted);
+				}
+				regs[0xE] -= addrBytes;
+				storeWord(regs[0xE], pc + 1 + addrBytes);
+				regs[0xF] = in.imm1, jumps = true;
+				break;
+			case 0xC3: /* "ret" */
+				if (regs[0xE] >= n_mem - addrBytes) {
+					std::lock_guard<std::mutex> guard(outputLock);
+					print("\nSegmentation fault. At the edge of memory, unable to pop return address.\n");
+					return stop(id, Machine::faulted);
+				}
+				regs[0xF] = loadWord(regs[0xE]);
+				regs[0xE] += addrBytes;
+				jumps = true;
+				break;
+			case 0xD0: break; /* "nop" */
+			case 0xE0: { /* "putchar" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				output->put(regs[0x1]);
+				break;
+			}
+			case 0xE1: { /* "getchar" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				if (prompt) print("Enter an integer value (of a char): ");
+				output->flush();
+				int value;
+				if (!input->read(value)) value = 0;
+				regs[0x0] = (Word)(value % 256);
+				break;
+			}
+			case 0xE2: { /* "printstr char[],0", goes on after the 0 */
+				std::lock_guard<std::mutex> guard(outputLock);
+				unsigned char byte;
+				while ((byte = load(++regs[0xF])) != 0 && !stopping.load(std::memory_order_relaxed)) output->put(byte);
+				break;
+			}
+			case 0xE3: { /* "spawn adr", the first idle core */
+				int child = 0;
+				for (int other = 1; other < coreCount && child == 0; ++other) {
+					int expected = idle;
+					if (cores[other].state.compare_exchange_strong(expected, claimed, std::memory_order_acquire)) child = other;
+				}
+				if (child != 0) {
+					Core & spawned = cores[child];
+					memcpy(spawned.regs, regs, sizeof(spawned.regs));
+					spawned.regs[0x0] = child;
+					spawned.regs[0xE] = regs[0x1];
+					spawned.regs[0xF] = in.imm1;
+					spawned.status = Machine::running;
+					spawned.state.store(started, std::memory_order_release); /* Everything this core stored so far is seen by the child */
+				}
+				regs[0x0] = child;
+				break;
+			}
+			case 0xE4: { /* "join", waits for core regs[0x1] to exit */
+				Word other = regs[0x1], value = 0;
+				if (other != 0 && other != id && other < coreCount) {
+					Core & joined = cores[other];
+					int state;
+					while ((state = joined.state.load(std::memory_order_acquire)) == claimed || state == started) {
+						if (stopping.load(std::memory_order_relaxed)) {
+							--core.steps; /* Stopped on the join, as if it had not been fetched */
+							return core.status;
+						}
+						std::this_thread::yield();
+					}
+					int expected = done;
+					if (state == done) {
+						value = joined.regs[0x0]; /* Nobody writes it until the core is freed */
+						if (!joined.state.compare_exchange_strong(expected, idle, std::memory_order_acq_rel)) value = 0; /* Another join freed it first */
+					}
+				}
+				regs[0x0] = value;
+				break;
+			}
+			case 0xE8: case 0xE9: { /* "dumpRegs[0x0]", "dumpRegs[0x1]" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				printRegs(regs, in.opcode - 0xE8);
+				break;
+			}
+			case 0xEA: { /* "dumpMem" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				printMem(0, n_mem - 1);
+				break;
+			}
+			case 0xEB: { /* "dumpMemRange" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				printMem(regs[0x1], regs[0x2]);
+				break;
+			}
+			case 0xEC: { /* "dumpRegs" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				printRegs(regs, regs[0x1]);
+				break;
+			}
+			case 0xED: { /* "dump id": 0xFD everything, 0xFE memory, 0xFF registers, a register, or nothing */
+				std::lock_guard<std::mutex> guard(outputLock);
+				if (in.imm1 == 0xFD || in.imm1 == 0xFE) printMem(0, n_mem - 1);
+				if (in.imm1 == 0xFD || in.imm1 == 0xFF) printRegs(regs, 0xFF);
+				if (in.imm1 < n_regs) printRegs(regs, in.imm1);
+				break;
+			}
+			case 0xEE: return stop(id, Machine::exited); /* "exit" */
+			case 0xEF: { /* "fileDump" */
+				std::lock_guard<std::mutex> guard(outputLock);
+				fileDump(regs);
+				break;
+			}
+			default: {
+				std::lock_guard<std::mutex> guard(outputLock);
+				print("\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", in.opcode, pc);
+				return stop(id, Machine::faulted);
+			}
+		}
+
+		if (!jumps) regs[0xF] += in.length;
+	}
+}
+
+/* Host thread of a core other than 0: waits to be spawned, runs, and waits again until the run is over */
+template <int AddrBits>
+void MultiCoreT<AddrBits>::work(int id) {
+	Core & core = cores[id];
+	for (;;) {
+		while (core.state.load(std::memory_order_acquire) != started) {
+			if (closing.load(std::memory_order_acquire)) return;
+			std::this_thread::yield();
+		}
+		execute(id);
+		core.state.store(done, std::memory_order_release); /* Everything it stored is seen by the join */
+	}
+}
+
+/* Boots core 0 like ByteSyzed::boot and runs it on this thread, the other cores on their own */
+template <int AddrBits>
+typename MultiCoreT<AddrBits>::Status MultiCoreT<AddrBits>::run(void) {
+	if (coreCount < 1) coreCount = 1;
+	if (coreCount > maxCores) coreCount = maxCores;
+	for (int id = 0; id < maxCores; ++id) {
+		memset(cores[id].regs, 0, sizeof(cores[id].regs));
+		cores[id].state.store(idle, std::memory_order_relaxed);
+		cores[id].status = Machine::running;
+		cores[id].steps = 0;
+	}
+	Core & first = cores[0];
+	first.regs[0xF] = progStart;
+	first.regs[0xE] = n_mem - addrBytes;
+	storeWord(first.regs[0xE], progStart); /* Program start is stored at the bottom of the stack */
+	first.state.store(started, std::memory_order_relaxed);
+	stoppedByCore.store(-1);
+	stopping.store(false);
+	closing.store(false);
+
+	std::vector<std::thread> workers;
+	for (int id = 1; id < coreCount; ++id)
+		workers.push_back(std::thread(&MultiCoreT::work, this, id));
+	execute(0);
+	first.state.store(done, std::memory_order_release);
+	closing.store(true, std::memory_order_release);
+	for (int index = 0; index < (int) workers.size(); ++index)
+		workers[index].join();
+
+	output->flush();
+	stoppedBy = stoppedByCore.load();
+	status = cores[stoppedBy].status;
+	return status;
+}
+
+/* Instructions of every core in the last run */
+template <int AddrBits>
+unsigned long long MultiCoreT<AddrBits>::totalSteps(void) const {
+	unsigned long long total = 0;
+	for (int id = 0; id < maxCores; ++id) total += cores[id].steps;
+	return total;
+}
+
+template class MultiCoreT<8>;
+template class MultiCoreT<16>;
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*	MultiCore.h
+*
+*	ByteSyzed Multi-Core Header.
+*
+*	Several cores, each with its own registers and its own host thread,
+*	running on one shared memory image. Core 0 boots at progStart like
+*	ByteSyzed::boot. "spawn adr" (0xE3) starts a free core at adr with a
+*	copy of the caller's registers, its stack pointer set to the caller's
+*	regs[0x1], and regs[0x0] (in both) the new core's id, or 0 in the
+*	caller if every core is busy. "join" (0xE4) waits for core regs[0x1] to
+*	exit, then frees it and sets regs[0x0] to its regs[0x0]; a core that
+*	was never started, core 0 or the caller itself gives 0 at once. "cas
+*	AB" (0x19) and "xadd AB" (0x1A) are the atomics: compare and swap
+*	against regs[0x0], and fetch and add.
+*
+*	Memory ordering: every ordinary load is an acquire and every store a
+*	release, so a core that sees another core's store also sees all that
+*	core stored before it (no reordering of stores, as on x86). cas and
+*	xadd are sequentially consistent, one indivisible step all cores see
+*	in the same order. A spawn happens before the first instruction of the
+*	core it starts, and a core's exit before the join that frees it.
+*	Instructions are fetched from the same memory with no cache, so code
+*	one core writes runs on another once it sees the store.
+*
+*	Memory, spawn and join are lock-free: atomics on each byte and a state
+*	per core, waited on by spinning. Only output and getchar take a lock,
+*	as the host streams are shared. Runs are silent (no trace or profile),
+*	with the messages and dumps the engines print with verbose off.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include "ByteSyzed.h"
+#include <atomic>
+#include <mutex>
+
+template <int AddrBits>
+class MultiCoreT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+	typedef typename Machine::Status Status;
+	enum {n_regs=Machine::n_regs, n_mem=Machine::n_mem, addrBytes=Machine::addrBytes, maxCores=16};
+
+	/* Where a core is between spawn and join */
+	enum CoreState {
+		idle, /* Free for spawn */
+		claimed, /* A spawn is filling in its registers */
+		started, /* Running, or about to */
+		done /* Exited, or stopped, until a join frees it */
+	};
+
+	/* One core: its registers and how it stopped */
+	struct Core {
+		Word regs[n_regs];
+		std::atomic<int> state;
+		Status status; /* running if another core ended the run first */
+		unsigned long long steps; /* Instructions it executed in the run, every time it was spawned */
+	};
+
+	std::atomic<unsigned char> mem[n_mem]; /* Shared by every core */
+	Core cores[maxCores];
+	int coreCount = 4; /* Cores in the run, core 0 included, at most maxCores */
+	int stoppedBy = -1; /* Core whose exit (core 0), fault or step limit ended the last run */
+	Status status = Machine::running; /* Its status */
+
+	Word progStart = 0x00;
+	bool prompt = true; /* Prints "Enter an integer value" for getchar */
+	unsigned long long stepLimit = ~0ULL; /* Most instructions each core may run. One that reaches it ends the run with outOfSteps */
+	EmulatorOutput * output = &standardOutput; /* Program output, dumps and messages of every core */
+	EmulatorInput * input = &standardInput; /* Where getchar reads from, 0 once it runs out (no core waits for input) */
+	const char * dumpFileName = "debug.txt"; /* Written by fileDump with the dumping core's registers. NULL disables fileDump */
+	EmulatorOutput * dumpOutput = NULL; /* If set, fileDump writes here instead of dumpFileName */
+
+	MultiCoreT() { wipeMemory(); }
+	void wipeMemory(void); /* Zeroes memory and every core */
+	void load(const Machine & cpu); /* Copies the memory and progStart of a machine a program was loaded into */
+	void load(const unsigned char * image, int count, Word first); /* Zeroes memory and copies an image to first */
+	Status run(void); /* Boots core 0 and runs until it exits, or any core faults or reaches stepLimit. Returns status */
+	unsigned long long totalSteps(void) const; /* Instructions of every core in the last run */
+
+private:
+	std::atomic<bool> stopping, closing; /* Cores stop before their next instruction, worker threads return */
+	std::atomic<int> stoppedByCore; /* stoppedBy, claimed by the first core to end the run */
+	std::mutex outputLock; /* Around output, input and dumps */
+
+	void work(int id); /* Host thread of a core other than 0: runs it every time it is spawned */
+	Status execute(int id); /* Runs a core until it stops */
+	Status stop(int id, Status status); /* Stops a core, and the run unless it is a core other than 0 exiting */
+
+	unsigned char load(Word address) const { return mem[address].load(std::memory_order_acquire); }
+	void store(Word address, unsigned char value) { mem[address].store(value, std::memory_order_release); }
+	Word loadWord(Word address) const; /* A stack slot, addrBytes little endian bytes */
+	void storeWord(Word address, Word value);
+	void print(const char * format, ...); /* To output. Hold outputLock */
+	void printRegs(const Word * regs, Word id); /* As ByteSyzed::dumpRegs with verbose off */
+	void printMem(Word first, Word last); /* As ByteSyzed::dumpMemRange with verbose off */
+	void fileDump(const Word * regs);
+};
+
+typedef MultiCoreT<8> MultiCore;
+typedef MultiCoreT<16> MultiCore16;
+
+/* Built once in MultiCore.cpp */
+extern template class MultiCoreT<8>;
+extern template class MultiCoreT<16>;
+
+#endif
\ No newline at end of file
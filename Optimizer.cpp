@@ -0,0 +1,332 @@
+/*	Optimizer.cpp
+*
+*	ByteSyzed Peephole Optimizer Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Optimizer.h"
+#include <memory>
+#include <string.h>
+
+/* Copies an instruction (with its text, for printstr) and notes which operand holds a code address */
+template <int AddrBits>
+typename OptimizerT<AddrBits>::Op OptimizerT<AddrBits>::makeOp(const unsigned char * mem, Word address, const typename Machine::Decoded & in) const {
+	Op op;
+	op.link = Op::none;
+	op.target = 0;
+
+	int length = in.length;
+	if (in.opcode == 0xE2) { /* Its text and the 0 after it */
+		while (mem[(Word)(address + length)] != 0) ++length;
+		++length;
+	}
+	for (int index = 0; index < length; ++index)
+		op.bytes.push_back(mem[(Word)(address + index)]);
+
+	switch (in.opcode) {
+		case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0xC2: case 0xE3:
+			op.link = Op::address, op.target = in.imm1;
+			break;
+		case 0x77: case 0x78:
+			op.link = Op::skip, op.target = address + in.b + 2;
+			break;
+		case 0x0F:
+			op.link = Op::movF, op.target = in.imm1;
+			break;
+	}
+	return op;
+}
+
+/* A run of "mov1 val" and putchar, printing at least 3 known characters, becomes printstr with the characters, then one "mov1 val" for what regs[0x1] is left holding */
+template <int AddrBits>
+void OptimizerT<AddrBits>::rewriteStrings(std::vector<Op> & ops) {
+	for (int start = 0; start < (int) ops.size(); ++start) {
+		if (ops[start].bytes[0] != 0x01) continue;
+
+		std::vector<unsigned char> text;
+		int r1 = -1, last = -1, lastR1 = -1, oldSize = 0, size = 0;
+		for (int index = start; index < (int) ops.size(); ++index) {
+			unsigned char opcode = ops[index].bytes[0];
+			if (opcode == 0x01) r1 = ops[index].bytes[1];
+			else if (opcode == 0xE0 && r1 > 0) text.push_back((unsigned char) r1);
+			else break; /* Anything else, or a character printstr can't print */
+			size += (int) ops[index].bytes.size();
+			if (opcode == 0xE0) last = index, lastR1 = r1, oldSize = size;
+		}
+		if (text.size() < 3) continue;
+
+		/* regs[0x1] only needs setting if what follows does not set it first */
+		bool keepR1 = !(last + 1 < (int) ops.size() && ops[last + 1].bytes[0] == 0x01);
+		if ((int) text.size() + 2 + (keepR1? 2 : 0) >= oldSize) continue;
+
+		Op print;
+		print.link = Op::none, print.target = 0;
+		print.bytes.push_back(0xE2);
+		print.bytes.insert(print.bytes.end(), text.begin(), text.end());
+		print.bytes.push_back(0x00);
+		Op mov = print;
+		mov.bytes.assign(1, 0x01);
+		mov.bytes.push_back((unsigned char) lastR1);
+
+		ops.erase(ops.begin() + start, ops.begin() + last + 1);
+		if (keepR1) ops.insert(ops.begin() + start, mov);
+		ops.insert(ops.begin() + start, print);
+		++strings;
+	}
+}
+
+/* Consecutive "movA val", "inc AB", "dec AB" and "add AA val" on one register become a single one of them, or nothing if they add up to 0 */
+template <int AddrBits>
+void OptimizerT<AddrBits>::foldRegisters(std::vector<Op> & ops) {
+	/* Register an op sets or adds to, -1 if it is none of these. Sets constant, or value */
+	auto setter = [](const Op & op, bool & constant, Word & value) -> int {
+		unsigned char opcode = op.bytes[0];
+		if (opcode <= 0x0E) return constant = true, value = op.bytes[1], opcode;
+		if (opcode == 0x15) return constant = false, value = op.bytes[1] & 0xF, op.bytes[1] >> 4;
+		if (opcode == 0x16) return constant = false, value = (Word)(0 - (op.bytes[1] & 0xF)), op.bytes[1] >> 4;
+		if (opcode == 0xA3 && (op.bytes[1] >> 4) == (op.bytes[1] & 0xF)) return constant = false, value = op.bytes[2], op.bytes[1] >> 4;
+		return -1;
+	};
+
+	for (int start = 0; start < (int) ops.size(); ++start) {
+		bool constant, nextConstant;
+		Word value, next;
+		int reg = setter(ops[start], constant, value);
+		if (reg < 0) continue;
+
+		int end = start + 1, oldSize = (int) ops[start].bytes.size();
+		for (; end < (int) ops.size() && setter(ops[end], nextConstant, next) == reg; ++end) {
+			if (nextConstant) constant = true, value = next;
+			else value += next;
+			oldSize += (int) ops[end].bytes.size();
+		}
+		if (end - start < 2) continue;
+
+		Op op;
+		op.link = Op::none, op.target = 0;
+		if (constant && value <= 0xFF) { /* "movA val" */
+			op.bytes.push_back((unsigned char) reg);
+			op.bytes.push_back((unsigned char) value);
+		} else if (!constant && value != 0 && value <= 0xF) { /* "inc AB" */
+			op.bytes.push_back(0x15);
+			op.bytes.push_back((unsigned char)((reg << 4) | value));
+		} else if (!constant && value != 0 && (Word)(0 - value) <= 0xF) { /* "dec AB" */
+			op.bytes.push_back(0x16);
+			op.bytes.push_back((unsigned char)((reg << 4) | (Word)(0 - value)));
+		} else if (!constant && value != 0 && value <= 0xFF) { /* "add AA val" */
+			op.bytes.push_back(0xA3);
+			op.bytes.push_back((unsigned char)((reg << 4) | reg));
+			op.bytes.push_back((unsigned char) value);
+		} else if (constant || value != 0) {
+			continue; /* A constant too wide for one instruction */
+		}
+
+		ops.erase(ops.begin() + start, ops.begin() + end);
+		if (!op.bytes.empty()) ops.insert(ops.begin() + start, op);
+		folded += end - start - (op.bytes.empty()? 0 : 1);
+		if (op.bytes.empty()) --start; /* Something before may fold with what follows now */
+	}
+}
+
+/* Gives every op its new address from first, then aims every link at where its target went */
+template <int AddrBits>
+bool OptimizerT<AddrBits>::layOut(std::vector<Block> & blocks, EmulatorOutput * messages) {
+	enum {n_mem=Machine::n_mem, addrBytes=Machine::addrBytes};
+	std::vector<int> moved(n_mem, -1); /* New address of every block, by original address */
+	std::vector<std::vector<int> > at(blocks.size()); /* New address of every op */
+	int address = first;
+	for (int block = 0; block < (int) blocks.size(); ++block) {
+		moved[blocks[block].first] = address;
+		for (int index = 0; index < (int) blocks[block].ops.size(); ++index) {
+			at[block].push_back(address);
+			address += (int) blocks[block].ops[index].bytes.size();
+		}
+	}
+	if (address > n_mem) {
+		messages->print("Not optimized: the program would not fit in memory.\n");
+		return false;
+	}
+
+	program.clear();
+	for (int block = 0; block < (int) blocks.size(); ++block) {
+		for (int index = 0; index < (int) blocks[block].ops.size(); ++index) {
+			Op & op = blocks[block].ops[index];
+			int target = moved[op.target], from = at[block][index];
+			if (op.link != Op::none && target < 0) {
+				messages->print("Not optimized: 0x%02X aims at 0x%02X, which starts no block.\n", from, op.target);
+				return false;
+			}
+			if (op.link == Op::address) {
+				int position = (op.bytes[0] == 0x70 || op.bytes[0] == 0xC2 || op.bytes[0] == 0xE3)? 1 : 2;
+				for (int byte = 0; byte < addrBytes; ++byte)
+					op.bytes[position + byte] = (unsigned char)(target >> (8 * byte));
+			} else if (op.link == Op::movF) {
+				if (target > 0xFF) {
+					messages->print("Not optimized: \"movF val\" at 0x%02X can't reach 0x%02X.\n", from, target);
+					return false;
+				}
+				op.bytes[1] = (unsigned char) target;
+			} else if (op.link == Op::skip) {
+				int skipped = target - (from + 2);
+				if (skipped < 0 || skipped > 0xF) {
+					messages->print("Not optimized: the skip at 0x%02X can't reach 0x%02X.\n", from, target);
+					return false;
+				}
+				op.bytes[1] = (unsigned char)((op.bytes[1] & 0xF0) | skipped);
+			}
+			program.insert(program.end(), op.bytes.begin(), op.bytes.end());
+		}
+	}
+	entry = (Word) moved[entryBefore];
+	return true;
+}
+
+/* Rewrites the program loaded count bytes from first. Leaves it alone, saying why, unless every byte it reads, writes and jumps to is known without running it */
+template <int AddrBits>
+bool OptimizerT<AddrBits>::optimize(const unsigned char * mem, Word entryPoint, Word firstByte, int count, EmulatorOutput * messages) {
+	typedef AnalyzerT<AddrBits> Analyzer;
+	std::unique_ptr<Analyzer> analyzer(new Analyzer()); /* Heap, it is as big as memory a few times over */
+	analyzer->analyze(mem, entryPoint, firstByte, count);
+	first = firstByte, entry = entryBefore = entryPoint, countBefore = count;
+	stackLowest = analyzer->stackLowest;
+	instructionsBefore = instructionsAfter = strings = folded = nops = deadBytes = 0;
+	program.assign(mem + first, mem + first + count);
+
+	if (!analyzer->findings.empty()) {
+		messages->print("Not optimized: the analyzer reports a problem at 0x%02X (see --analyze).\n", analyzer->findings[0].address);
+		return false;
+	}
+	for (int address = 0; address < Machine::n_mem; ++address) {
+		bool inside = first <= address && address < first + count;
+		if (analyzer->role[address] != Analyzer::unreached && !inside) {
+			messages->print("Not optimized: code at 0x%02X is outside the program.\n", address);
+			return false;
+		}
+		if (analyzer->role[address] == Analyzer::unreached && inside) ++deadBytes;
+	}
+
+	std::vector<Block> blocks;
+	for (int index = 0; index < (int) analyzer->blocks.size(); ++index) {
+		const typename Analyzer::Block & from = analyzer->blocks[index];
+		Block block;
+		block.first = from.first;
+
+		/* Only falling into the block after it is kept by the layout */
+		bool fallsThrough = false;
+		Word end = from.first + from.length;
+		for (int next = 0; next < (int) from.successors.size(); ++next)
+			fallsThrough |= from.successors[next] == end;
+		if (fallsThrough && (index + 1 == (int) analyzer->blocks.size() || analyzer->blocks[index + 1].first != end)) {
+			messages->print("Not optimized: the block at 0x%02X runs off the end of memory.\n", from.first);
+			return false;
+		}
+
+		Word address = from.first;
+		for (int count = 0; count < from.instructions; ++count) {
+			unsigned char bytes[Machine::maxLength];
+			for (int byte = 0; byte < Machine::maxLength; ++byte)
+				bytes[byte] = mem[(Word)(address + byte)];
+			typename Machine::Decoded in;
+			Machine::decodeBytes(bytes, in);
+
+			/* Anything that sees addresses or bytes of the program would see them move */
+			const int fields = Machine::registerFields(in.opcode);
+			const char * problem = NULL;
+			if (((fields & Machine::readsA) && in.a == 0xF) || ((fields & Machine::readsB) && in.b == 0xF) || in.opcode == 0x17 || in.opcode == 0x18)
+				problem = "reads the program counter";
+			else if ((((fields & Machine::writesA) && in.a == 0xF) || ((fields & Machine::writesB) && in.b == 0xF)) && in.opcode != 0x0F)
+				problem = "computes a jump";
+			else if (in.opcode == 0x11 || in.opcode == 0x12 || in.opcode == 0x13 || in.opcode == 0x19 || in.opcode == 0x1A)
+				problem = "reads or writes memory through a register";
+			else if (Machine::takesAddress(in.opcode) && in.opcode >= 0xA0 && first <= in.imm1 && in.imm1 < first + count)
+				problem = "reads or writes its own bytes";
+			else if ((fields & Machine::showsRegs) && in.opcode != 0xE8 && in.opcode != 0xE9)
+				problem = "dumps memory or the program counter";
+			if (problem != NULL) {
+				messages->print("Not optimized: 0x%02X %s.\n", address, problem);
+				return false;
+			}
+
+			++instructionsBefore;
+			Op op = makeOp(mem, address, in);
+			address += (Word) op.bytes.size();
+			if (in.opcode == 0xD0) ++nops; /* Nothing to run */
+			else block.ops.push_back(op);
+		}
+
+		rewriteStrings(block.ops);
+		foldRegisters(block.ops);
+		instructionsAfter += (int) block.ops.size();
+		blocks.push_back(block);
+	}
+
+	if (!layOut(blocks, messages)) {
+		program.assign(mem + first, mem + first + count);
+		entry = entryBefore;
+		instructionsAfter = instructionsBefore;
+		return false;
+	}
+	return true;
+}
+
+/* Runs one program in a machine of its own, silently */
+template <int AddrBits>
+static void runProgram(ByteSyzedT<AddrBits> & cpu, MemoryOutput & output, const char * input, unsigned long long maxSteps) {
+	QueueInput numbers;
+	numbers.push(input);
+	cpu.input = &numbers, cpu.output = &output;
+	cpu.verbose = false, cpu.prompt = false;
+	cpu.dumpFileName = NULL;
+	cpu.boot();
+	cpu.step(maxSteps);
+	output.flush();
+}
+
+/* Runs the original (in mem) and the rewritten program on the same input and compares their output, how they stopped, their registers (but the program counter) and their memory outside the program and the stack. The rewritten one runs on wiped memory holding only the bytes that get saved, so anything the original needs from outside them shows */
+template <int AddrBits>
+bool OptimizerT<AddrBits>::verify(const unsigned char * mem, const char * input, unsigned long long maxSteps, EmulatorOutput * messages) const {
+	std::unique_ptr<Machine> before(new Machine()), after(new Machine()); /* Heap, they are a few kilobytes (megabytes when wide) */
+	MemoryOutput beforeOutput, afterOutput;
+	memcpy(before->mem, mem, Machine::n_mem);
+	memset(after->mem, 0, Machine::n_mem);
+	memcpy(after->mem + first, program.data(), program.size());
+	memset(before->regs, 0, sizeof(before->regs));
+	memset(after->regs, 0, sizeof(after->regs));
+	before->progStart = entryBefore, after->progStart = entry;
+
+	runProgram(*before, beforeOutput, input, maxSteps);
+	runProgram(*after, afterOutput, input, maxSteps);
+
+	if (before->status == Machine::outOfSteps) {
+		messages->print("Not verified: the original program did not stop within %llu instructions.\n", maxSteps);
+		return false;
+	}
+	const char * difference = NULL;
+	if (before->status != after->status) difference = "they stop differently";
+	else if (beforeOutput.text() != afterOutput.text()) difference = "the output differs";
+	else if (memcmp(before->regs, after->regs, 0xF * sizeof(before->regs[0])) != 0) difference = "the registers differ";
+	for (int address = 0; address < stackLowest && difference == NULL; ++address) {
+		bool program = first <= address && address < first + (int) std::max<size_t>(countBefore, this->program.size());
+		if (!program && before->mem[address] != after->mem[address]) difference = "memory differs";
+	}
+	if (difference != NULL) {
+		messages->print("Verification failed: %s.\n", difference);
+		return false;
+	}
+
+	messages->print("Verified: same output, status, registers and memory. %llu instructions executed before, %llu after.\n", before->steps, after->steps);
+	return true;
+}
+
+/* Prints what changed */
+template <int AddrBits>
+void OptimizerT<AddrBits>::report(EmulatorOutput & out) const {
+	out.print("Optimized: %i bytes to %i, %i instructions to %i\n", countBefore, (int) program.size(), instructionsBefore, instructionsAfter);
+	out.print(" %i printstr runs, %i instructions folded, %i nops and %i unreached bytes dropped\n", strings, folded, nops, deadBytes);
+	if (entry != entryBefore) out.print(" Entry point moved from 0x%02X to 0x%02X\n", entryBefore, entry);
+}
+
+template class OptimizerT<8>;
+template class OptimizerT<16>;
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*	Optimizer.h
+*
+*	ByteSyzed Peephole Optimizer Header.
+*
+*	Rewrites a program into a shorter one that does the same: runs of
+*	"movA val" and putchar become one printstr, chains of mov, inc and dec
+*	on one register fold into one instruction, nops and code that is never
+*	reached go away, and every jump, skip and call is pointed at where its
+*	target moved. The static analyzer decides what is safe, so a program
+*	whose code could be read as data or reached through a computed address
+*	is left as it is.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "Analyzer.h"
+#include <vector>
+
+template <int AddrBits>
+class OptimizerT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+
+	std::vector<unsigned char> program; /* The rewritten program, loaded at first */
+	Word first, entry; /* Where it loads and where it starts (its entry point moved with its code) */
+	Word entryBefore, stackLowest; /* The original entry point, and the lowest byte the analyzer says the stack reaches */
+	int countBefore; /* Bytes of the original program */
+	int instructionsBefore, instructionsAfter; /* Reachable instructions */
+	int strings, folded, nops, deadBytes; /* printstr runs made, instructions folded away, nops and unreached bytes dropped */
+
+	bool optimize(const unsigned char * mem, Word entry, Word first, int count, EmulatorOutput * messages = &standardOutput); /* Rewrites the program loaded count bytes from first. False (and why, in messages) if it can't be done safely */
+	bool optimize(const Machine & cpu, EmulatorOutput * messages = &standardOutput) { return optimize(cpu.mem, cpu.progStart, cpu.loadedFirst, cpu.loadedCount, messages); } /* A program loadFromFile just loaded, from where it loaded */
+	bool verify(const unsigned char * mem, const char * input, unsigned long long maxSteps, EmulatorOutput * messages = &standardOutput) const; /* Runs the original (in mem) and the rewritten program (alone on wiped memory) on the same input and compares how they end */
+	void report(EmulatorOutput & out) const; /* Prints what changed */
+
+private:
+	/* An instruction of the rewritten program */
+	struct Op {
+		std::vector<unsigned char> bytes;
+		enum {none, address, movF, skip} link; /* Operand that holds a code address, re-aimed once the code is laid out */
+		Word target; /* Original address it aims at */
+	};
+	struct Block {
+		Word first; /* Original address */
+		std::vector<Op> ops;
+	};
+
+	Op makeOp(const unsigned char * mem, Word address, const typename Machine::Decoded & in) const;
+	void rewriteStrings(std::vector<Op> & ops);
+	void foldRegisters(std::vector<Op> & ops);
+	bool layOut(std::vector<Block> & blocks, EmulatorOutput * messages); /* Addresses every op, then aims every link */
+};
+
+typedef OptimizerT<8> Optimizer;
+typedef OptimizerT<16> Optimizer16;
+
+/* Built once in Optimizer.cpp */
+extern template class OptimizerT<8>;
+extern template class OptimizerT<16>;
+
+#endif
\ No newline at end of file
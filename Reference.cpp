@@ -0,0 +1,277 @@
+/*	Reference.cpp
+*
+*	ByteSyzed Reference Model Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Reference.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+template <int AddrBits>
+void ReferenceT<AddrBits>::boot(Word progStart) {
+	for (int index = 0; index < n_regs; ++index) regs[index] = 0;
+	regs[0xF] = progStart;
+	regs[0xE] = n_mem - addrBytes;
+	store(regs[0xE], progStart);
+	status = Machine::running;
+	steps = 0;
+	endless = false;
+	output.clear();
+	dumpText.clear();
+	inputNext = 0;
+}
+
+template <int AddrBits>
+typename ReferenceT<AddrBits>::Word ReferenceT<AddrBits>::addressAt(Word pc, int offset) const {
+	Word value = 0;
+	for (int index = 0; index < addrBytes; ++index)
+		value |= (Word)(byteAt(pc, offset + index) << (8 * index));
+	return value;
+}
+
+template <int AddrBits>
+typename ReferenceT<AddrBits>::Word ReferenceT<AddrBits>::load(Word address) const {
+	Word value = 0;
+	for (int index = 0; index < addrBytes; ++index)
+		value |= (Word)(mem[(Word)(address + index)] << (8 * index));
+	return value;
+}
+
+template <int AddrBits>
+void ReferenceT<AddrBits>::store(Word address, Word value) {
+	for (int index = 0; index < addrBytes; ++index)
+		mem[(Word)(address + index)] = (unsigned char)(value >> (8 * index));
+}
+
+template <int AddrBits>
+void ReferenceT<AddrBits>::print(const char * format, ...) {
+	char buffer[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	output.append(buffer, length);
+}
+
+/* One register if id names one, else all of them */
+template <int AddrBits>
+void ReferenceT<AddrBits>::printRegs(Word id) {
+	if (id < n_regs) {
+		print("regs[0x%01X] = 0x%02X\n", id, regs[id]);
+		return;
+	}
+	for (int index = 0; index < n_regs; ++index)
+		print("0x%01X : 0x%02X\n", index, regs[index]);
+}
+
+/* Up from first to last, then down from first to last, so a single byte (first == last) shows twice */
+template <int AddrBits>
+void ReferenceT<AddrBits>::printMem(Word first, Word last) {
+	for (int index = first; index <= last; ++index)
+		print("0x%02X : 0x%02X\n", index, mem[index]);
+	for (int index = first; index >= last; --index)
+		print("0x%02X : 0x%02X\n", index, mem[index]);
+}
+
+/*
+*	Runs one instruction at a time, as the opcode table describes it.
+*	regs[0xF] holds the address of the instruction while it runs. An
+*	instruction that writes regs[0xF] still moves past itself afterwards,
+*	except the ones that jump: "movF val", "popF", jumps, taken skips, call
+*	and ret. Operands are read before the instruction writes anything.
+*/
+template <int AddrBits>
+typename ReferenceT<AddrBits>::Status ReferenceT<AddrBits>::run(unsigned long long maxSteps) {
+	while (status == Machine::running) {
+		if (steps >= maxSteps) return status = Machine::outOfSteps;
+
+		const Word pc = regs[0xF];
+		const unsigned char opcode = byteAt(pc, 0);
+		const unsigned char ab = byteAt(pc, 1);
+		const int a = ab >> 4, b = ab & 0xF; /* Register fields of most instructions */
+		const int r = opcode & 0xF; /* Register of "movA val", "pushA" and "popA" */
+		const int shift = regs[b] % AddrBits; /* Shift and rotate amount */
+		int length; /* Bytes to move past, when the instruction does not jump */
+		bool jumps = false;
+		++steps;
+
+		switch (opcode) {
+			case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			case 0x08: case 0x09: case 0x0A: case 0x0B: case 0x0C: case 0x0D: case 0x0E: case 0x0F: /* "movA val" */
+				regs[r] = ab;
+				length = 2, jumps = (r == 0xF);
+				break;
+			case 0x10: regs[a] = regs[b]; length = 2; break; /* "mov AB" */
+			case 0x11: regs[a] = mem[regs[b]]; length = 2; break;
+			case 0x12: mem[regs[a]] = (unsigned char) regs[b]; length = 2; break;
+			case 0x13: mem[regs[a]] = mem[regs[b]]; length = 2; break;
+			case 0x14: { /* "mov AB val" */
+				unsigned char value = byteAt(pc, 2);
+				regs[a] = value, regs[b] = value;
+				length = 3;
+				break;
+			}
+			case 0x15: regs[a] += b; length = 2; break; /* "inc AB" */
+			case 0x16: regs[a] -= b; length = 2; break; /* "dec AB" */
+			case 0x17: regs[a] = pc + b; length = 2; break; /* "pco AB" */
+			case 0x18: regs[a] = pc - b; length = 2; break;
+			case 0x19: { /* "cas AB": the byte at regs[a] becomes regs[b] if it equals regs[0x0], regs[0x0] gets what it was */
+				Word address = regs[a];
+				unsigned char found = mem[address];
+				if (found == regs[0x0]) mem[address] = (unsigned char) regs[b];
+				regs[0x0] = found;
+				length = 2;
+				break;
+			}
+			case 0x1A: { /* "xadd AB": regs[b] is added to the byte at regs[a], regs[b] gets what it was */
+				Word address = regs[a];
+				unsigned char found = mem[address];
+				mem[address] = (unsigned char)(found + regs[b]);
+				regs[b] = found;
+				length = 2;
+				break;
+			}
+			case 0x20: regs[a] &= regs[b]; length = 2; break;
+			case 0x30: regs[a] |= regs[b]; length = 2; break;
+			case 0x40: regs[a] ^= regs[b]; length = 2; break;
+			case 0x50: regs[a] = (Word)((unsigned long) regs[a] << shift); length = 2; break; /* "shl AB" */
+			case 0x51: regs[a] = (Word)((unsigned long) regs[a] >> shift); length = 2; break; /* "shr AB" */
+			case 0x52: regs[a] = (Word)(((unsigned long) regs[a] >> (AddrBits - shift)) + ((unsigned long) regs[a] << shift)); length = 2; break; /* "rol AB" */
+			case 0x53: regs[a] = (Word)(((unsigned long) regs[a] << (AddrBits - shift)) + ((unsigned long) regs[a] >> shift)); length = 2; break; /* "ror AB" */
+			case 0x70: regs[0xF] = addressAt(pc, 1); length = 0, jumps = true; break; /* "jmp adr" */
+			case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: { /* Conditional jumps */
+				Word left = regs[a], right = regs[b];
+				bool taken = (opcode == 0x71)? left < right : (opcode == 0x72)? left <= right : (opcode == 0x73)? left == right
+					: (opcode == 0x74)? left >= right : (opcode == 0x75)? left > right : left != right;
+				length = 2 + addrBytes;
+				if (taken) regs[0xF] = addressAt(pc, 2), jumps = true;
+				break;
+			}
+			case 0x77: case 0x78: /* "skipIfNZ AB", "skipIfZ AB" */
+				length = 2;
+				if ((regs[a] != 0) == (opcode == 0x77)) regs[0xF] = pc + b + 2, jumps = true;
+				break;
+			case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: case 0x85: case 0x86: case 0x87:
+			case 0x88: case 0x89: case 0x8A: case 0x8B: case 0x8C: case 0x8D: case 0x8E: case 0x8F: /* "pushA" */
+				if (regs[0xE] < addrBytes) {
+					print("\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", regs[r]);
+					return fault();
+				}
+				regs[0xE] -= addrBytes; /* "pushE" pushes the lowered stack pointer */
+				store(regs[0xE], regs[r]);
+				length = 1;
+				break;
+			case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: case 0x97:
+			case 0x98: case 0x99: case 0x9A: case 0x9B: case 0x9C: case 0x9D: case 0x9E: case 0x9F: /* "popA" */
+				if (regs[0xE] >= n_mem - addrBytes) {
+					print("\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", r);
+					return fault();
+				}
+				regs[r] = load(regs[0xE]);
+				regs[0xE] += addrBytes; /* "popE" ends up addrBytes above the popped value */
+				length = 1, jumps = (r == 0xF);
+				break;
+			case 0xA0: regs[a] += regs[b]; length = 2; break;
+			case 0xA1: regs[a] = regs[b] + mem[addressAt(pc, 2)]; length = 2 + addrBytes; break;
+			case 0xA2: { /* "add adr AB", the registers follow the address */
+				unsigned char registers = byteAt(pc, 1 + addrBytes);
+				mem[addressAt(pc, 1)] = (unsigned char)(regs[registers >> 4] + regs[registers & 0xF]);
+				length = 2 + addrBytes;
+				break;
+			}
+			case 0xA3: regs[a] = regs[b] + byteAt(pc, 2); length = 3; break;
+			case 0xA4: regs[a] = b * byteAt(pc, 2); length = 3; break; /* "lea AB val" */
+			case 0xA5: regs[a] = b + byteAt(pc, 2); length = 3; break;
+			case 0xA6: regs[a] = b * byteAt(pc, 2) + byteAt(pc, 3); length = 4; break;
+			case 0xA7: regs[a] -= regs[b]; length = 2; break;
+			case 0xA8: regs[a] = regs[b] - mem[addressAt(pc, 2)]; length = 2 + addrBytes; break;
+			case 0xA9: regs[a] = mem[addressAt(pc, 2)] - regs[b]; length = 2 + addrBytes; break;
+			case 0xAA: { /* "sub adr AB", the registers follow the address */
+				unsigned char registers = byteAt(pc, 1 + addrBytes);
+				mem[addressAt(pc, 1)] = (unsigned char)(regs[registers >> 4] - regs[registers & 0xF]);
+				length = 2 + addrBytes;
+				break;
+			}
+			case 0xAB: regs[a] = regs[b] - byteAt(pc, 2); length = 3; break;
+			case 0xAC: regs[a] = byteAt(pc, 2) - regs[b]; length = 3; break;
+			case 0xC2: { /* "call adr" */
+				Word target = addressAt(pc, 1), back = pc + 1 + addrBytes;
+				if (regs[0xE] < addrBytes) {
+					print(" 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", ab, back);
+					return fault();
+				}
+				regs[0xE] -= addrBytes;
+				store(regs[0xE], back);
+				regs[0xF] = target;
+				length = 0, jumps = true;
+				break;
+			}
+			case 0xC3: /* "ret" */
+				if (regs[0xE] >= n_mem - addrBytes) {
+					print("\nSegmentation fault. At the edge of memory, unable to pop return address.\n");
+					return fault();
+				}
+				regs[0xF] = load(regs[0xE]);
+				regs[0xE] += addrBytes;
+				length = 0, jumps = true;
+				break;
+			case 0xD0: length = 1; break; /* "nop" */
+			case 0xE0: output += (char) regs[0x1]; length = 1; break; /* "putchar" */
+			case 0xE1: { /* "getchar" */
+				int value = (inputNext < input.size())? input[inputNext++] : 0;
+				regs[0x0] = (Word)(value % 256);
+				length = 1;
+				break;
+			}
+			case 0xE2: { /* "printstr char[],0", goes on after the 0 */
+				bool terminated = false;
+				for (int index = 0; index < n_mem && !terminated; ++index) terminated = (mem[index] == 0);
+				if (!terminated) {
+					--steps;
+					endless = true;
+					return status; /* Still running, as far as the engines can tell */
+				}
+				Word at = pc + 1;
+				for (; mem[at] != 0; ++at) output += (char) mem[at];
+				regs[0xF] = at + 1;
+				length = 0, jumps = true;
+				break;
+			}
+			case 0xE3: regs[0x0] = 0; length = 1 + addrBytes; break; /* "spawn adr", no second core to start */
+			case 0xE4: regs[0x0] = 0; length = 1; break; /* "join", no second core to wait for */
+			case 0xE8: printRegs(0x0); length = 1; break; /* "dumpRegs[0x0]" */
+			case 0xE9: printRegs(0x1); length = 1; break; /* "dumpRegs[0x1]" */
+			case 0xEA: printMem(0, n_mem - 1); length = 1; break; /* "dumpMem" */
+			case 0xEB: printMem(regs[0x1], regs[0x2]); length = 1; break; /* "dumpMemRange" */
+			case 0xEC: printRegs(regs[0x1]); length = 1; break; /* "dumpRegs" */
+			case 0xED: /* "dump id": 0xFD everything, 0xFE memory, 0xFF registers, a register, or nothing */
+				if (ab == 0xFD || ab == 0xFE) printMem(0, n_mem - 1);
+				if (ab == 0xFD || ab == 0xFF) printRegs(0xFF);
+				if (ab < n_regs) printRegs(ab);
+				length = 2;
+				break;
+			case 0xEE: return status = Machine::exited; /* "exit" */
+			case 0xEF: { /* "fileDump" */
+				char line[16];
+				for (int index = 0; index < n_mem; ++index)
+					dumpText.append(line, snprintf(line, sizeof(line), "%02X\n", mem[index]));
+				for (int index = 0; index < n_regs; ++index)
+					dumpText.append(line, snprintf(line, sizeof(line), "%02X\n", regs[index]));
+				length = 1;
+				break;
+			}
+			default:
+				print("\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", opcode, pc);
+				return fault();
+		}
+
+		if (!jumps) regs[0xF] += length;
+	}
+	return status;
+}
+
+template class ReferenceT<8>;
+template class ReferenceT<16>;
\ No newline at end of file
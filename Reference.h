@@ -0,0 +1,63 @@
+/*	Reference.h
+*
+*	ByteSyzed Reference Model Header.
+*
+*	A second, deliberately plain implementation of the instruction set,
+*	written from the opcode table in README.md rather than from the
+*	engines: one instruction at a time, operands read straight from memory,
+*	no caches, no translation. It is slow and meant to stay obviously
+*	right, so the engines can be checked against it (see fuzzEngines.cpp).
+*	Output, dumps and fault messages are the text the engines print with
+*	verbose and prompt off.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include "ByteSyzed.h"
+#include <string>
+#include <vector>
+
+template <int AddrBits>
+class ReferenceT {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+	typedef typename Machine::Status Status;
+	enum {n_regs=Machine::n_regs, n_mem=Machine::n_mem, addrBytes=Machine::addrBytes};
+
+	Word regs[n_regs];
+	unsigned char mem[n_mem];
+	Status status;
+	unsigned long long steps; /* Instructions executed, counting the one that faulted or exited */
+	bool endless; /* Stopped on a printstr with no 0 anywhere in memory, which the engines would print forever */
+	std::string output; /* putchar, printstr, dumps and fault messages */
+	std::string dumpText; /* Every fileDump, in the format of ByteSyzed::fileDump */
+	std::vector<int> input; /* Numbers getchar reads, 0 once they run out */
+	size_t inputNext;
+
+	void boot(Word progStart); /* Same start as ByteSyzed::boot. Load mem (and input) first */
+	Status run(unsigned long long maxSteps); /* Runs at most maxSteps instructions */
+
+private:
+	unsigned char byteAt(Word pc, int offset) const { return mem[(Word)(pc + offset)]; }
+	Word addressAt(Word pc, int offset) const; /* addrBytes little endian bytes of the instruction at pc */
+	Word load(Word address) const; /* A stack slot */
+	void store(Word address, Word value);
+	void print(const char * format, ...);
+	void printRegs(Word id);
+	void printMem(Word first, Word last);
+	Status fault(void) { return status = Machine::faulted; }
+};
+
+typedef ReferenceT<8> Reference;
+typedef ReferenceT<16> Reference16;
+
+/* Built once in Reference.cpp */
+extern template class ReferenceT<8>;
+extern template class ReferenceT<16>;
+
+#endif
\ No newline at end of file
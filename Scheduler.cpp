@@ -0,0 +1,265 @@
+/*	Scheduler.cpp
+*
+*	ByteSyzed Machine Scheduler Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Scheduler.h"
+#if !defined(_WIN32)
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Makes a descriptor non-blocking, so reads and writes return instead of waiting */
+static void setNonBlocking(int fd) {
+	int flags = fcntl(fd, F_GETFL);
+	if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/* Adds a machine continuing from a snapshot */
+int Scheduler::add(const ByteSyzed::Snapshot & start, int inputFd, int outputFd) {
+	std::unique_ptr<Machine> machine(new Machine());
+	machine->state = start;
+	machine->state.inputPosition = -1; /* A descriptor is read once, there is nowhere to seek back to */
+	machine->status = ByteSyzed::running;
+	machine->inputFd = inputFd, machine->outputFd = outputFd;
+	machine->inputEnded = false;
+	machine->carried = 0;
+	setNonBlocking(inputFd);
+	setNonBlocking(outputFd);
+
+	machines.push_back(std::move(machine));
+	return size() - 1;
+}
+
+/* Adds a booted machine with a byte image loaded at progStart */
+int Scheduler::add(const unsigned char * image, int count, int inputFd, int outputFd, unsigned char progStart) {
+	std::unique_ptr<ByteSyzed> cpu(new ByteSyzed()); /* Heap, it is a few kilobytes */
+	MemoryOutput messages;
+	QueueInput none;
+	cpu->output = &messages, cpu->input = &none;
+	cpu->progStart = progStart;
+	if (!cpu->loadFromMemory(image, count)) return -1;
+	cpu->boot();
+
+	ByteSyzed::Snapshot start;
+	cpu->saveSnapshot(start);
+	return add(start, inputFd, outputFd);
+}
+
+namespace {
+	/* getchar's input during a machine's turn: numbers from its inputFd, read without ever waiting */
+	class DescriptorInput : public EmulatorInput {
+	public:
+		Scheduler::Machine * machine = NULL;
+
+		/* True once carry holds a whole number (one followed by whitespace) or nothing more can come */
+		bool ready(void) {
+			Scheduler::Machine & m = *machine;
+			for (;;) {
+				if (m.inputEnded || m.carried == sizeof(m.carry) || wholeNumber(m)) return true;
+				ssize_t count = ::read(m.inputFd, m.carry + m.carried, sizeof(m.carry) - m.carried);
+				if (count > 0) m.carried += count;
+				else if (count < 0 && errno == EINTR) continue;
+				else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+				else m.inputEnded = true; /* End of file, or an error that will not go away */
+			}
+		}
+
+		/* Takes the first number out of carry, like QueueInput::push reads them. Something that is not a number is dropped and reads as none */
+		bool read(int & value) {
+			Scheduler::Machine & m = *machine;
+			if (!ready()) return false;
+
+			int first = 0;
+			while (first < m.carried && isspace((unsigned char) m.carry[first])) ++first;
+			char text[sizeof(m.carry) + 1];
+			memcpy(text, m.carry + first, m.carried - first);
+			text[m.carried - first] = '\0';
+
+			char * end;
+			long number = strtol(text, &end, 0);
+			int used = (int)(end - text);
+			if (used == 0)
+				while (text[used] != '\0' && !isspace((unsigned char) text[used])) ++used;
+
+			m.carried -= first + used;
+			memmove(m.carry, m.carry + first + used, m.carried);
+			if (end == text) return false;
+			value = (int) number;
+			return true;
+		}
+
+	private:
+		static bool wholeNumber(const Scheduler::Machine & m) {
+			int index = 0;
+			while (index < m.carried && isspace((unsigned char) m.carry[index])) ++index;
+			if (index == m.carried) return false;
+			while (index < m.carried && !isspace((unsigned char) m.carry[index])) ++index;
+			return index < m.carried;
+		}
+	};
+
+	/* Writes as much pending output as the descriptor takes. Returns true once nothing is pending */
+	bool writePending(Scheduler::Machine & m) {
+		while (!m.pending.empty()) {
+			ssize_t count = ::write(m.outputFd, m.pending.data(), m.pending.size());
+			if (count > 0) m.pending.erase(0, count);
+			else if (count < 0 && errno == EINTR) continue;
+			else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+			else m.pending.clear(); /* Nobody reads it any more */
+		}
+		std::string().swap(m.pending); /* An idle machine keeps no buffer */
+		return true;
+	}
+
+	/* What a machine waits for after its turn */
+	enum {runsAgain = 0, waitsInput = 1, waitsOutput = 2, done = 4};
+
+	/* Gives a machine one turn on a worker's instance: writes what it printed last time, then runs a slice if all of that went out */
+	int turn(ByteSyzed & cpu, DescriptorInput & input, MemoryOutput & output, Scheduler::Machine & m, unsigned long long slice) {
+		int waits = runsAgain;
+		if (m.status == ByteSyzed::running && writePending(m)) {
+			input.machine = &m;
+			cpu.restoreSnapshot(m.state);
+			ByteSyzed::Status status = cpu.step(slice);
+			cpu.saveSnapshot(m.state);
+
+			if (status == ByteSyzed::exited || status == ByteSyzed::faulted) m.status = status;
+			if (status == ByteSyzed::waitingForInput) waits |= waitsInput;
+			m.pending += output.text();
+			output.clear();
+			writePending(m);
+		}
+		if (!m.pending.empty()) return waits | waitsOutput; /* Output full, the machine does not run until it drains */
+		return (m.status == ByteSyzed::running)? waits : done;
+	}
+
+	/* A machine out of the run queue until poll says what it waits for is ready */
+	struct Parked {
+		int index;
+		int waits;
+	};
+}
+
+/*
+*	Every worker takes machines from one run queue and gives each a turn.
+*	Machines that wait are parked. A worker that finds the queue empty polls
+*	the parked machines' descriptors (one worker at a time) and queues the
+*	ones that are ready. It only blocks in poll when no machine is running,
+*	otherwise it looks again shortly, so machines parked meanwhile are seen.
+*/
+void Scheduler::run(int threads) {
+	if (threads <= 0) threads = (int) std::thread::hardware_concurrency();
+	if (threads <= 0) threads = 1; /* Unknown core count */
+	signal(SIGPIPE, SIG_IGN); /* A reader that went away shows up as EPIPE, not a dead process */
+
+	std::mutex lock;
+	std::condition_variable wake;
+	std::deque<int> queue;
+	std::vector<Parked> parked;
+	int left = 0, running = 0;
+	bool polling = false;
+
+	for (int index = 0; index < size(); ++index) {
+		if (machines[index]->status != ByteSyzed::running && machines[index]->pending.empty()) continue;
+		queue.push_back(index);
+		++left;
+	}
+
+	auto work = [&]() {
+		/* One instance per worker, machines are restored into it. Heap, it is a few kilobytes */
+		std::unique_ptr<ByteSyzed> cpu(new ByteSyzed());
+		DescriptorInput input;
+		MemoryOutput output;
+		cpu->verbose = false;
+		cpu->prompt = false; /* Input is a descriptor, nobody sees a prompt */
+		cpu->dumpFileName = NULL; /* Workers would fight over debug.txt */
+		cpu->input = &input, cpu->output = &output;
+
+		std::unique_lock<std::mutex> guard(lock);
+		while (left > 0) {
+			if (!queue.empty()) {
+				int index = queue.front();
+				queue.pop_front();
+				++running;
+				guard.unlock();
+				int waits = turn(*cpu, input, output, *machines[index], slice);
+				guard.lock();
+				--running;
+
+				if (waits == done) {
+					if (--left == 0) wake.notify_all();
+				}
+				else if (waits == runsAgain) {
+					queue.push_back(index);
+					wake.notify_one();
+				}
+				else {
+					Parked machine = {index, waits};
+					parked.push_back(machine);
+					wake.notify_one(); /* An idle worker may be the one to poll */
+				}
+				continue;
+			}
+
+			if (polling || parked.empty()) {
+				wake.wait(guard);
+				continue;
+			}
+
+			/* Poll every parked machine, without the lock */
+			polling = true;
+			std::vector<Parked> waiting;
+			waiting.swap(parked);
+			int timeout = (running > 0)? 1 : -1;
+			guard.unlock();
+
+			std::vector<pollfd> fds;
+			std::vector<int> owner; /* Index into waiting of every entry of fds */
+			for (int index = 0; index < (int) waiting.size(); ++index) {
+				const Machine & m = *machines[waiting[index].index];
+				if (waiting[index].waits & waitsInput) {
+					pollfd fd = {m.inputFd, POLLIN, 0};
+					fds.push_back(fd), owner.push_back(index);
+				}
+				if (waiting[index].waits & waitsOutput) {
+					pollfd fd = {m.outputFd, POLLOUT, 0};
+					fds.push_back(fd), owner.push_back(index);
+				}
+			}
+			int count = poll(fds.data(), fds.size(), timeout);
+			std::vector<char> woken(waiting.size(), 0);
+			for (int index = 0; count > 0 && index < (int) fds.size(); ++index)
+				if (fds[index].revents != 0) woken[owner[index]] = 1; /* Readable, writable, closed or broken: its turn will tell */
+
+			guard.lock();
+			polling = false;
+			for (int index = 0; index < (int) waiting.size(); ++index) {
+				if (woken[index]) queue.push_back(waiting[index].index);
+				else parked.push_back(waiting[index]);
+			}
+			wake.notify_all();
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int worker = 1; worker < threads; ++worker)
+		pool.emplace_back(work);
+	work(); /* The calling thread is a worker too */
+	for (auto & thread : pool)
+		thread.join();
+}
+
+#endif
\ No newline at end of file
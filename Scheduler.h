@@ -0,0 +1,49 @@
+/*	Scheduler.h
+*
+*	ByteSyzed Machine Scheduler Header.
+*
+*	Time-slices many I/O-bound ByteSyzed machines over a few threads. An
+*	idle machine is only its Snapshot (registers, memory and a little
+*	bookkeeping). Each thread has one full ByteSyzed it restores a machine
+*	into, steps for a slice and saves back. A machine that waits on getchar
+*	or on output it could not write yet is parked until poll says its file
+*	descriptor is ready, so no thread ever blocks on one machine. POSIX only.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "ByteSyzed.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class Scheduler {
+public:
+	/* A machine between turns */
+	struct Machine {
+		ByteSyzed::Snapshot state; /* Registers, memory, steps */
+		ByteSyzed::Status status; /* running until it exits or faults */
+		int inputFd, outputFd; /* Where getchar reads numbers and output is written. May be the same socket */
+		bool inputEnded; /* inputFd reached end of file, getchar reads 0 from here on */
+		unsigned char carried; /* Bytes in carry */
+		char carry[30]; /* Input read but not parsed yet, at most part of a number or two */
+		std::string pending; /* Output not written yet, empty once it all went out */
+	};
+
+	unsigned long long slice = 10000; /* Instructions a machine runs per turn */
+
+	int add(const unsigned char * image, int count, int inputFd, int outputFd, unsigned char progStart = 0x00); /* Adds a booted machine with a byte image loaded at progStart. Returns its index, -1 if the image does not fit */
+	int add(const ByteSyzed::Snapshot & start, int inputFd, int outputFd); /* Adds a machine continuing from a snapshot */
+	void run(int threads = 0); /* Runs until every machine exited or faulted and its output went out. 0 threads means one per core */
+	const Machine & machine(int index) const { return *machines[index]; }
+	int size(void) const { return (int) machines.size(); }
+
+private:
+	std::vector<std::unique_ptr<Machine> > machines;
+};
+
+#endif
\ No newline at end of file
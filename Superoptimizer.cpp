@@ -0,0 +1,619 @@
+/*	Superoptimizer.cpp
+*
+*	ByteSyzed Superoptimizer Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Superoptimizer.h"
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <string.h>
+#include <thread>
+
+namespace {
+	/* Small, fast generator (xorshift64*), so making candidates costs little next to running them */
+	struct Random {
+		unsigned long long state;
+		explicit Random(unsigned long long seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+		unsigned int operator()(void) {
+			state ^= state >> 12, state ^= state << 25, state ^= state >> 27;
+			return (unsigned int)((state * 0x2545F4914F6CDD1DULL) >> 32);
+		}
+		double unit(void) { return ((*this)() >> 8) * (1.0 / 16777216.0); } /* In [0, 1) */
+	};
+
+	/* Output compared with the target as it is flushed. Nothing past the first wrong byte is looked at */
+	class MatchOutput : public EmulatorOutput {
+	public:
+		const std::string * expected = NULL;
+		size_t matched = 0; /* Bytes of expected printed so far */
+		bool wrong = false; /* Printed a byte expected does not have there */
+		void restart(void) { flush(); matched = 0, wrong = false; }
+
+	protected:
+		void drain(const char * bytes, size_t count) {
+			for (size_t index = 0; index < count && !wrong; ++index) {
+				if (matched < expected->size() && (*expected)[matched] == bytes[index]) ++matched;
+				else wrong = true;
+			}
+		}
+	};
+
+	/* Byte of an instruction holding its address operand, 0 if it has none */
+	int addressOperand(unsigned char opcode) {
+		switch (opcode) {
+			case 0x70: case 0xC2: case 0xE3: case 0xA2: case 0xAA:
+				return 1;
+			case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0xA1: case 0xA8: case 0xA9:
+				return 2;
+		}
+		return 0;
+	}
+
+	/* What an operand byte holds */
+	enum Role {valueRole, registerRole, addressRole};
+	Role operandRole(unsigned char opcode, int index) {
+		if (index == addressOperand(opcode)) return addressRole;
+		if ((opcode & 0xF0) == 0x00 || opcode == 0xED) return valueRole; /* "movA val", "dump id" */
+		if (opcode == 0xA2 || opcode == 0xAA) return registerRole; /* "add adr AB", "sub adr AB" */
+		return (index == 1)? registerRole : valueRole;
+	}
+
+	/* Which nibbles of a register operand mean something. B is a count for inc, dec, pco, the skips and lea */
+	void nibblesUsed(unsigned char opcode, bool & a, bool & b) {
+		const int fields = ByteSyzed::registerFields(opcode);
+		a = (fields & (ByteSyzed::readsA | ByteSyzed::writesA)) != 0;
+		b = (fields & (ByteSyzed::readsB | ByteSyzed::writesB)) != 0;
+		switch (opcode) {
+			case 0x15: case 0x16: case 0x17: case 0x18: case 0x77: case 0x78: case 0xA4: case 0xA5: case 0xA6:
+				b = true;
+		}
+	}
+
+	/* Bytes of the instruction at index. A printstr takes its text and 0, and nothing runs past the end */
+	int lengthAt(const unsigned char * program, int count, int index) {
+		const unsigned char opcode = program[index];
+		int length = ByteSyzed::instructionLength(opcode);
+		if (length == 0) length = 1; /* Invalid, runs as a fault */
+		if (opcode == 0xE2) {
+			while (index + length < count && program[index + length] != 0) ++length;
+			++length;
+		}
+		return (index + length <= count)? length : count - index;
+	}
+
+	/*
+	*	After removed bytes at offset at were replaced by inserted new ones,
+	*	aims the address operands that pointed past them where those bytes
+	*	went, and those that pointed inside them at the new bytes. The
+	*	inserted instructions are left as they were made.
+	*/
+	void shiftAddresses(std::vector<unsigned char> & program, unsigned char progStart, int at, int removed, int inserted) {
+		const int count = (int) program.size();
+		for (int index = 0; index < count; index += lengthAt(program.data(), count, index)) {
+			const int operand = addressOperand(program[index]);
+			if ((index >= at && index < at + inserted) || operand == 0 || index + operand >= count) continue;
+			unsigned char & target = program[index + operand];
+			const int offset = target - progStart;
+			if (offset >= at + removed) target = (unsigned char)(target + inserted - removed);
+			else if (offset > at) target = (unsigned char)(progStart + at);
+		}
+	}
+
+	/* One per core unless told otherwise */
+	int threadCount(int threads) {
+		if (threads <= 0) threads = (int) std::thread::hardware_concurrency();
+		return (threads > 0)? threads : 1; /* Unknown core count */
+	}
+
+	/* Runs work(index) on threads threads, the calling one included */
+	template <class Work>
+	void runThreads(int threads, Work work) {
+		std::vector<std::thread> pool;
+		for (int index = 1; index < threads; ++index)
+			pool.emplace_back(work, index);
+		work(0);
+		for (auto & thread : pool)
+			thread.join();
+	}
+
+	double secondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+/* A thread's machine, booted with the last candidate loaded, and what it found */
+struct Superoptimizer::Worker {
+	/* How close a candidate came */
+	struct Score {
+		int error; /* 0 if it did the target. Bytes of output missing, one for wrong output, one for not exiting and one for the wrong exit code */
+		unsigned long long steps; /* Instructions it ran */
+	};
+	enum {firstSlice=32, errorWeight=16}; /* Steps before the output is first checked. Cost of a unit of error in bytes or steps */
+
+	Superoptimizer & owner;
+	std::unique_ptr<ByteSyzed> cpu; /* Heap, it is a few kilobytes */
+	std::unique_ptr<ByteSyzed::Snapshot> start; /* Booted, with the last candidate at progStart */
+	MatchOutput output;
+	QueueInput input;
+	Random random;
+	int loaded = 0; /* Bytes of the last candidate */
+	std::vector<int> starts; /* Where the instructions of the program being mutated start */
+	unsigned long long evaluated = 0, correct = 0, rejectedEarly = 0;
+	int shortestBytes = 0x7FFFFFFF; /* Best this worker offered, so only better ones take the lock */
+	unsigned long long shortestSteps = ~0ULL, fastestSteps = ~0ULL;
+	int fastestBytes = 0x7FFFFFFF;
+
+	Worker(Superoptimizer & owner, unsigned long long seed);
+	Score run(const unsigned char * program, int count);
+	void offer(const unsigned char * program, int count, unsigned long long steps);
+	unsigned char operand(unsigned char opcode, int index, int count);
+	int make(unsigned char * bytes, int count);
+	void parse(const std::vector<unsigned char> & program); /* Fills starts */
+	bool mutate(const std::vector<unsigned char> & from, std::vector<unsigned char> & to); /* from was parsed last */
+};
+
+Superoptimizer::Worker::Worker(Superoptimizer & owner, unsigned long long seed) : owner(owner), cpu(new ByteSyzed()), start(new ByteSyzed::Snapshot), random(seed) {
+	cpu->verbose = false;
+	cpu->prompt = false; /* Input is scripted */
+	cpu->dumpFileName = NULL; /* Threads would fight over debug.txt */
+	cpu->translating = false; /* Candidates change every run, translating them costs more than it saves */
+	cpu->output = &output;
+	cpu->input = &input;
+	output.expected = &owner.target.output;
+	input.push(owner.target.input.c_str());
+
+	cpu->wipeMemory();
+	cpu->progStart = owner.progStart;
+	cpu->boot();
+	cpu->saveSnapshot(*start);
+	start->inputPosition = 0;
+	cpu->clearDirty();
+}
+
+/*
+*	Runs a candidate. It is written into the start state over the last one,
+*	and only its pages and the ones the last run wrote are compared. The
+*	output is checked after each slice, so a candidate that prints something
+*	wrong early stops there instead of at maxSteps.
+*/
+Superoptimizer::Worker::Score Superoptimizer::Worker::run(const unsigned char * program, int count) {
+	const int first = owner.progStart, span = (count > loaded)? count : loaded;
+	memcpy(start->mem + first, program, count);
+	if (loaded > count) memset(start->mem + first + count, 0, loaded - count);
+	for (int page = first >> ByteSyzed::dirtyShift; page <= (first + span - 1) >> ByteSyzed::dirtyShift; ++page)
+		cpu->dirty[page] = 1;
+	loaded = count;
+	cpu->resetTo(*start);
+	output.restart();
+	++evaluated;
+
+	/*
+	*	An instruction stores at most a byte, so while memory holds more 0s
+	*	than the steps of a slice, a printstr in it ends. With none left it
+	*	would print forever. Every byte but the candidate's and the stack slot
+	*	starts out 0, and memory is only counted again once that runs short.
+	*/
+	unsigned long long zeros = ByteSyzed::n_mem - (first != 0), countedAt = 0; /* 0s at steps countedAt */
+	for (int index = 0; index < count; ++index) zeros -= (program[index] != 0);
+
+	ByteSyzed::Status status = ByteSyzed::outOfSteps;
+	for (unsigned long long slice = firstSlice; status == ByteSyzed::outOfSteps && cpu->steps < owner.maxSteps && !output.wrong; slice = (slice < owner.maxSteps)? 2 * slice : slice) {
+		unsigned long long limit = owner.maxSteps - cpu->steps;
+		if (limit > slice) limit = slice;
+		if (zeros < limit + (cpu->steps - countedAt)) {
+			zeros = 0, countedAt = cpu->steps;
+			for (int index = 0; index < ByteSyzed::n_mem; ++index) zeros += (cpu->mem[index] == 0);
+			if (zeros == 0) break;
+			if (limit > zeros) limit = zeros;
+		}
+		status = cpu->step(limit);
+		output.flush();
+	}
+	if (output.wrong && status == ByteSyzed::outOfSteps) ++rejectedEarly;
+
+	Score score;
+	const bool exited = status == ByteSyzed::exited;
+	score.error = (int)(owner.target.output.size() - output.matched) + output.wrong + !exited + (exited && owner.target.exitCode >= 0 && cpu->regs[0x0] != owner.target.exitCode);
+	score.steps = cpu->steps;
+	if (score.error == 0) ++correct, offer(program, count, score.steps);
+	return score;
+}
+
+/* Hands a correct candidate to the owner if it beats what this worker found before */
+void Superoptimizer::Worker::offer(const unsigned char * program, int count, unsigned long long steps) {
+	bool better = false;
+	if (count < shortestBytes || (count == shortestBytes && steps < shortestSteps)) shortestBytes = count, shortestSteps = steps, better = true;
+	if (steps < fastestSteps || (steps == fastestSteps && count < fastestBytes)) fastestSteps = steps, fastestBytes = count, better = true;
+	if (better) owner.offer(program, count, steps);
+}
+
+/* A random operand byte for an instruction in a program of count bytes. Addresses are inside it, or just past it */
+unsigned char Superoptimizer::Worker::operand(unsigned char opcode, int index, int count) {
+	switch (operandRole(opcode, index)) {
+		case addressRole:
+			return (unsigned char)(owner.progStart + random() % (count + 1));
+		case registerRole: {
+			bool a, b;
+			nibblesUsed(opcode, a, b);
+			return (unsigned char)(((a? random() % owner.registers : 0) << 4) | (b? random() % owner.registers : 0));
+		}
+		default:
+			return owner.valueSet[random() % owner.valueSet.size()];
+	}
+}
+
+/* A random instruction of the alphabet's opcodes into bytes. Returns its length */
+int Superoptimizer::Worker::make(unsigned char * bytes, int count) {
+	const unsigned char opcode = owner.opcodeSet[random() % owner.opcodeSet.size()];
+	const int length = ByteSyzed::instructionLength(opcode);
+	bytes[0] = opcode;
+	for (int index = 1; index < length; ++index)
+		bytes[index] = operand(opcode, index, count);
+	return length;
+}
+
+/* Finds the instructions of a program, once for all the mutations of it */
+void Superoptimizer::Worker::parse(const std::vector<unsigned char> & program) {
+	const int count = (int) program.size();
+	starts.clear();
+	for (int index = 0; index < count; index += lengthAt(program.data(), count, index))
+		starts.push_back(index);
+}
+
+/*
+*	A random change to a program: an instruction replaced, inserted, removed
+*	or swapped with the next, an operand (or a byte of a printstr's text)
+*	changed, or a byte inserted, removed or set. Jumps are aimed where their
+*	targets moved. False if the change picked does not fit.
+*/
+bool Superoptimizer::Worker::mutate(const std::vector<unsigned char> & from, std::vector<unsigned char> & to) {
+	const int count = (int) from.size();
+	const int pick = random() % starts.size(), at = starts[pick];
+	const int length = lengthAt(from.data(), count, at);
+	unsigned char made[ByteSyzed::maxLength];
+	to = from;
+
+	switch (random() % 6) {
+		case 0: { /* Another instruction in its place */
+			const int madeLength = make(made, count);
+			if (count - length + madeLength > owner.maxBytes) return false;
+			to.erase(to.begin() + at, to.begin() + at + length);
+			to.insert(to.begin() + at, made, made + madeLength);
+			shiftAddresses(to, owner.progStart, at, length, madeLength);
+			return true;
+		}
+		case 1: { /* One operand, or one byte of a printstr's text */
+			if (length < 2) return false;
+			const int index = 1 + random() % (length - 1);
+			to[at + index] = (from[at] == 0xE2)? owner.valueSet[random() % owner.valueSet.size()] : operand(from[at], index, count);
+			return true;
+		}
+		case 2: { /* A new instruction before it */
+			const int madeLength = make(made, count);
+			if (count + madeLength > owner.maxBytes) return false;
+			to.insert(to.begin() + at, made, made + madeLength);
+			shiftAddresses(to, owner.progStart, at, 0, madeLength);
+			return true;
+		}
+		case 3: /* Removed */
+			if (starts.size() < 2) return false;
+			to.erase(to.begin() + at, to.begin() + at + length);
+			shiftAddresses(to, owner.progStart, at, length, 0);
+			return true;
+		case 4: { /* Swapped with the next one */
+			if (pick + 1 == (int) starts.size()) return false;
+			const int nextLength = lengthAt(from.data(), count, at + length);
+			std::copy(from.begin() + at + length, from.begin() + at + length + nextLength, to.begin() + at);
+			std::copy(from.begin() + at, from.begin() + at + length, to.begin() + at + nextLength);
+			return true;
+		}
+		default: { /* A byte anywhere, which grows and shrinks printstr text */
+			const int index = random() % count;
+			const unsigned char value = owner.valueSet[random() % owner.valueSet.size()];
+			switch (random() % 3) {
+				case 0:
+					to[index] = value;
+					return to[index] != from[index];
+				case 1:
+					if (count + 1 > owner.maxBytes) return false;
+					to.insert(to.begin() + index, value);
+					shiftAddresses(to, owner.progStart, index, 0, 1);
+					return true;
+				default:
+					if (count < 2) return false;
+					to.erase(to.begin() + index);
+					shiftAddresses(to, owner.progStart, index, 1, 0);
+					return true;
+			}
+		}
+	}
+}
+
+/* Fills opcodeSet and valueSet with their defaults unless they were given, and keeps candidates below the stack */
+void Superoptimizer::prepare(void) {
+	const int room = ByteSyzed::n_mem - ByteSyzed::addrBytes - progStart; /* Up to the slot at the bottom of the stack */
+	if (maxBytes > room) maxBytes = room;
+	if (maxBytes < 1) maxBytes = 1;
+	if (registers < 1) registers = 1;
+	if (registers > ByteSyzed::n_regs) registers = ByteSyzed::n_regs;
+
+	opcodeSet = opcodes;
+	if (opcodeSet.empty()) {
+		for (int opcode = 0; opcode < 256; ++opcode) {
+			if (ByteSyzed::instructionLength(opcode) == 0) continue;
+			if (opcode == 0xE1 && target.input.empty()) continue; /* Only reads 0 */
+			if (opcode == 0xE3 || opcode == 0xE4) continue; /* Nothing to spawn or join on one core */
+			if ((0xE8 <= opcode && opcode <= 0xED) || opcode == 0xEF) continue; /* Dumps, which the output would have to match */
+			opcodeSet.push_back((unsigned char) opcode);
+		}
+	}
+
+	valueSet = values;
+	if (valueSet.empty()) {
+		bool seen[256] = {false};
+		auto use = [&](unsigned char value) { if (!seen[value]) seen[value] = true, valueSet.push_back(value); };
+		use(0x00), use(0x01), use(0xFF);
+		for (size_t index = 0; index < target.output.size(); ++index) use((unsigned char) target.output[index]);
+		if (target.exitCode >= 0) use((unsigned char) target.exitCode);
+	}
+}
+
+/* Every instruction of the opcodes with every operand: values from valueSet, registers below registers, and addresses inside the longest candidate */
+void Superoptimizer::buildAlphabet(int maxInstructions) {
+	alphabet.clear();
+	int addresses = maxInstructions * ByteSyzed::maxLength;
+	if (addresses > maxBytes) addresses = maxBytes;
+
+	for (size_t next = 0; next < opcodeSet.size(); ++next) {
+		const unsigned char opcode = opcodeSet[next];
+		if (opcode == 0xEE || opcode == 0xE2) continue; /* Exit ends every candidate, and printstr would need text */
+		Instruction in;
+		in.bytes[0] = opcode;
+		in.length = (unsigned char) ByteSyzed::instructionLength(opcode);
+
+		/* Counts through the choices of every operand, the last fastest */
+		int choices[ByteSyzed::maxLength] = {1, 1, 1, 1}, digits[ByteSyzed::maxLength] = {0, 0, 0, 0};
+		bool a, b;
+		nibblesUsed(opcode, a, b);
+		for (int index = 1; index < in.length; ++index) {
+			switch (operandRole(opcode, index)) {
+				case addressRole: choices[index] = addresses; break;
+				case registerRole: choices[index] = (a? registers : 1) * (b? registers : 1); break;
+				default: choices[index] = (int) valueSet.size();
+			}
+		}
+		for (;;) {
+			for (int index = 1; index < in.length; ++index) {
+				switch (operandRole(opcode, index)) {
+					case addressRole: in.bytes[index] = (unsigned char)(progStart + digits[index]); break;
+					case registerRole: in.bytes[index] = (unsigned char)(b? ((digits[index] / registers) << 4) | (digits[index] % registers) : digits[index] << 4); break;
+					default: in.bytes[index] = valueSet[digits[index]];
+				}
+			}
+			alphabet.push_back(in);
+
+			int index = in.length - 1;
+			while (index > 0 && ++digits[index] == choices[index]) digits[index--] = 0;
+			if (index == 0) break;
+		}
+	}
+}
+
+/* Candidates enumerate would try, ~0 if too many to count */
+unsigned long long Superoptimizer::candidates(int maxInstructions) {
+	prepare();
+	buildAlphabet(maxInstructions);
+	unsigned long long total = 0, ofLength = 1;
+	for (int length = 1; length <= maxInstructions; ++length) {
+		total += ofLength;
+		if (length < maxInstructions && alphabet.size() != 0 && ofLength > ~0ULL / 2 / alphabet.size()) return ~0ULL;
+		ofLength *= alphabet.size();
+	}
+	return total;
+}
+
+/*
+*	Tries every sequence of instructions followed by exit, those of one
+*	instruction first. Threads take chunks of the sequences of one length
+*	in order, and count through each chunk by changing the last instruction
+*	first, so the instructions before it stay decoded.
+*/
+void Superoptimizer::enumerate(int maxInstructions, int threads) {
+	enum {chunk=4096};
+	prepare();
+	buildAlphabet(maxInstructions);
+	threads = threadCount(threads);
+	const auto started = std::chrono::steady_clock::now();
+	const unsigned long long size = alphabet.size();
+
+	unsigned long long total = 1; /* Sequences before the exit */
+	for (int length = 0; length < maxInstructions; ++length) {
+		std::atomic<unsigned long long> next(0);
+		auto work = [&](int index) {
+			Worker worker(*this, index + 1);
+			std::vector<int> digits(length + 1);
+			unsigned char program[ByteSyzed::n_mem];
+			for (;;) {
+				const unsigned long long first = next.fetch_add(chunk);
+				if (first >= total) break;
+				const unsigned long long last = (total - first > chunk)? first + chunk : total;
+				unsigned long long rest = first; /* In base size, the last instruction lowest */
+				for (int place = length - 1; place >= 0; --place)
+					digits[place] = (int)(rest % size), rest /= size;
+
+				for (unsigned long long candidate = first; candidate < last; ++candidate) {
+					int count = 0;
+					bool fits = true;
+					for (int place = 0; place < length && fits; ++place) {
+						const Instruction & in = alphabet[digits[place]];
+						fits = count + in.length + 1 <= maxBytes;
+						if (fits) memcpy(program + count, in.bytes, in.length), count += in.length;
+					}
+					if (fits) {
+						program[count++] = 0xEE;
+						worker.run(program, count);
+					}
+					for (int place = length - 1; place >= 0 && ++digits[place] == (int) size; --place)
+						digits[place] = 0;
+				}
+			}
+			add(worker);
+		};
+		runThreads(threads, work);
+		if (size != 0 && total > ~0ULL / size) break; /* More than can be run */
+		total *= size;
+	}
+	seconds = secondsSince(started);
+}
+
+
+/*
+*	Metropolis search. Every thread runs a chain of mutations from seed and
+*	keeps a mutation that costs no more than the program it came from, or
+*	one that costs d more with probability exp(-d / temperature). The cost is
+*	errorWeight per unit of error, plus the bytes of the program on even
+*	threads and its steps on odd ones (a wrong program counting the steps of
+*	the last right one in the chain). A chain that has not improved in a
+*	while starts again from the best program of its goal.
+*/
+void Superoptimizer::search(unsigned long long count, const std::vector<unsigned char> & seed, unsigned int randomSeed, int threads) {
+	enum {batch=256, restartAfter=1 << 16}; /* Candidates a thread claims at once, and tries without improving before it starts again */
+	prepare();
+	threads = threadCount(threads);
+	const auto started = std::chrono::steady_clock::now();
+	std::vector<unsigned char> first = seed;
+	if (first.empty() || (int) first.size() > maxBytes) first.assign(1, 0xEE);
+	std::atomic<unsigned long long> claimed(0);
+
+	auto work = [&](int index) {
+		Worker worker(*this, (unsigned long long) randomSeed * threads + index);
+		const bool forSteps = index % 2 == 1;
+		std::vector<unsigned char> current, next;
+		unsigned long long currentSteps = maxSteps; /* Of the last right program in the chain */
+		double currentCost = 0, bestCost = 0;
+		unsigned long long tries = 0;
+
+		/* Starts the chain at a program */
+		auto restart = [&](const std::vector<unsigned char> & program) {
+			current = program;
+			worker.parse(current);
+			Worker::Score score = worker.run(current.data(), (int) current.size());
+			if (score.error == 0) currentSteps = score.steps;
+			currentCost = Worker::errorWeight * score.error + (forSteps? (double) currentSteps : (double) current.size());
+			bestCost = currentCost, tries = 0;
+		};
+		restart(first);
+
+		for (unsigned long long left = 0; ; --left) {
+			if (left == 0) {
+				unsigned long long from = claimed.fetch_add(batch);
+				if (from >= count) break;
+				left = (count - from < batch)? count - from : (unsigned long long) batch;
+			}
+			if (!worker.mutate(current, next)) {
+				++left; /* Nothing was run */
+				continue;
+			}
+
+			Worker::Score score = worker.run(next.data(), (int) next.size());
+			const unsigned long long steps = (score.error == 0)? score.steps : currentSteps;
+			const double cost = Worker::errorWeight * score.error + (forSteps? (double) steps : (double) next.size());
+			if (cost <= currentCost || worker.random.unit() < exp((currentCost - cost) / temperature)) {
+				current.swap(next);
+				currentSteps = steps, currentCost = cost;
+				worker.parse(current);
+			}
+
+			if (currentCost < bestCost) bestCost = currentCost, tries = 0;
+			else if (++tries == restartAfter) {
+				std::vector<unsigned char> best;
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					best = forSteps? fastest.program : shortest.program;
+				}
+				restart(best.empty()? first : best);
+			}
+		}
+		add(worker);
+	};
+	runThreads(threads, work);
+	seconds = secondsSince(started);
+}
+
+/* A program that does the target. Keeps it if it is the shortest or the fastest yet */
+void Superoptimizer::offer(const unsigned char * program, int count, unsigned long long steps) {
+	std::lock_guard<std::mutex> guard(lock);
+	const int shortestBytes = (int) shortest.program.size(), fastestBytes = (int) fastest.program.size();
+	if (shortestBytes == 0 || count < shortestBytes || (count == shortestBytes && steps < shortest.steps))
+		shortest.program.assign(program, program + count), shortest.steps = steps;
+	if (fastestBytes == 0 || steps < fastest.steps || (steps == fastest.steps && count < fastestBytes))
+		fastest.program.assign(program, program + count), fastest.steps = steps;
+}
+
+/* Adds what a worker ran to the counts */
+void Superoptimizer::add(const Worker & worker) {
+	std::lock_guard<std::mutex> guard(lock);
+	evaluated += worker.evaluated;
+	correct += worker.correct;
+	rejectedEarly += worker.rejectedEarly;
+}
+
+/* True if a program does the target, and the steps it took */
+bool Superoptimizer::check(const unsigned char * program, int count, unsigned long long * steps) {
+	prepare();
+	if (count < 1 || count > maxBytes) return false;
+	std::unique_ptr<Worker> worker(new Worker(*this, 1));
+	Worker::Score score = worker->run(program, count);
+	if (steps != NULL) *steps = score.steps;
+	return score.error == 0;
+}
+
+/* An instruction per line, a printstr's text four bytes a line, with the address of each instruction */
+void Superoptimizer::print(EmulatorOutput & out, const Found & found) const {
+	const unsigned char * program = found.program.data();
+	const int count = (int) found.program.size();
+	for (int index = 0; index < count; ) {
+		const int length = lengthAt(program, count, index);
+		const int shown = (program[index] == 0xE2)? 1 : length;
+		for (int byte = 0; byte < shown; ++byte)
+			out.print((byte == 0)? "0x%02X" : " 0x%02X", program[index + byte]);
+		out.print(" ! [0x%02X]\n", progStart + index);
+		for (int text = index + shown; text < index + length; text += 4) {
+			for (int byte = text; byte < index + length && byte < text + 4; ++byte)
+				out.print((byte == text)? "0x%02X" : " 0x%02X", program[byte]);
+			out.print("\n");
+		}
+		index += length;
+	}
+}
+
+/* Prints the rate and the best programs */
+void Superoptimizer::report(EmulatorOutput & out) const {
+	out.print("Evaluated %llu candidates in %.2f seconds (%.0f a second). %llu did the target, %llu were dropped at wrong output before they stopped.\n",
+		evaluated, seconds, (seconds > 0)? evaluated / seconds : 0.0, correct, rejectedEarly);
+	if (shortest.program.empty()) {
+		out.print("No program found that does the target.\n");
+		return;
+	}
+	out.print("\nShortest: %i bytes, %llu steps\n", (int) shortest.program.size(), shortest.steps);
+	print(out, shortest);
+	out.print("\nFastest: %i bytes, %llu steps\n", (int) fastest.program.size(), fastest.steps);
+	print(out, fastest);
+}
+
+/* Writes a program in the text format of loadFromFile */
+bool Superoptimizer::save(const char * fileName, const Found & found) const {
+	FILE * file = fopen(fileName, "w");
+	if (file == NULL) return false;
+	{
+		FileOutput out(file);
+		out.print("! %i bytes, %llu steps. Found by superoptimize\n", (int) found.program.size(), found.steps);
+		print(out, found);
+	}
+	return fclose(file) == 0;
+}
\ No newline at end of file
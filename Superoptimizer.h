@@ -0,0 +1,87 @@
+/*	Superoptimizer.h
+*
+*	ByteSyzed Superoptimizer Header.
+*
+*	Searches for the shortest and the fastest programs that do a target:
+*	print exactly some output (given some input) and exit, optionally with
+*	a given exit code. Candidates are either enumerated, every sequence of
+*	instructions from a small alphabet followed by exit, or made by
+*	mutating a program at random and keeping mostly what gets closer to the
+*	target (a Metropolis search, as stochastic superoptimizers do).
+*
+*	Every thread evaluates candidates on a machine of its own. A candidate
+*	is written over the last one and the machine reset through its dirty
+*	pages (see ByteSyzedT::resetTo), so instructions a mutation did not
+*	touch stay decoded. It runs in slices that double in length, and is
+*	dropped at the end of the first slice whose output differs from the
+*	target, or once it runs out of steps.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef SUPEROPTIMIZER_H
+#define SUPEROPTIMIZER_H
+
+#include "ByteSyzed.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Superoptimizer {
+public:
+	/* What a program must do */
+	struct Target {
+		std::string output; /* Everything it prints, exactly */
+		std::string input; /* Numbers getchar reads, whitespace separated */
+		int exitCode = -1; /* regs[0x0] at exit, -1 for any */
+	};
+
+	/* Best program found for one goal */
+	struct Found {
+		std::vector<unsigned char> program; /* Loaded at progStart, empty until one is found */
+		unsigned long long steps = 0; /* Instructions it runs, exit included */
+	};
+
+	Target target;
+	unsigned char progStart = 0x00; /* Where candidates are loaded and start */
+	int maxBytes = 32; /* Longest candidate */
+	unsigned long long maxSteps = 1000; /* Most instructions a candidate may run */
+	int registers = 4; /* Register operands (and the counts of inc, dec, skips and lea) are 0 up to this */
+	std::vector<unsigned char> opcodes; /* Instructions candidates are made of. Empty for every one but getchar (unless there is input), spawn, join and the dumps */
+	std::vector<unsigned char> values; /* Value operands. Empty for 0, 1, 0xFF and every byte of the output and exit code */
+	double temperature = 1.0; /* A mutation that costs d more is kept with probability exp(-d / temperature) */
+
+	Found shortest; /* Fewest bytes, then fewest steps */
+	Found fastest; /* Fewest steps, then fewest bytes */
+	unsigned long long evaluated = 0, correct = 0, rejectedEarly = 0; /* Candidates run, those that did the target, and those dropped at wrong output before they stopped */
+	double seconds = 0; /* Wall time of the last enumerate or search */
+
+	bool check(const unsigned char * program, int count, unsigned long long * steps = NULL); /* True if a program does the target, and the steps it took */
+	unsigned long long candidates(int maxInstructions); /* Candidates enumerate would try, ~0 if too many to count */
+	void enumerate(int maxInstructions, int threads = 0); /* Tries every sequence of up to maxInstructions - 1 instructions followed by exit. 0 threads means one per core */
+	void search(unsigned long long count, const std::vector<unsigned char> & seed, unsigned int randomSeed = 1, int threads = 0); /* Mutates seed (exit alone if empty) count times over every thread */
+	void report(EmulatorOutput & out) const; /* Prints the rate and the best programs */
+	bool save(const char * fileName, const Found & found) const; /* Writes a program in the text format of loadFromFile, an instruction per line */
+
+private:
+	/* An instruction enumerate tries */
+	struct Instruction {
+		unsigned char bytes[ByteSyzed::maxLength];
+		unsigned char length;
+	};
+	struct Worker;
+	friend struct Worker;
+
+	std::vector<Instruction> alphabet; /* Every instruction enumerate tries, in opcode order */
+	std::vector<unsigned char> opcodeSet, valueSet; /* opcodes and values, or their defaults */
+	std::mutex lock; /* Around shortest, fastest and the counts */
+
+	void prepare(void); /* Fills opcodeSet and valueSet, and clamps maxBytes to memory */
+	void buildAlphabet(int maxInstructions);
+	void offer(const unsigned char * program, int count, unsigned long long steps); /* A correct candidate. Hold no lock */
+	void add(const Worker & worker); /* Adds a worker's counts. Hold no lock */
+	void print(EmulatorOutput & out, const Found & found) const; /* An instruction per line, as save writes it */
+};
+
+#endif
\ No newline at end of file
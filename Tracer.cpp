@@ -0,0 +1,351 @@
+/*	Tracer.cpp
+*
+*	ByteSyzed Binary Trace Definition.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Tracer.h"
+#include <string.h>
+#include <vector>
+
+/*
+*	Trace file layout:
+*	  0  magic "BST" and format version 1
+*	  4  size of a record (2 bytes, host order, so a trace from a host of
+*	     the other byte order is refused rather than misread), 2 bytes 0
+*	  8  the records, as TraceRecord lays them out
+*	A run starts with a record flagged segment: step and pc are where it
+*	starts, bytes[0] is the address width, bytes[1] is prompt and bytes[2]
+*	is set if run() printed "Running...". The registers (2 bytes each,
+*	little endian) and memory follow it. Each instruction after it has a
+*	record until the next segment.
+*/
+const char TraceDecoder::traceMagic[4] = {'B', 'S', 'T', 1};
+
+/* Starts the file and the thread writing it */
+bool TraceFile::open(const char * fileName, EmulatorOutput * messages) {
+	close();
+	file = fopen(fileName, "wb");
+	if (file == NULL) {
+		messages->print("Can't open %s. Unable to write the trace.\n", fileName);
+		return false;
+	}
+	unsigned char header[TraceDecoder::fileHeaderSize] = {0};
+	unsigned short recordSize = sizeof(TraceRecord);
+	memcpy(header, TraceDecoder::traceMagic, 4);
+	memcpy(header + 4, &recordSize, 2);
+	failed = fwrite(header, 1, sizeof(header), file) != sizeof(header);
+	stopping = false;
+	head = filled = 0;
+	writer = std::thread(&TraceFile::writeBlocks, this);
+	return true;
+}
+
+/* Writes everything recorded and stops the thread */
+bool TraceFile::close(void) {
+	if (file == NULL) return true;
+	flush();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_one();
+	writer.join();
+	failed |= fclose(file) != 0;
+	file = NULL;
+	return !failed;
+}
+
+/* Copies a block of records into the ring, waiting only when the writer is a whole ring behind */
+void TraceFile::drain(const char * bytes, size_t count) {
+	if (file == NULL || count == 0) return;
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		if (filled == blocks) {
+			++waits;
+			room.wait(guard, [this]() { return filled < blocks; });
+		}
+		ring[head].assign(bytes, count);
+		head = (head + 1) % blocks;
+		++filled;
+	}
+	wake.notify_one();
+}
+
+/* Writes blocks as they fill, oldest first, until closed */
+void TraceFile::writeBlocks(void) {
+	std::string block; /* Swapped with the ring's, so the engine can refill that one while this is written */
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this]() { return filled > 0 || stopping; });
+			if (filled == 0) break; /* Stopping, and everything is written */
+			block.swap(ring[(head - filled + blocks) % blocks]);
+			--filled;
+		}
+		room.notify_one();
+		if (fwrite(block.data(), 1, block.size(), file) != block.size()) failed = true;
+	}
+	fflush(file);
+}
+
+/* Decodes records as a TraceOutput gets them, segment by segment */
+bool TraceDecoder::decode(const char * bytes, size_t size, EmulatorOutput & out, EmulatorOutput * messages) {
+	records = 0;
+	const char * at = bytes, * end = bytes + size;
+	while (at < end) {
+		TraceRecord record;
+		if ((size_t)(end - at) < sizeof(record)) {
+			messages->print("Error. The trace ends in the middle of a record.\n");
+			return false;
+		}
+		memcpy(&record, at, sizeof(record));
+		bool decoded = false;
+		if (!(record.flags & TraceRecord::segment)) messages->print("Error. The trace does not start with the machine state.\n");
+		else if (record.bytes[0] == 8) decoded = decodeSegment<8>(at, end, out, messages);
+		else if (record.bytes[0] == 16) decoded = decodeSegment<16>(at, end, out, messages);
+		else messages->print("Error. The trace is of a %i bit machine.\n", record.bytes[0]);
+		if (!decoded) {
+			out.flush();
+			return false;
+		}
+	}
+	out.flush();
+	return true;
+}
+
+/* Decodes a file TraceFile wrote */
+bool TraceDecoder::decodeFile(const char * fileName, EmulatorOutput & out, EmulatorOutput * messages) {
+	FILE * file = fopen(fileName, "rb");
+	if (file == NULL) {
+		messages->print("Can't open %s.\n", fileName);
+		return false;
+	}
+	std::vector<char> bytes;
+	char buffer[65536];
+	for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+		bytes.insert(bytes.end(), buffer, buffer + count);
+	fclose(file);
+
+	unsigned short recordSize = 0;
+	if (bytes.size() >= fileHeaderSize) memcpy(&recordSize, bytes.data() + 4, 2);
+	if (bytes.size() < fileHeaderSize || memcmp(bytes.data(), traceMagic, 4) != 0 || recordSize != sizeof(TraceRecord)) {
+		messages->print("Error. %s is not a trace (or is from a host of the other byte order).\n", fileName);
+		return false;
+	}
+	return decode(bytes.data() + fileHeaderSize, bytes.size() - fileHeaderSize, out, messages);
+}
+
+/*
+*	Follows one run from its machine state, applying what each record says
+*	its instruction wrote (and the stack pointer moves, which records leave
+*	out), and prints the lines the verbose engines print for it, with the
+*	dumps and string output they print along with them.
+*/
+template <int AddrBits>
+bool TraceDecoder::decodeSegment(const char *& at, const char * end, EmulatorOutput & out, EmulatorOutput * messages) {
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef typename Machine::Word Word;
+	enum {n_regs=Machine::n_regs, n_mem=Machine::n_mem, addrBytes=Machine::addrBytes};
+
+	TraceRecord record;
+	memcpy(&record, at, sizeof(record));
+	at += sizeof(record);
+	if ((size_t)(end - at) < 2 * n_regs + n_mem) {
+		messages->print("Error. The trace ends in the middle of the machine state.\n");
+		return false;
+	}
+	const bool prompt = record.bytes[1] != 0;
+	const bool filtered = firstStep != 0 || lastStep != ~0ULL || firstAddress != 0 || lastAddress != 0xFFFF || opcode >= 0;
+	if (record.bytes[2] && !filtered) out.print("Running...\n");
+
+	Word regs[n_regs];
+	std::vector<unsigned char> mem(n_mem);
+	for (int index = 0; index < n_regs; ++index)
+		regs[index] = (Word)((unsigned char) at[2 * index] | ((unsigned char) at[2 * index + 1] << 8));
+	memcpy(mem.data(), at + 2 * n_regs, n_mem);
+	at += 2 * n_regs + n_mem;
+
+	auto readWord = [&](Word address) {
+		Word value = 0;
+		for (int index = 0; index < addrBytes; ++index)
+			value |= (Word)(mem[(Word)(address + index)] << (8 * index));
+		return value;
+	};
+	EmulatorOutput * to; /* Where this instruction's lines go, NULL when filtered out */
+#define PRINT(...) { if (to != NULL) to->print(__VA_ARGS__); }
+	/* As ByteSyzedT::dumpRegs and dumpMemRange print with verbose set */
+	auto dumpRegs = [&](Word id) {
+		if (id < n_regs) {
+			PRINT("regs[0x%01X] = 0x%02X\n", id, regs[id]);
+			return;
+		}
+		PRINT("Registers:\n");
+		for (int index = 0; index < n_regs; ++index)
+			PRINT("0x%01X : 0x%02X\n", index, regs[index]);
+	};
+	auto dumpMemRange = [&](Word first, Word last) {
+		PRINT("Memory:\n");
+		for (int index = first; index <= last; ++index)
+			PRINT("0x%02X : 0x%02X\n", index, mem[index]);
+		for (int index = first; index >= last; --index)
+			PRINT("0x%02X : 0x%02X\n", index, mem[index]);
+	};
+
+	while (at < end) {
+		if ((size_t)(end - at) < sizeof(record)) {
+			messages->print("Error. The trace ends in the middle of a record.\n");
+			return false;
+		}
+		memcpy(&record, at, sizeof(record));
+		if (record.flags & TraceRecord::segment) return true; /* The next run */
+		at += sizeof(record);
+		++records;
+
+		typename Machine::Decoded in;
+		Machine::decodeBytes(record.bytes, in);
+		const Word pc = record.pc;
+		regs[0xF] = pc;
+		to = shown(record)? &out : NULL;
+		PRINT("  [0x%02X] : 0x%02X", pc, in.opcode);
+
+		/* What it wrote, before the lines that show it */
+		if (record.flags & TraceRecord::wroteMem) {
+			if (record.flags & TraceRecord::wroteWord)
+				for (int index = 0; index < addrBytes; ++index) mem[(Word)(record.address + index)] = (unsigned char)(record.memValue >> (8 * index));
+			else mem[(Word) record.address] = (unsigned char) record.memValue;
+		}
+		const Word value = (Word) record.regValue;
+		const bool wroteReg = (record.flags & TraceRecord::wroteReg) != 0;
+
+		if (record.flags & TraceRecord::waited) {
+			PRINT("\t\t\tEmulator Input. Waiting for input\n");
+			continue;
+		}
+		if (record.flags & TraceRecord::faulted) {
+			switch (in.opcode & 0xF0) {
+				case 0x80: PRINT("\nSegmentation fault. Unable to push 0x%02X because at address 0.\n", regs[in.a]); continue;
+				case 0x90: PRINT("\nSegmentation fault. At the edge of memory, unable to pop into regs[0x%01X]. Exiting...\n", in.a); continue;
+			}
+			if (in.opcode == 0xC2) PRINT(" 0x%02X\nSegmentation fault. At the edge of memory, unable to push return address [0x%02X] onto the stack.\n", in.next1, (Word)(pc + 1 + addrBytes))
+			else if (in.opcode == 0xC3) PRINT("\nSegmentation fault. At the edge of memory, unable to pop return address.\n")
+			else PRINT("\nInvalid opcode: 0x%02X at mem[0x%02X] Exiting...\n", in.opcode, pc)
+			continue;
+		}
+
+		switch (in.opcode & 0xF0) {
+			case 0x00: /* "movA val" */
+				regs[in.a] = in.imm1;
+				PRINT(" 0x%02X\t\tregs[0x%01X] = 0x%02X\n", in.next1, in.a, in.imm1);
+				continue;
+			case 0x80: /* "pushA" */
+				regs[0xE] -= addrBytes;
+				PRINT("\t\t\tPushed regs[0x%01X]=0x%02X to [0x%02X]\n", in.a, readWord(regs[0xE]), regs[0xE]);
+				continue;
+			case 0x90: /* "popA" */
+				regs[in.a] = value;
+				PRINT("\t\t\tPopped 0x%02X from [0x%02X] into regs[0x%01X]\n", regs[in.a], regs[0xE], in.a);
+				regs[0xE] += addrBytes;
+				continue;
+		}
+		const Word compared = regs[0x0]; /* What "cas AB" compared with, before it writes regs[0x0] */
+		if (wroteReg) regs[record.reg & 0xF] = value;
+		switch (in.opcode) {
+			case 0x10: PRINT(" 0x%02X\t\tregs[0x%01X] = regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x11: PRINT(" 0x%02X\t\tregs[0x%01X] = mem[regs[0x%01X]]\n", in.next1, in.a, in.b); break;
+			case 0x12: PRINT(" 0x%02X\t\tmem[regs[0x%01X]] = regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x13: PRINT(" 0x%02X\t\tmem[regs[0x%01X]] = mem[regs[0x%01X]]\n", in.next1, in.a, in.b); break;
+			case 0x14:
+				regs[in.b] = value;
+				PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%02X, regs[0x%01X] = 0x%02X\n", in.next1, in.next2, in.a, in.imm1, in.b, in.imm1);
+				break;
+			case 0x15: PRINT(" 0x%02X\t\tregs[0x%01X] += 0x%01X\n", in.next1, in.a, in.b); break;
+			case 0x16: PRINT(" 0x%02X\t\tregs[0x%01X] -= 0x%01X\n", in.next1, in.a, in.b); break;
+			case 0x17: PRINT(" 0x%02X\t\tregs[0x%01X] = regs[0xF] + 0x%02X\n", in.next1, in.a, in.b); break;
+			case 0x18: PRINT(" 0x%02X\t\tregs[0x%01X] = regs[0xF] - 0x%02X\n", in.next1, in.a, in.b); break;
+			case 0x19: /* "cas AB", it swapped if it found what it compared with */
+				if (value == compared) PRINT(" 0x%02X\t\t(cas) mem[regs[0x%01X]] = regs[0x%01X]\n", in.next1, in.a, in.b)
+				else PRINT(" 0x%02X\t\t(cas) No swap. regs[0x0] = 0x%02X\n", in.next1, value)
+				break;
+			case 0x1A: PRINT(" 0x%02X\t\tmem[regs[0x%01X]] += regs[0x%01X], regs[0x%01X] = 0x%02X\n", in.next1, in.a, in.b, in.b, value); break;
+			case 0x20: PRINT(" 0x%02X\t\tregs[0x%01X] &= regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x30: PRINT(" 0x%02X\t\tregs[0x%01X] |= regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x40: PRINT(" 0x%02X\t\tregs[0x%01X] ^= regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x50: PRINT(" 0x%02X\t\tregs[0x%01X] << regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x51: PRINT(" 0x%02X\t\tregs[0x%01X] >> regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0x52: PRINT(" 0x%02X\t\treg[0x%01X] = (reg[0x%01X] >> 8-(reg[0x%01X]%%8)) + (reg[0x%01X] << (reg[0x%01X]%%8))\n", in.next1, in.a, in.a, in.b, in.a, in.b); break;
+			case 0x53: PRINT(" 0x%02X\t\treg[0x%01X] = (reg[0x%01X] << 8-(reg[0x%01X]%%8)) + (reg[0x%01X] >> (reg[0x%01X]%%8))\n", in.next1, in.a, in.a, in.b, in.a, in.b); break;
+			case 0x70: PRINT(" 0x%02X\t\t(jmp) Jumping to [0x%02X]\n", in.next1, in.imm1); break;
+			case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: { /* Conditional jumps, the registers are as they were */
+				static const char * const names[] = {"jl", "jle", "je", "jge", "jg", "jne"};
+				Word left = regs[in.a], right = regs[in.b];
+				bool taken = (in.opcode == 0x71)? left < right : (in.opcode == 0x72)? left <= right : (in.opcode == 0x73)? left == right
+					: (in.opcode == 0x74)? left >= right : (in.opcode == 0x75)? left > right : left != right;
+				if (taken) PRINT(" 0x%02X 0x%02X\t(%s) Jumping to [0x%02X]\n", in.next1, in.next2, names[in.opcode - 0x71], in.imm1)
+				else PRINT(" 0x%02X 0x%02X\t(%s) No jump.\n", in.next1, in.next2, names[in.opcode - 0x71])
+				break;
+			}
+			case 0x77: case 0x78: { /* "skipIfNZ AB", "skipIfZ AB" */
+				const char * name = (in.opcode == 0x77)? "skipIfNZ" : "skipIfZ";
+				if ((regs[in.a] != 0) == (in.opcode == 0x77)) PRINT(" 0x%02X\t\t(%s) Skipping to [0x%02X]\n", in.next1, name, (Word)(pc + in.b + 2))
+				else PRINT(" 0x%02X\t\t(%s) No skip.\n", in.next1, name)
+				break;
+			}
+			case 0xA0: PRINT(" 0x%02X\t\tregs[0x%01X] += regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0xA1: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] + mem[0x%02X]\n", in.next1, in.next2, in.a, in.b, in.imm1); break;
+			case 0xA2: PRINT(" 0x%02X 0x%02X\tmem[0x%02X] = regs[0x%01X] + regs[0x%01X]\n", in.next1, in.next2, in.imm1, in.a, in.b); break;
+			case 0xA3: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] + 0x%02X\n", in.next1, in.next2, in.a, in.b, in.imm1); break;
+			case 0xA4: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X * 0x%02X\n", in.next1, in.next2, in.a, in.b, in.imm1); break;
+			case 0xA5: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X + 0x%02X\n", in.next1, in.next2, in.a, in.b, in.imm1); break;
+			case 0xA6: PRINT(" 0x%02X 0x%02X 0x%02X\tregs[0x%01X] = 0x%01X * 0x%02X + 0x%02X\n", in.next1, in.next2, in.imm2, in.a, in.b, in.imm1, in.imm2); break;
+			case 0xA7: PRINT(" 0x%02X\t\tregs[0x%01X] -= regs[0x%01X]\n", in.next1, in.a, in.b); break;
+			case 0xA8: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] - mem[0x%02X]\n", in.next1, in.next2, in.a, in.b, in.imm1); break;
+			case 0xA9: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = mem[0x%02X] - regs[0x%01X]\n", in.next1, in.next2, in.a, in.imm1, in.b); break;
+			case 0xAA: PRINT(" 0x%02X 0x%02X\tmem[0x%02X] = regs[0x%01X] - regs[0x%01X]\n", in.next1, in.next2, in.imm1, in.a, in.b); break;
+			case 0xAB: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = regs[0x%01X] - 0x%02X\n", in.next1, in.next2, in.a, in.b, in.imm1); break;
+			case 0xAC: PRINT(" 0x%02X 0x%02X\tregs[0x%01X] = 0x%02X - regs[0x%01X]\n", in.next1, in.next2, in.a, in.imm1, in.b); break;
+			case 0xC2: /* "call adr" */
+				regs[0xE] -= addrBytes;
+				PRINT(" 0x%02X\t\tCalling [0x%02X]\n", in.next1, in.imm1);
+				break;
+			case 0xC3: /* "ret" */
+				regs[0xE] += addrBytes;
+				PRINT("\t\t\tReturning to [0x%02X]\n", regs[0xF]);
+				break;
+			case 0xD0: PRINT("\t\t\tDoing nothing\n"); break;
+			case 0xE0: PRINT("\t\t\tEmulator Output. putchar(regs[0x1]) = '%c'\n", (regs[0x1] != '\n')? regs[0x1] : 1); break;
+			case 0xE1:
+				PRINT("\t\t\tEmulator Input. regs[0x0] = getchar(int)\n");
+				if (prompt) PRINT("Enter an integer value (of a char): ");
+				break;
+			case 0xE2: /* "printstr char[],0", the string as it was in memory */
+				PRINT("\t\t\tEmulator String Output: ");
+				for (Word address = pc + 1; mem[address] != 0; ++address) PRINT("%c", mem[address]);
+				PRINT("\n");
+				break;
+			case 0xE3: PRINT(" 0x%02X\t\tEmulator Spawn. No free core to start at [0x%02X], regs[0x0] = 0x00\n", in.next1, in.imm1); break;
+			case 0xE4: PRINT("\t\t\tEmulator Join. No core 0x%02X to wait for, regs[0x0] = 0x00\n", regs[0x1]); break;
+			case 0xE8: PRINT("\t\t\tEmulator Register Dump. Dumping register 0x0.\n"); dumpRegs(0x0); break;
+			case 0xE9: PRINT("\t\t\tEmulator Register Dump. Dumping register 0x1.\n"); dumpRegs(0x1); break;
+			case 0xEA: PRINT("\t\t\tEmulator Memory Dump. Dumping all memory.\n"); dumpMemRange(0, n_mem - 1); break;
+			case 0xEB:
+				PRINT("\t\t\tEmulator Memory Range Dump. Dumping memory range [0x%02X] to [0x%02X]\n", regs[0x1], regs[0x2]);
+				dumpMemRange(regs[0x1], regs[0x2]);
+				break;
+			case 0xEC: PRINT("\t\t\tEmulator Register Dump. Dumping register 0x%01X.\n", regs[0x1]); dumpRegs(regs[0x1]); break;
+			case 0xED: /* "dump id", as ByteSyzedT::dump */
+				PRINT(" 0x%02X\t\tEmulator Generic Dump. Dump id = 0x%02X\n", in.next1, in.imm1);
+				if (in.imm1 == 0xFD || in.imm1 == 0xFE) dumpMemRange(0, n_mem - 1);
+				if (in.imm1 == 0xFD || in.imm1 == 0xFF) dumpRegs(0xFF);
+				if (in.imm1 < n_regs) dumpRegs(in.imm1);
+				else if (in.imm1 < 0xFD) PRINT("Invalid dump id: %i. Disabled dump.\n", in.imm1);
+				break;
+			case 0xEE: PRINT("\t\t\tEmulator Exit. Returning 0x%02X\n", regs[0x0]); break;
+			case 0xEF: PRINT("\t\t\tEmulator Debug. Dumping to file debug.txt\n"); break;
+		}
+	}
+#undef PRINT
+	return true;
+}
\ No newline at end of file
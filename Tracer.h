@@ -0,0 +1,85 @@
+/*	Tracer.h
+*
+*	ByteSyzed Binary Trace Header.
+*
+*	A recorded run (ByteSyzedT::Recorded, or run() with trace set) writes
+*	one fixed size TraceRecord per instruction instead of formatting a line
+*	of text, cheap enough to leave on. TraceFile takes the records off the
+*	engine's hands through a ring of blocks that a background thread writes
+*	to a file, and TraceDecoder reads them back as the text a verbose run
+*	prints, optionally only some steps, addresses or opcodes of it.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include "ByteSyzed.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/* Trace kept in memory, e.g. for tests. Decode bytes() with TraceDecoder::decode */
+class MemoryTrace : public TraceOutput {
+public:
+	~MemoryTrace() {}
+	const std::string & bytes(void) { flush(); return stored; } /* Everything recorded so far */
+	void clear(void) { flush(); stored.clear(); }
+
+protected:
+	void drain(const char * bytes, size_t count) { stored.append(bytes, count); }
+
+private:
+	std::string stored;
+};
+
+/* Trace written to a file by a background thread, so the engine only copies blocks of records */
+class TraceFile : public TraceOutput {
+public:
+	unsigned long long waits = 0; /* Times the engine found every block full and waited on the disk */
+
+	~TraceFile() { close(); }
+	bool open(const char * fileName, EmulatorOutput * messages = &standardOutput); /* Starts the file and the thread writing it */
+	bool close(void); /* Writes everything recorded and stops the thread. False if a write failed */
+
+protected:
+	void drain(const char * bytes, size_t count);
+
+private:
+	enum {blocks=8}; /* Blocks the engine can be ahead of the disk */
+	std::string ring[blocks];
+	int head = 0, filled = 0; /* Next block to fill, and blocks waiting to be written */
+	bool stopping = false, failed = false;
+	std::mutex lock;
+	std::condition_variable wake, room; /* Signal the writer, signal the engine */
+	std::thread writer;
+	FILE * file = NULL;
+
+	void writeBlocks(void); /* The background thread */
+};
+
+/* Turns a trace back into the text verbose runs print. Lines of the instructions left out by the filters are not printed */
+class TraceDecoder {
+public:
+	unsigned long long firstStep = 0, lastStep = ~0ULL; /* Only steps in this range */
+	long firstAddress = 0, lastAddress = 0xFFFF; /* Only instructions at these addresses */
+	int opcode = -1; /* Only this opcode, -1 for every one */
+	unsigned long long records = 0; /* Instructions in the last trace decoded */
+
+	bool decode(const char * bytes, size_t size, EmulatorOutput & out, EmulatorOutput * messages = &standardOutput); /* Decodes records (as a TraceOutput gets them) */
+	bool decodeFile(const char * fileName, EmulatorOutput & out, EmulatorOutput * messages = &standardOutput); /* Decodes a file TraceFile wrote */
+
+	static const char traceMagic[4];
+	enum {fileHeaderSize=8};
+
+private:
+	template <int AddrBits> bool decodeSegment(const char *& at, const char * end, EmulatorOutput & out, EmulatorOutput * messages);
+	bool shown(const TraceRecord & record) const {
+		return firstStep <= record.step && record.step <= lastStep && firstAddress <= record.pc && record.pc <= lastAddress && (opcode < 0 || opcode == record.bytes[0]);
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*	assemble.cpp
+*
+*	ByteSyzed assembler.
+*
+*	Assembles a program written with mnemonics and labels (see Assembler.h
+*	for the source format) into a binary image, if the output file name
+*	ends in .bsz, or into the text input file format otherwise.
+*
+*	Usage: assemble input.s output [-w]
+*	-w assembles for the 16 bit machine.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Assembler.h"
+#include <string.h>
+
+/* Assembles and saves, the same for every address width */
+template <class Assembler>
+static int assembleTo(const char * inputFileName, const char * outputFileName) {
+	static Assembler assembler;
+	if (!assembler.assembleFile(inputFileName)) {
+		standardOutput.flush(); /* Its messages first */
+		printf("Error. Not saved.\n");
+		return 0;
+	}
+
+	size_t length = strlen(outputFileName);
+	bool image = length >= 4 && strcmp(outputFileName + length - 4, ".bsz") == 0;
+	if (!(image? assembler.saveImage(outputFileName) : assembler.saveText(outputFileName))) {
+		standardOutput.flush();
+		printf("Error. Failed to save.\n");
+		return 0;
+	}
+
+	standardOutput.flush();
+	printf("Saved %i bytes at 0x%02X (starting at 0x%02X) to %s\n", (int) assembler.program.size(), assembler.first, assembler.entry, outputFileName);
+	return 1;
+}
+
+int main(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s input.s output [-w]\n", argv[0]);
+		return 0;
+	}
+
+	if (argc > 3 && strcmp(argv[3], "-w") == 0) return assembleTo<Assembler16>(argv[1], argv[2]);
+	return assembleTo<Assembler>(argv[1], argv[2]);
+}
@@ -0,0 +1,229 @@
+/*	benchmark.cpp
+*
+*	ByteSyzed engine benchmark.
+*
+*	Runs a loop-heavy program on every engine the build has, restored from
+*	a snapshot, recorded into a journal, through the batch runner and the
+*	lockstep engine, and reports instructions per second for each. Then times the scheduler
+*	echoing numbers for thousands of machines at once.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "ByteSyzed.h"
+#include "BatchRunner.h"
+#include "Lockstep.h"
+#include "Journal.h"
+#include "Scheduler.h"
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/* Nested counting loop, about 260 thousand instructions per run */
+static const unsigned char loopProgram[] = {
+	0x14, 0x23, 0x00, /* 0x00: r2 = r3 = 0 */
+	0x04, 0xFF, /* 0x03: r4 = 0xFF */
+	0x15, 0x31, /* 0x05: r3 += 1 */
+	0xA0, 0x53, /* 0x07: r5 += r3 */
+	0x40, 0x65, /* 0x09: r6 ^= r5 */
+	0x76, 0x34, 0x05, /* 0x0B: jne r3, r4, 0x05 */
+	0x15, 0x21, /* 0x0E: r2 += 1 */
+	0x76, 0x24, 0x05, /* 0x10: jne r2, r4, 0x05 */
+	0xEE /* 0x13: exit */
+};
+
+/* Times repeated runs of the program with one engine */
+static void bench(const char * name, unsigned char (ByteSyzed::*engine)(void), int runs) {
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	cpu.verbose = false;
+	unsigned long long instructions = 0;
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int run = 0; run < runs; ++run) {
+		cpu.wipeMemory();
+		memcpy(cpu.mem, loopProgram, sizeof(loopProgram));
+		(cpu.*engine)();
+		instructions += cpu.steps;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	printf("%-10s %12llu instructions %8.3f s %10.2f MIPS\n", name, instructions, seconds, instructions / seconds / 1e6);
+}
+
+/* Times repeated runs restored from a snapshot, which keeps the translated blocks between runs */
+static void benchSnapshot(int runs) {
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static ByteSyzed::Snapshot snapshot;
+	cpu.verbose = false;
+	cpu.wipeMemory();
+	memcpy(cpu.mem, loopProgram, sizeof(loopProgram));
+	cpu.boot();
+	cpu.saveSnapshot(snapshot);
+	unsigned long long instructions = 0;
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int run = 0; run < runs; ++run) {
+		cpu.restoreSnapshot(snapshot);
+		cpu.resumeBlocks();
+		instructions += cpu.steps;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	printf("%-10s %12llu instructions %8.3f s %10.2f MIPS\n", "snapshot", instructions, seconds, instructions / seconds / 1e6);
+}
+
+/* Times repeated runs from a snapshot recorded into a journal, a checkpoint every 10000 instructions, to compare with the snapshot runs */
+static void benchJournal(int runs) {
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static ByteSyzed::Snapshot snapshot;
+	static Journal journal;
+	cpu.verbose = false;
+	cpu.wipeMemory();
+	memcpy(cpu.mem, loopProgram, sizeof(loopProgram));
+	cpu.boot();
+	cpu.saveSnapshot(snapshot);
+	journal.interval = 10000;
+	unsigned long long instructions = 0;
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int run = 0; run < runs; ++run) {
+		cpu.restoreSnapshot(snapshot);
+		journal.clear();
+		journal.record(cpu);
+		instructions += cpu.steps;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	printf("%-10s %12llu instructions %8.3f s %10.2f MIPS\n", "journal", instructions, seconds, instructions / seconds / 1e6);
+}
+
+/* Times a batch of copies of the program, to see how the batch runner scales with threads */
+static void benchBatch(int threads, int runs) {
+	BatchRunner batch;
+	for (int run = 0; run < runs; ++run)
+		batch.addImage(loopProgram, sizeof(loopProgram));
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<BatchRunner::Result> results = batch.run(threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	unsigned long long instructions = 0;
+	for (int index = 0; index < (int) results.size(); ++index)
+		instructions += results[index].steps;
+
+	char name[32];
+	snprintf(name, sizeof(name), "batch x%i", threads);
+	printf("%-10s %12llu instructions %8.3f s %10.2f MIPS\n", name, instructions, seconds, instructions / seconds / 1e6);
+}
+
+/* Times the lockstep engine running copies of the program side by side */
+template <int Lanes>
+static void benchLockstep(int runs) {
+	std::vector<std::string> inputs(runs);
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<BatchRunner::Result> results = Lockstep<Lanes>::sweep(loopProgram, sizeof(loopProgram), inputs, 1000000000ULL);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	unsigned long long instructions = 0;
+	for (int index = 0; index < (int) results.size(); ++index)
+		instructions += results[index].steps;
+
+	char name[32];
+	snprintf(name, sizeof(name), "lockstep%i", Lanes);
+	printf("%-10s %12llu instructions %8.3f s %10.2f MIPS\n", name, instructions, seconds, instructions / seconds / 1e6);
+}
+
+#if !defined(_WIN32)
+/* Echoes every number it reads with putchar, until it reads 0 */
+static const unsigned char echoProgram[] = {
+	0xE1, /* 0x00: getchar */
+	0x73, 0x02, 0x09, /* 0x01: je r0, r2, 0x09 */
+	0x10, 0x10, /* 0x04: r1 = r0 */
+	0xE0, /* 0x06: putchar */
+	0x70, 0x00, /* 0x07: jmp 0x00 */
+	0xEE /* 0x09: exit */
+};
+
+/* Times the scheduler running echo machines on socket pairs, fed a few numbers at a time so most of them wait on input */
+static void benchScheduler(int threads, int machines, int rounds) {
+	Scheduler scheduler;
+	std::vector<int> feeds;
+	for (int index = 0; index < machines; ++index) {
+		int pair[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) break; /* Out of descriptors, run with what there is */
+		feeds.push_back(pair[0]);
+		scheduler.add(echoProgram, sizeof(echoProgram), pair[1], pair[1]);
+	}
+	machines = (int) feeds.size();
+
+	auto begin = std::chrono::steady_clock::now();
+	std::thread feeder([&]() {
+		for (int round = 0; round <= rounds; ++round) {
+			for (int index = 0; index < machines; ++index) {
+				const char * number = (round < rounds)? "65 " : "0\n";
+				if (write(feeds[index], number, strlen(number)) < 0) return;
+			}
+		}
+	});
+	scheduler.run(threads);
+	feeder.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	unsigned long long instructions = 0, echoed = 0;
+	for (int index = 0; index < machines; ++index) {
+		instructions += scheduler.machine(index).state.steps;
+		char buffer[256];
+		ssize_t count;
+		while ((count = recv(feeds[index], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+			echoed += count;
+		close(feeds[index]);
+		close(scheduler.machine(index).inputFd);
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "sched x%i", threads);
+	printf("%-10s %12llu instructions %8.3f s %10.2f MIPS, %i machines of %i bytes echoed %llu of %llu\n", name, instructions, seconds, instructions / seconds / 1e6,
+		machines, (int) sizeof(Scheduler::Machine), echoed, (unsigned long long) machines * rounds);
+}
+#endif
+
+int main(int argc, const char * argv[]) {
+	int runs = 200;
+
+	/* Number of runs per engine can be passed in */
+	if (argc > 1) runs = atoi(argv[1]);
+
+	bench("switch", &ByteSyzed::runSwitch<ByteSyzed::Silent>, runs);
+#if BYTESYZED_THREADED
+	bench("threaded", &ByteSyzed::runThreaded<ByteSyzed::Silent>, runs);
+#endif
+	bench("blocks", &ByteSyzed::runBlocks, runs);
+	benchSnapshot(runs);
+	benchJournal(runs);
+
+	/* Batch runner, one thread then doubling up to one per core */
+	int cores = (int) std::thread::hardware_concurrency();
+	for (int threads = 1; threads < cores; threads *= 2)
+		benchBatch(threads, runs);
+	benchBatch(cores > 0? cores : 1, runs);
+
+	/* Lockstep engine, one thread */
+	benchLockstep<16>(runs);
+	benchLockstep<32>(runs);
+	benchLockstep<64>(runs);
+
+#if !defined(_WIN32)
+	/* Scheduler, thousands of machines mostly waiting on input */
+	benchScheduler(1, 4096, 64);
+	benchScheduler(cores > 0? cores : 1, 4096, 64);
+#endif
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*	convert.cpp
+*
+*	ByteSyzed text to binary image converter.
+*
+*	Loads a program in the text input file format and saves it as a binary
+*	image (see ByteSyzed::saveImage), which loads without any parsing. An
+*	image is saved again from where it loaded, with the same entry point.
+*
+*	Usage: convert input.txt output.bsz [progStart]
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "ByteSyzed.h"
+#include <stdlib.h>
+
+int main(int argc, const char * argv[]) {
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+
+	if (argc < 3) {
+		printf("Usage: %s input.txt output.bsz [progStart]\n", argv[0]);
+		return 0;
+	}
+
+	/* Where the program is loaded, and where it starts */
+	if (argc > 3) cpu.progStart = (unsigned char) strtol(argv[3], NULL, 0);
+
+	if (!cpu.loadFromFile(argv[1])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+
+	/* From where the program loaded, which for an image need not be its entry point */
+	if (!cpu.saveImage(argv[2], cpu.loadedFirst, cpu.loadedCount)) {
+		cpu.output->flush();
+		printf("Error. Failed to save the image.\n");
+		return 0;
+	}
+
+	if (cpu.loadedFirst != cpu.progStart) printf("Saved %i bytes at 0x%02X (starting at 0x%02X) to %s\n", cpu.loadedCount, cpu.loadedFirst, cpu.progStart, argv[2]);
+	else printf("Saved %i bytes at 0x%02X to %s\n", cpu.loadedCount, cpu.progStart, argv[2]);
+	return 1;
+}
\ No newline at end of file
@@ -1,7 +1,7 @@
 #!/bin/bash
 
-# Compiles main.cpp and ByteSyzed.cpp beforehand
-g++-6 -std=c++14 main.cpp ByteSyzed.cpp -o a.out;
+# Compiles main.cpp, ByteSyzed.cpp, BatchRunner.cpp, Lockstep.cpp, Journal.cpp, Analyzer.cpp, Tracer.cpp and MultiCore.cpp beforehand
+g++-6 -std=c++14 -pthread main.cpp ByteSyzed.cpp BatchRunner.cpp Lockstep.cpp Journal.cpp Analyzer.cpp Tracer.cpp MultiCore.cpp -o a.out;
 
 # Note "Debug/E1.txt" this debug file requires user input to properly debug
 # Input 0x42 (66 in decimal) to properly debug
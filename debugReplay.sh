@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Compiles main.cpp, ByteSyzed.cpp, BatchRunner.cpp, Lockstep.cpp, Journal.cpp, Analyzer.cpp, Tracer.cpp and MultiCore.cpp beforehand
+g++-6 -std=c++14 -pthread main.cpp ByteSyzed.cpp BatchRunner.cpp Lockstep.cpp Journal.cpp Analyzer.cpp Tracer.cpp MultiCore.cpp -o a.out;
+
+# Note "Debug/E1.txt" reads a number, every file is given 0x42 (66 in decimal)
+# Checkpoints every 10 instructions, so a replay crosses several of them
+for debugFile in Debug/*.txt Examples/*.txt;
+do
+	# Records the run, then replays the whole journal
+	echo 66 | ./a.out --record $debugFile replay.bsj -c 10 >recorded.txt;
+	./a.out --replay replay.bsj >replayed.txt;
+
+	# The replay must print exactly what the recorded run printed
+	if cmp -s recorded.txt replayed.txt
+	then
+		echo "Testing $debugFile replay: Passed";
+	else
+		echo "Testing $debugFile replay: Failed, the output differs";
+		diff recorded.txt replayed.txt;
+	fi
+
+	# debug.txt now holds the replay's fileDump, compared with
+	# the theoretical output of the debugFile through debugger.py
+	case $debugFile in Debug/*) python3 debugger.py debug.txt $debugFile;; esac
+done;
+
+rm -f replay.bsj recorded.txt replayed.txt;
\ No newline at end of file
@@ -0,0 +1,166 @@
+/*	debugSuite.cpp
+*
+*	ByteSyzed native debugging suite.
+*
+*	Runs every debugging file in one process, spread over the batch runner,
+*	and compares the last fileDump of each with the memory and registers
+*	written in its !mem# and !regs# blocks (the same check as debugger.py,
+*	without a process and a debug.txt per file). Lines starting with !input
+*	give the numbers getchar reads.
+*
+*	Usage: debugSuite [-j threads] [files...]
+*	With no files it runs every .txt file in Debug except Test.txt, which
+*	demonstrates a failing check.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "ByteSyzed.h"
+#include "BatchRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <dirent.h>
+#endif
+
+/* What a debugging file expects, two hex digits per entry like debugger.py reads them */
+struct Expected {
+	std::vector<std::string> mem; /* Padded to 256 with "00" */
+	std::vector<std::string> regs;
+	std::string input; /* Numbers for getchar, from the !input lines */
+};
+
+/* Reads the !mem#/!mem! and !regs#/!regs! blocks. Characters 2 and 3 of every line inside a block are one entry */
+static bool readExpected(const char * fileName, Expected & expected) {
+	FILE * file = fopen(fileName, "r");
+	if (file == NULL) return false;
+
+	bool inMem = false, inRegs = false;
+	char line[1024];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (strncmp(line, "!mem#", 5) == 0) inMem = true;
+		else if (strncmp(line, "!mem!", 5) == 0) inMem = false;
+		if (strncmp(line, "!regs#", 6) == 0) inRegs = true;
+		else if (strncmp(line, "!regs!", 6) == 0) inRegs = false;
+		if (strncmp(line, "!input", 6) == 0) expected.input += std::string(line + 6) + " ";
+
+		/* The opening line of a block is its first entry, dropped below */
+		size_t length = strlen(line);
+		std::string entry(line + std::min<size_t>(2, length), std::min<size_t>(2, length > 2? length - 2 : 0));
+		if (inMem) expected.mem.push_back(entry);
+		if (inRegs) expected.regs.push_back(entry);
+	}
+	fclose(file);
+
+	if (!expected.mem.empty()) expected.mem.erase(expected.mem.begin());
+	if (!expected.regs.empty()) expected.regs.erase(expected.regs.begin());
+	if (expected.mem.size() < ByteSyzed::n_mem) expected.mem.resize(ByteSyzed::n_mem, "00");
+	return true;
+}
+
+/* Compares the last dump with what was expected. Writes what differs to report, returns false if anything does */
+static bool compare(const Expected & expected, const BatchRunner::Result & result, EmulatorOutput & report) {
+	enum {dumpLines=ByteSyzed::n_mem + ByteSyzed::n_regs, dumpSize=dumpLines * 3}; /* "XX\n" per line */
+	bool passed = true;
+
+	if (!result.loaded) {
+		report.print("Error: Failed to load\n");
+		return false;
+	}
+	if (result.dump.size() < dumpSize) {
+		report.print("Error: No dump (0xEF) was executed\n");
+		return false;
+	}
+	const char * dump = result.dump.data() + result.dump.size() - dumpSize; /* Like debug.txt, only the last dump counts */
+
+	if (expected.mem.size() > ByteSyzed::n_mem) {
+		report.print("Error: Memory exceeds 256 addresses\n");
+		passed = false;
+	}
+	if (expected.regs.size() > ByteSyzed::n_regs) {
+		report.print("Error: Number of registers exceeds 16\n");
+		passed = false;
+	}
+	if (expected.regs.size() < ByteSyzed::n_regs) {
+		report.print("Error: %i registers are unspecified\n", (int)(ByteSyzed::n_regs - expected.regs.size()));
+		return false;
+	}
+
+	for (int index = 0; index < ByteSyzed::n_mem; ++index) {
+		std::string actual(dump + index * 3, 2);
+		if (actual != expected.mem[index]) {
+			report.print(" Error: At address 0x%02x should be %s but is %s\n", index, expected.mem[index].c_str(), actual.c_str());
+			passed = false;
+		}
+	}
+	for (int index = 0; index < ByteSyzed::n_regs; ++index) {
+		std::string actual(dump + (ByteSyzed::n_mem + index) * 3, 2);
+		if (actual != expected.regs[index]) {
+			report.print("Error: Register 0x%02x should be %s but is %s\n", index, expected.regs[index].c_str(), actual.c_str());
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+int main(int argc, const char * argv[]) {
+	std::vector<std::string> files;
+	int threads = 0; /* One per core */
+
+	for (int arg = 1; arg < argc; ++arg) {
+		if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc)
+			threads = atoi(argv[++arg]);
+		else
+			files.push_back(argv[arg]);
+	}
+
+#if !defined(_WIN32)
+	/* Default to every debugging file */
+	if (files.empty()) {
+		DIR * directory = opendir("Debug");
+		if (directory != NULL) {
+			while (struct dirent * entry = readdir(directory)) {
+				size_t length = strlen(entry->d_name);
+				if (length > 4 && strcmp(entry->d_name + length - 4, ".txt") == 0 && strcmp(entry->d_name, "Test.txt") != 0)
+					files.push_back(std::string("Debug/") + entry->d_name);
+			}
+			closedir(directory);
+		}
+		std::sort(files.begin(), files.end());
+	}
+#endif
+	if (files.empty()) {
+		printf("Usage: %s [-j threads] [files...]\n", argv[0]);
+		return 1;
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+
+	std::vector<Expected> expected(files.size());
+	BatchRunner batch;
+	for (int index = 0; index < (int) files.size(); ++index) {
+		if (!readExpected(files[index].c_str(), expected[index]))
+			printf("Can't open %s.\n", files[index].c_str()); /* Fails below, when it does not load */
+		batch.addFile(files[index].c_str(), expected[index].input.c_str());
+	}
+	std::vector<BatchRunner::Result> results = batch.run(threads);
+
+	/* Only failures are printed */
+	int failed = 0;
+	for (int index = 0; index < (int) files.size(); ++index) {
+		MemoryOutput report;
+		if (compare(expected[index], results[index], report)) continue;
+		printf("Testing %s\n%s", files[index].c_str(), report.text().c_str());
+		++failed;
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	printf("\n%i passed, %i failed in %.2f ms\n", (int) files.size() - failed, failed, milliseconds);
+
+	return (failed == 0)? 0 : 1;
+}
\ No newline at end of file
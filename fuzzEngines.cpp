@@ -0,0 +1,439 @@
+/*	fuzzEngines.cpp
+*
+*	ByteSyzed differential fuzzer.
+*
+*	Runs random programs on every engine the build has (switch, threaded,
+*	blocks, stepped in small pieces, profiled, watched and stopped at every
+*	instruction, every lane of the lockstep engine and a single core of the
+*	multi-core machine) and on the reference model (see Reference.h), for
+*	a bounded number of steps, and checks they end the same: status, steps,
+*	registers, memory, output and fileDump text. Lane 0 of the lockstep
+*	engine reads the case's numbers and every other lane its own variation
+*	of them, each checked against the model run on the same numbers. The
+*	lockstep engine has no fileDump, so its dump text is not compared.
+*
+*	A test case is a start address byte, a 256 byte image loaded at 0, and
+*	the numbers getchar reads, one per remaining byte. Programs are made of
+*	valid instructions with random operands most of the time, random bytes
+*	otherwise. A case that differs is printed and, with -w, saved as
+*	fuzz-<n>.bin for replay (pass the files back as arguments).
+*
+*	Usage: fuzzEngines [-n execs] [-s seed] [-j threads] [-m maxSteps] [-b 8|16] [-w] [files...]
+*
+*	Built with -DBYTESYZED_LIBFUZZER (clang -fsanitize=fuzzer), the same
+*	check is LLVMFuzzerTestOneInput and a difference aborts.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "ByteSyzed.h"
+#include "Lockstep.h"
+#include "MultiCore.h"
+#include "Reference.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Ways a case can end, for the summary */
+enum Outcome {exitedCase, faultedCase, outOfStepsCase, endlessCase, outcomes};
+
+/* Runs cases on every engine of one address width, and compares them with the reference model */
+template <int AddrBits>
+class Differ {
+public:
+	typedef ByteSyzedT<AddrBits> Machine;
+	typedef ReferenceT<AddrBits> Model;
+	enum {imageSize=256}; /* Bytes of a case loaded at address 0 */
+
+	unsigned long long maxSteps;
+	std::string report; /* What differed in the last check */
+
+	explicit Differ(unsigned long long maxSteps) : maxSteps(maxSteps), cpu(new Machine), model(new Model), cores(new MultiCoreT<AddrBits>) {
+		cpu->verbose = false;
+		cpu->prompt = false;
+		cpu->output = &output;
+		cpu->input = &input;
+		cpu->dumpOutput = &dump;
+		cores->coreCount = 1; /* spawn finds no free core, as on the engines */
+		cores->prompt = false;
+		cores->output = &output;
+		cores->input = &input;
+		cores->dumpOutput = &dump;
+		watch.reset(new typename Machine::Watch);
+		watch->watch(0, Machine::n_mem - 1, Machine::Watch::read | Machine::Watch::write | Machine::Watch::execute);
+		watch->heatmap(true);
+		watch->stop = true;
+	}
+
+	/* Runs a case everywhere. False (and report) if an engine ends differently from the reference model */
+	bool check(const unsigned char * data, size_t size, Outcome & outcome) {
+		unsigned char image[imageSize] = {0};
+		unsigned char start = (size > 0)? data[0] : 0;
+		if (size > 1) memcpy(image, data + 1, std::min<size_t>(size - 1, imageSize));
+		input.clear();
+		for (size_t index = 1 + imageSize; index < size; ++index) input.push(data[index]);
+		report.clear();
+
+		memset(model->mem, 0, sizeof(model->mem));
+		memcpy(model->mem, image, imageSize);
+		model->input = input.values;
+		model->boot(start);
+		model->run(maxSteps);
+		if (model->endless) { /* The engines would print forever */
+			outcome = endlessCase;
+			return true;
+		}
+		outcome = (model->status == Machine::exited)? exitedCase : (model->status == Machine::faulted)? faultedCase : outOfStepsCase;
+
+		bool same = true;
+		same &= compareEngine("switch", image, start, &Differ::runSwitch);
+#if BYTESYZED_THREADED
+		same &= compareEngine("threaded", image, start, &Differ::runThreaded);
+#endif
+		same &= compareEngine("blocks", image, start, &Differ::runBlocks);
+		same &= compareEngine("stepped", image, start, &Differ::runStepped);
+		same &= compareEngine("profiled", image, start, &Differ::runProfiled);
+		same &= compareEngine("watched", image, start, &Differ::runWatched);
+		same &= compareLockstep(image, start);
+		same &= compareMultiCore(image, start);
+		return same;
+	}
+
+private:
+	std::unique_ptr<Machine> cpu; /* Reused by every engine, a 16 bit one is large */
+	std::unique_ptr<Model> model;
+	std::unique_ptr<Model[]> laneModels; /* The reference run of every lockstep lane but 0, made on first use */
+	std::unique_ptr<MultiCoreT<AddrBits> > cores;
+	typename Machine::Profile profile;
+	std::unique_ptr<typename Machine::Watch> watch;
+	MemoryOutput output, dump;
+	QueueInput input;
+	Lockstep<16> lockstep;
+
+	void runSwitch(void) { cpu->stepLimit = maxSteps; cpu->template runSwitch<typename Machine::Silent>(); cpu->stepLimit = ~0ULL; }
+#if BYTESYZED_THREADED
+	void runThreaded(void) { cpu->stepLimit = maxSteps; cpu->template runThreaded<typename Machine::Silent>(); cpu->stepLimit = ~0ULL; }
+#endif
+	void runBlocks(void) { cpu->stepLimit = maxSteps; cpu->runBlocks(); cpu->stepLimit = ~0ULL; }
+	void runProfiled(void) { cpu->profile = &profile; cpu->run(maxSteps); cpu->profile = NULL; }
+
+	/* Every access of every address watched, stopping before each instruction and resuming */
+	void runWatched(void) {
+		watch->events.clear();
+		cpu->watch = watch.get();
+		cpu->boot();
+		while (cpu->step(maxSteps - cpu->steps) == Machine::watchHit) {}
+		cpu->watch = NULL;
+	}
+
+	/* A few instructions at a time, so every engine stop and resume point gets crossed */
+	void runStepped(void) {
+		cpu->boot();
+		for (unsigned long long count = 1; cpu->steps < maxSteps; count = count % 7 + 1) {
+			if (cpu->step((count < maxSteps - cpu->steps)? count : maxSteps - cpu->steps) != Machine::outOfSteps) return;
+		}
+	}
+
+	/* Loads the case into the machine, runs it with an engine and compares the end with the reference model */
+	bool compareEngine(const char * name, const unsigned char * image, unsigned char start, void (Differ::*engine)(void)) {
+		cpu->wipeMemory();
+		cpu->progStart = 0;
+		cpu->loadFromMemory(image, imageSize);
+		cpu->progStart = start;
+		input.next = 0;
+		output.clear();
+		dump.clear();
+		(this->*engine)();
+
+		bool same = true;
+		if (cpu->status != model->status) same = differs(name, "status %i, reference %i", cpu->status, model->status);
+		if (cpu->steps != model->steps) same = differs(name, "steps %llu, reference %llu", cpu->steps, model->steps);
+		for (int index = 0; index < Machine::n_regs; ++index)
+			if (cpu->regs[index] != model->regs[index]) same = differs(name, "regs[0x%X] 0x%02X, reference 0x%02X", index, cpu->regs[index], model->regs[index]);
+		for (int index = 0; index < Machine::n_mem; ++index)
+			if (cpu->mem[index] != model->mem[index]) {
+				same = differs(name, "mem[0x%02X] 0x%02X, reference 0x%02X", index, cpu->mem[index], model->mem[index]);
+				break;
+			}
+		if (output.text() != model->output) same = differs(name, "output \"%s\", reference \"%s\"", output.text().c_str(), model->output.c_str());
+		if (dump.text() != model->dumpText) same = differs(name, "fileDump text differs");
+		return same;
+	}
+
+	/* Every lane of the lockstep engine, lane 0 on the case's numbers and the others on their own, each against the reference model run on the same numbers. Only 8 bit machines have one */
+	bool compareLockstep(const unsigned char * image, unsigned char start) {
+		if (AddrBits != 8) return true;
+		enum {lanes=Lockstep<16>::lanes};
+		if (!laneModels) laneModels.reset(new Model[lanes]);
+		lockstep.load(image, imageSize, 0);
+		lockstep.regs[0xF] = Lockstep<16>::Row::splat(start); /* Same start as boot, with the image at 0 */
+		lockstep.mem[ByteSyzed::n_mem - 1] = Lockstep<16>::Row::splat(start);
+		for (int lane = 0; lane < lanes; ++lane) {
+			Model & expected = (lane == 0)? *model : laneModels[lane];
+			if (lane > 0) {
+				/* The case's numbers moved by 0x11 a lane, then the lane, so lanes differ even when the case has none */
+				expected.input.clear();
+				for (size_t index = 0; index < input.values.size(); ++index) expected.input.push_back((input.values[index] + 0x11 * lane) & 0xFF);
+				expected.input.push_back(lane);
+				memset(expected.mem, 0, sizeof(expected.mem));
+				memcpy(expected.mem, image, imageSize);
+				expected.boot(start);
+				expected.run(maxSteps);
+				if (expected.endless) { /* Its printstr would never stop */
+					lockstep.stop(lane);
+					continue;
+				}
+			}
+			std::string numbers;
+			for (size_t index = 0; index < expected.input.size(); ++index) numbers += std::to_string(expected.input[index]) + " ";
+			lockstep.setInput(lane, numbers.c_str());
+		}
+		lockstep.run(maxSteps);
+
+		bool same = true;
+		for (int lane = 0; lane < lanes; ++lane) {
+			const Model & expected = (lane == 0)? *model : laneModels[lane];
+			if (expected.endless) continue;
+			char name[32];
+			snprintf(name, sizeof(name), "lockstep lane %i", lane);
+			if (lockstep.status[lane] != (unsigned char) expected.status) same = differs(name, "status %i, reference %i", lockstep.status[lane], expected.status);
+			if (lockstep.steps[lane] != expected.steps) same = differs(name, "steps %llu, reference %llu", lockstep.steps[lane], expected.steps);
+			for (int index = 0; index < ByteSyzed::n_regs; ++index)
+				if (lockstep.regs[index][lane] != expected.regs[index]) same = differs(name, "regs[0x%X] 0x%02X, reference 0x%02X", index, lockstep.regs[index][lane], expected.regs[index]);
+			for (int index = 0; index < ByteSyzed::n_mem; ++index)
+				if (lockstep.mem[index][lane] != expected.mem[index]) {
+					same = differs(name, "mem[0x%02X] 0x%02X, reference 0x%02X", index, lockstep.mem[index][lane], expected.mem[index]);
+					break;
+				}
+			if (lockstep.output[lane] != expected.output) same = differs(name, "output \"%s\", reference \"%s\"", lockstep.output[lane].c_str(), expected.output.c_str());
+		}
+		return same;
+	}
+
+	/* Core 0 of the multi-core machine, with no other core to spawn */
+	bool compareMultiCore(const unsigned char * image, unsigned char start) {
+		cores->load(image, imageSize, 0);
+		cores->progStart = start;
+		cores->stepLimit = maxSteps;
+		input.next = 0;
+		output.clear();
+		dump.clear();
+		cores->run();
+
+		const typename MultiCoreT<AddrBits>::Core & core = cores->cores[0];
+		bool same = true;
+		if (core.status != model->status) same = differs("multicore", "status %i, reference %i", core.status, model->status);
+		if (core.steps != model->steps) same = differs("multicore", "steps %llu, reference %llu", core.steps, model->steps);
+		for (int index = 0; index < Machine::n_regs; ++index)
+			if (core.regs[index] != model->regs[index]) same = differs("multicore", "regs[0x%X] 0x%02X, reference 0x%02X", index, core.regs[index], model->regs[index]);
+		for (int index = 0; index < Machine::n_mem; ++index)
+			if (cores->mem[index] != model->mem[index]) {
+				same = differs("multicore", "mem[0x%02X] 0x%02X, reference 0x%02X", index, (unsigned char) cores->mem[index], model->mem[index]);
+				break;
+			}
+		if (output.text() != model->output) same = differs("multicore", "output \"%s\", reference \"%s\"", output.text().c_str(), model->output.c_str());
+		if (dump.text() != model->dumpText) same = differs("multicore", "fileDump text differs");
+		return same;
+	}
+
+	/* Adds a line to report. Always false */
+	bool differs(const char * engine, const char * format, ...) {
+		char line[512];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(line, sizeof(line), format, args);
+		va_end(args);
+		report += std::string("  ") + engine + ": " + line + "\n";
+		return false;
+	}
+};
+
+/* A case as it would be written out, for the report */
+static void printCase(const std::vector<unsigned char> & data) {
+	printf("  start 0x%02X, input", data[0]);
+	for (size_t index = 1 + 256; index < data.size(); ++index) printf(" %i", data[index]);
+	printf("\n  image");
+	for (size_t index = 1; index < data.size() && index < 1 + 256; ++index) printf("%s%02X", ((index - 1) % 32 == 0)? "\n    " : " ", data[index]);
+	printf("\n");
+}
+
+#if defined(BYTESYZED_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char * data, size_t size) {
+	static Differ<8> differ(100);
+	Outcome outcome;
+	if (!differ.check(data, size, outcome)) {
+		printf("Engines differ from the reference model:\n%s", differ.report.c_str());
+		printCase(std::vector<unsigned char>(data, data + size));
+		abort();
+	}
+	return 0;
+}
+
+#else
+
+static const char * outcomeNames[outcomes] = {"exited", "faulted", "out of steps", "endless printstr"};
+
+/* Small, fast generator (xorshift64*), so making cases costs little next to running them */
+struct Random {
+	unsigned long long state;
+	explicit Random(unsigned long long seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+	unsigned int operator()(void) {
+		state ^= state >> 12, state ^= state << 25, state ^= state >> 27;
+		return (unsigned int)((state * 0x2545F4914F6CDD1DULL) >> 32);
+	}
+};
+
+/*
+*	A random case: mostly valid instructions with random operands, sometimes
+*	plain random bytes. Jumps and calls mostly go to the start of an
+*	instruction, and pops and rets are rarer (an empty stack faults them),
+*	so programs run for a while instead of faulting in the first few steps.
+*/
+static std::vector<unsigned char> randomCase(Random & random, int addrBits) {
+	std::vector<unsigned char> data(1 + 256);
+	std::vector<int> starts, jumps; /* Addresses of instructions, and of the jumps and calls among them */
+	bool noise = random() % 8 == 0;
+	data[0] = 0;
+	for (int at = 0; at < 256;) {
+		unsigned char opcode = random() % 256;
+		int length = (addrBits == 8)? ByteSyzed::instructionLength(opcode) : ByteSyzed16::instructionLength(opcode);
+		if (!noise && length == 0 && random() % 256 != 0) continue; /* An invalid opcode now and then */
+		if (!noise && ((opcode & 0xF0) == 0x90 || opcode == 0xC3 || opcode == 0x0F) && random() % 4 != 0) continue;
+		if (!noise && (opcode == 0xEA || opcode == 0xEB || opcode == 0xED || opcode == 0xEF) && random() % 4 != 0) continue; /* Hundreds of lines each, and the time goes into printing them */
+		starts.push_back(at);
+		if ((0x70 <= opcode && opcode <= 0x76) || opcode == 0xC2) jumps.push_back(at);
+		data[1 + at++] = opcode;
+		for (int operand = 1; operand < length && at < 256; ++operand) {
+			/* Small values now and then, as registers, shift amounts and skips usually are */
+			data[1 + at++] = (random() % 4 == 0)? random() % 4 : random() % 256;
+		}
+		/* Writing the program counter jumps somewhere random, keep it rare */
+		int fields = ByteSyzed::registerFields(opcode);
+		if (!noise && length > 1 && starts.back() + 1 < 256 && random() % 4 != 0) {
+			unsigned char & registers = data[1 + starts.back() + 1];
+			if ((fields & ByteSyzed::writesA) && (registers >> 4) == 0xF) registers &= 0x7F;
+			if ((fields & ByteSyzed::writesB) && (registers & 0xF) == 0xF) registers &= 0xF7;
+		}
+	}
+	if (!noise) {
+		for (int at : jumps) {
+			int target = 1 + at + ((data[1 + at] == 0x70 || data[1 + at] == 0xC2)? 1 : 2); /* Where the address operand is */
+			if (target + addrBits / 8 > 1 + 256 || random() % 8 == 0) continue;
+			data[target] = (unsigned char) starts[random() % starts.size()];
+			if (addrBits == 16) data[target + 1] = 0;
+		}
+		if (random() % 2 == 0) data[1 + starts[random() % starts.size()]] = 0xEE; /* Programs that exit, not only fault */
+		if (random() % 4 == 0) data[0] = (unsigned char) starts[random() % starts.size()];
+	}
+	else if (random() % 4 == 0) data[0] = random() % 256;
+	for (int count = random() % 5; count > 0; --count) data.push_back(random() % 256);
+	return data;
+}
+
+/* Replays saved cases, then fuzzes with a few threads */
+template <int AddrBits>
+static int fuzz(unsigned long long execs, unsigned int seed, int threads, unsigned long long maxSteps, bool write, const std::vector<const char *> & files) {
+	std::mutex lock; /* Around printing and saving */
+	std::atomic<unsigned long long> done(0), differing(0);
+	std::atomic<unsigned long long> counts[outcomes];
+	for (int index = 0; index < outcomes; ++index) counts[index] = 0;
+
+	/* Prints a case that differs, and saves it */
+	auto failed = [&](Differ<AddrBits> & differ, const std::vector<unsigned char> & data) {
+		std::lock_guard<std::mutex> guard(lock);
+		unsigned long long number = differing++;
+		if (number >= 10) return; /* Enough to go on */
+		printf("Case %llu differs:\n%s", number, differ.report.c_str());
+		printCase(data);
+		if (!write) return;
+		char name[32];
+		snprintf(name, sizeof(name), "fuzz-%llu.bin", number);
+		FILE * file = fopen(name, "wb");
+		if (file == NULL) return;
+		fwrite(data.data(), 1, data.size(), file);
+		fclose(file);
+		printf("  Saved to %s\n", name);
+	};
+
+	Differ<AddrBits> replay(maxSteps);
+	for (const char * fileName : files) {
+		FILE * file = fopen(fileName, "rb");
+		if (file == NULL) {
+			printf("Error. Unable to open %s\n", fileName);
+			continue;
+		}
+		std::vector<unsigned char> data;
+		for (int byte; (byte = fgetc(file)) != EOF;) data.push_back((unsigned char) byte);
+		fclose(file);
+		Outcome outcome;
+		if (replay.check(data.data(), data.size(), outcome)) printf("%s: same (%s)\n", fileName, outcomeNames[outcome]);
+		else printf("%s: differs\n%s", fileName, replay.report.c_str());
+	}
+	if (!files.empty() && execs == 0) return 1;
+
+	if (threads <= 0) threads = (int) std::thread::hardware_concurrency();
+	if (threads <= 0) threads = 1; /* Unknown core count */
+	auto begin = std::chrono::steady_clock::now();
+	auto work = [&](int worker) {
+		Differ<AddrBits> differ(maxSteps);
+		Random random(seed + worker * 7919ULL);
+		unsigned long long local[outcomes] = {0};
+		for (unsigned long long exec = worker; exec < execs; exec += threads) {
+			std::vector<unsigned char> data = randomCase(random, AddrBits);
+			Outcome outcome;
+			if (!differ.check(data.data(), data.size(), outcome)) failed(differ, data);
+			++local[outcome];
+		}
+		for (int index = 0; index < outcomes; ++index) counts[index] += local[index];
+	};
+	std::vector<std::thread> pool;
+	for (int worker = 1; worker < threads; ++worker)
+		pool.push_back(std::thread(work, worker));
+	work(0);
+	for (auto & thread : pool)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	printf("%llu cases on %i threads in %.2f s, %.0f cases/s, at most %llu steps each\n", execs, threads, seconds, execs / seconds, maxSteps);
+	for (int index = 0; index < outcomes; ++index)
+		printf("  %-17s %llu\n", outcomeNames[index], (unsigned long long) counts[index]);
+	printf("%llu differ\n", (unsigned long long) differing);
+	return differing == 0;
+}
+
+int main(int argc, const char * argv[]) {
+	unsigned long long execs = 100000, maxSteps = 100;
+	unsigned int seed = 1;
+	int threads = 0, addrBits = 8;
+	bool write = false, counted = false;
+	std::vector<const char *> files;
+
+	for (int index = 1; index < argc; ++index) {
+		bool value = index + 1 < argc;
+		if (strcmp(argv[index], "-n") == 0 && value) execs = strtoull(argv[++index], NULL, 0), counted = true;
+		else if (strcmp(argv[index], "-s") == 0 && value) seed = (unsigned int) strtoul(argv[++index], NULL, 0);
+		else if (strcmp(argv[index], "-j") == 0 && value) threads = atoi(argv[++index]);
+		else if (strcmp(argv[index], "-m") == 0 && value) maxSteps = strtoull(argv[++index], NULL, 0);
+		else if (strcmp(argv[index], "-b") == 0 && value) addrBits = atoi(argv[++index]);
+		else if (strcmp(argv[index], "-w") == 0) write = true;
+		else if (argv[index][0] == '-') {
+			printf("Usage: %s [-n execs] [-s seed] [-j threads] [-m maxSteps] [-b 8|16] [-w] [files...]\n", argv[0]);
+			return 0;
+		}
+		else files.push_back(argv[index]);
+	}
+	if (!files.empty() && !counted) execs = 0; /* Only replay */
+
+	if (addrBits == 16) return fuzz<16>(execs, seed, threads, maxSteps, write, files);
+	return fuzz<8>(execs, seed, threads, maxSteps, write, files);
+}
+
+#endif
\ No newline at end of file
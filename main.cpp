@@ -10,12 +10,393 @@
 *
 *	Written by Charles Emerson (cjemerson AT alaska.edu)
 *	Created: 9/29/2017
-*	Last Edited: 10/15/2017
+*	Last Edited: 10/17/2026
 */
 
 #include "ByteSyzed.h"
+#include "BatchRunner.h"
+#include "Lockstep.h"
+#include "Journal.h"
+#include "Analyzer.h"
+#include "Tracer.h"
+#include "MultiCore.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Prints one program's output, then how it ended */
+static void printResult(const char * name, const BatchRunner::Result & result) {
+	printf("==== %s ====\n", name);
+	fwrite(result.output.data(), 1, result.output.size(), stdout);
+	if (!result.output.empty() && result.output[result.output.size() - 1] != '\n') printf("\n");
+	if (result.loaded && result.status == ByteSyzed::outOfSteps)
+		printf("==== stopped after %llu instructions ====\n", result.steps);
+	else if (result.loaded)
+		printf("==== exit 0x%02X after %llu instructions ====\n", result.exitCode, result.steps);
+	else
+		printf("==== not loaded ====\n");
+}
+
+/* Batch mode: main --batch [-j threads] [-n maxSteps] file... Runs every file on its own instance, then prints each result in order */
+static int runBatch(int argc, const char * argv[]) {
+	BatchRunner batch;
+	std::vector<const char *> files; /* In the order they were added, as the results are */
+	int threads = 0; /* One per core */
+
+	for (int arg = 2; arg < argc; ++arg) {
+		bool option = strcmp(argv[arg], "-j") == 0 || strcmp(argv[arg], "-n") == 0;
+		if (option && arg + 1 >= argc) {
+			printf("Error. %s needs a value.\n", argv[arg]);
+			return 0;
+		}
+		if (strcmp(argv[arg], "-j") == 0)
+			threads = atoi(argv[++arg]);
+		else if (strcmp(argv[arg], "-n") == 0)
+			batch.maxSteps = strtoull(argv[++arg], NULL, 0);
+		else {
+			batch.addFile(argv[arg]);
+			files.push_back(argv[arg]);
+		}
+	}
+
+	std::vector<BatchRunner::Result> results = batch.run(threads);
+	for (int index = 0; index < (int) results.size(); ++index)
+		printResult(files[index], results[index]);
+
+	return 1;
+}
+
+/* Sweep mode: main --sweep file inputs [-n maxSteps]. Runs the program once per line of the inputs file on the lockstep engine */
+static int runSweep(int argc, const char * argv[]) {
+	if (argc < 4) {
+		printf("Usage: %s --sweep file inputs [-n maxSteps]\n", argv[0]);
+		return 0;
+	}
+	unsigned long long maxSteps = 1000000;
+	if (argc > 5 && strcmp(argv[4], "-n") == 0) maxSteps = strtoull(argv[5], NULL, 0);
+
+	/* The program is loaded once, its memory is the image every machine starts from */
+	static ByteSyzed program; /* Static, it is a few kilobytes */
+	program.loadVerbose = false;
+	if (!program.loadFromFile(argv[2])) {
+		program.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+
+	FILE * file = fopen(argv[3], "r");
+	if (file == NULL) {
+		printf("Can't open %s.\n", argv[3]);
+		return 0;
+	}
+	std::vector<std::string> inputs;
+	char inLine[1024];
+	while (fgets(inLine, sizeof(inLine), file) != NULL)
+		inputs.push_back(inLine);
+	fclose(file);
+
+	std::vector<BatchRunner::Result> results = Lockstep<64>::sweep(program.mem, ByteSyzed::n_mem, inputs, maxSteps);
+	for (int index = 0; index < (int) results.size(); ++index) {
+		char name[32];
+		snprintf(name, sizeof(name), "input %i", index + 1);
+		printResult(name, results[index]);
+	}
+
+	return 1;
+}
+
+/* Profile mode: main --profile file [report.csv]. Runs the program counting every instruction, then prints the tables and saves them as CSV (profile.csv by default) */
+static int runProfile(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s --profile file [report.csv]\n", argv[0]);
+		return 0;
+	}
+	const char * reportFileName = (argc > 3)? argv[3] : "profile.csv";
+
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static ByteSyzed::Profile profile;
+	profile.clear();
+	cpu.profile = &profile;
+	cpu.verbose = false;
+	if (!cpu.loadFromFile(argv[2])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+
+	cpu.run<ByteSyzed::Profiled>();
+	cpu.output->print("\n");
+	profile.report(*cpu.output, cpu.mem);
+	cpu.output->flush();
+
+	if (!profile.save(reportFileName)) {
+		printf("Can't open %s. Unable to save the profile.\n", reportFileName);
+		return 0;
+	}
+	return 1;
+}
+
+/* Wide mode: main --wide file. Runs the program on the 16 bit machine (64 KiB, 2 byte addresses) */
+static int runWide(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s --wide file\n", argv[0]);
+		return 0;
+	}
+
+	ByteSyzed16 * cpu = new ByteSyzed16(); /* Too big for the stack, zeroed like lawlor below */
+	cpu->verbose = false;
+	if (!cpu->loadFromFile(argv[2])) {
+		cpu->output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		delete cpu;
+		return 0;
+	}
+
+	cpu->run<ByteSyzed16::Silent>();
+	delete cpu;
+	return 1;
+}
+
+/* Analyze mode: main --analyze file. Prints the program's blocks, what looks wrong with it and how deep its stack gets, without running it */
+static int runAnalyze(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s --analyze file\n", argv[0]);
+		return 0;
+	}
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static Analyzer analyzer;
+	if (!cpu.loadFromFile(argv[2])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+
+	analyzer.analyze(cpu);
+	analyzer.report(*cpu.output);
+	cpu.output->flush();
+	return 1;
+}
+
+/* Record mode: main --record file journal [-c interval]. Runs the program as usual, recording what getchar reads and a checkpoint every interval instructions */
+static int runRecord(int argc, const char * argv[]) {
+	if (argc < 4) {
+		printf("Usage: %s --record file journal [-c interval]\n", argv[0]);
+		return 0;
+	}
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static Journal journal;
+	if (argc > 5 && strcmp(argv[4], "-c") == 0) journal.interval = strtoull(argv[5], NULL, 0);
+	if (journal.interval == 0) journal.interval = 1;
+	cpu.verbose = false;
+	if (!cpu.loadFromFile(argv[2])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+
+	cpu.boot();
+	journal.record(cpu);
+	cpu.output->flush();
+
+	if (!journal.save(argv[3])) {
+		printf("Can't open %s. Unable to save the journal.\n", argv[3]);
+		return 0;
+	}
+	return 1;
+}
+
+/* Replay mode: main --replay journal [step]. With no step, replays the whole run and prints its output again. With one, goes straight to that step and dumps the registers and memory there */
+static int runReplay(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s --replay journal [step]\n", argv[0]);
+		return 0;
+	}
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static Journal journal;
+	static QueueInput replay;
+	cpu.verbose = false;
+	cpu.prompt = true; /* As the recorded run did, though the numbers come from the journal */
+	if (!journal.load(argv[2])) {
+		standardOutput.flush(); /* Its messages first */
+		return 0;
+	}
+
+	if (argc < 4) {
+		/* The whole run from the first checkpoint, so everything it printed is printed again */
+		if (journal.checkpoints.empty()) return 0;
+		journal.seek(cpu, replay, journal.checkpoints.front().steps);
+		cpu.step(journal.steps - cpu.steps);
+		cpu.output->flush();
+		return 1;
+	}
+
+	unsigned long long step = strtoull(argv[3], NULL, 0);
+	MemoryOutput skipped; /* Output before the step was already seen */
+	cpu.output = &skipped;
+	cpu.dumpFileName = NULL; /* Only the dump below */
+	if (!journal.seek(cpu, replay, step)) {
+		printf("The journal starts after step %llu.\n", step);
+		return 0;
+	}
+	cpu.output = &standardOutput;
+	if (cpu.status == ByteSyzed::outOfSteps)
+		cpu.output->print("At step %llu, next instruction at 0x%02X\n", cpu.steps, cpu.regs[0xF]);
+	else
+		cpu.output->print("Stopped at step %llu, before step %llu\n", cpu.steps, step);
+	cpu.dump(0xFD);
+	cpu.output->flush();
+	return 1;
+}
+
+/* Trace mode: main --trace file trace.bst. Runs the program as usual, recording every instruction to a binary trace a background thread writes */
+static int runTrace(int argc, const char * argv[]) {
+	if (argc < 4) {
+		printf("Usage: %s --trace file trace.bst\n", argv[0]);
+		return 0;
+	}
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static TraceFile trace;
+	cpu.verbose = false;
+	if (!cpu.loadFromFile(argv[2])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+	if (!trace.open(argv[3])) {
+		standardOutput.flush(); /* Its messages first */
+		return 0;
+	}
+
+	cpu.trace = &trace;
+	cpu.run<ByteSyzed::Recorded>();
+	cpu.output->flush();
+	if (!trace.close()) {
+		printf("Error. Unable to write all of %s.\n", argv[3]);
+		return 0;
+	}
+	return 1;
+}
+
+/* Reads "first:last" (either may be left out) into a range */
+template <class Number>
+static void parseRange(const char * text, Number & first, Number & last) {
+	const char * colon = strchr(text, ':');
+	if (colon != text) first = (Number) strtoull(text, NULL, 0);
+	if (colon == NULL) last = first;
+	else if (colon[1] != '\0') last = (Number) strtoull(colon + 1, NULL, 0);
+}
+
+/*
+*	Watch mode: main --watch file [-r first:last] [-w first:last] [-x first:last] [-h] [-s] [-o report.csv].
+*	Runs the program with watchpoints on reads, writes or executes of the
+*	ranges given (writes to the program's own bytes if none are), then
+*	prints the events, the stack against the program and, with -h, the
+*	heatmap, and saves them as CSV (watch.csv by default). -s stops at the
+*	first event.
+*/
+static int runWatch(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s --watch file [-r first:last] [-w first:last] [-x first:last] [-h] [-s] [-o report.csv]\n", argv[0]);
+		return 0;
+	}
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static ByteSyzed::Watch watch;
+	const char * reportFileName = "watch.csv";
+	cpu.verbose = false;
+	if (!cpu.loadFromFile(argv[2])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+	const int programFirst = cpu.loadedFirst, programLast = cpu.loadedFirst + cpu.loadedCount - 1; /* Where the image loaded, which need not be its entry point */
+
+	bool points = false;
+	for (int arg = 3; arg < argc; ++arg) {
+		int kinds = 0;
+		if (strcmp(argv[arg], "-r") == 0) kinds = ByteSyzed::Watch::read;
+		else if (strcmp(argv[arg], "-w") == 0) kinds = ByteSyzed::Watch::write;
+		else if (strcmp(argv[arg], "-x") == 0) kinds = ByteSyzed::Watch::execute;
+		else if (strcmp(argv[arg], "-h") == 0) watch.heatmap(true);
+		else if (strcmp(argv[arg], "-s") == 0) watch.stop = true;
+		else if (strcmp(argv[arg], "-o") == 0 && arg + 1 < argc) reportFileName = argv[++arg];
+		if (kinds != 0 && arg + 1 < argc) {
+			int first = 0, last = ByteSyzed::n_mem - 1;
+			parseRange(argv[++arg], first, last);
+			watch.watch(first, last, kinds);
+			points = true;
+		}
+	}
+	if (!points && programLast >= programFirst) watch.watch(programFirst, programLast, ByteSyzed::Watch::write); /* The stack or a stray store running over the code */
+
+	cpu.watch = &watch;
+	cpu.run<ByteSyzed::Watched>();
+	if (cpu.status == ByteSyzed::watchHit) cpu.output->print("\n==== stopped at [0x%02X] after %llu instructions ====\n", cpu.regs[0xF], cpu.steps);
+	cpu.output->print("\n");
+	watch.report(*cpu.output, programFirst, programLast);
+	cpu.output->flush();
+
+	if (!watch.save(reportFileName, programFirst, programLast)) {
+		printf("Can't open %s. Unable to save the report.\n", reportFileName);
+		return 0;
+	}
+	return 1;
+}
+
+/* Decode mode: main --decode trace.bst [-s first:last] [-a first:last] [-o opcode]. Prints a trace as verbose mode would have, or only the steps, addresses or opcode asked for */
+static int runDecode(int argc, const char * argv[]) {
+	if (argc < 3) {
+		printf("Usage: %s --decode trace.bst [-s first:last] [-a first:last] [-o opcode]\n", argv[0]);
+		return 0;
+	}
+	TraceDecoder decoder;
+	for (int arg = 3; arg + 1 < argc; arg += 2) {
+		if (strcmp(argv[arg], "-s") == 0) parseRange(argv[arg + 1], decoder.firstStep, decoder.lastStep);
+		else if (strcmp(argv[arg], "-a") == 0) parseRange(argv[arg + 1], decoder.firstAddress, decoder.lastAddress);
+		else if (strcmp(argv[arg], "-o") == 0) decoder.opcode = (int) strtol(argv[arg + 1], NULL, 0);
+	}
+
+	bool decoded = decoder.decodeFile(argv[2], standardOutput);
+	standardOutput.flush();
+	return decoded;
+}
+
+/* Cores mode: main --cores n file [-n maxSteps]. Runs the program on n cores sharing one memory, core 0 starting at progStart and spawn starting the others */
+static int runCores(int argc, const char * argv[]) {
+	if (argc < 4) {
+		printf("Usage: %s --cores n file [-n maxSteps]\n", argv[0]);
+		return 0;
+	}
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static MultiCore cores;
+	if (!cpu.loadFromFile(argv[3])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+	cores.coreCount = atoi(argv[2]);
+	if (argc > 5 && strcmp(argv[4], "-n") == 0) cores.stepLimit = strtoull(argv[5], NULL, 0);
+
+	cores.load(cpu);
+	cores.run();
+	if (cores.status == ByteSyzed::exited)
+		printf("==== exit 0x%02X after %llu instructions on %i cores ====\n", cores.cores[0].regs[0x0], cores.totalSteps(), cores.coreCount);
+	else
+		printf("==== core %i stopped (status %i) after %llu instructions on %i cores ====\n", cores.stoppedBy, cores.status, cores.totalSteps(), cores.coreCount);
+	return cores.status == ByteSyzed::exited;
+}
 
 int main(int argc, const char * argv[]) {
+	if (argc > 1 && strcmp(argv[1], "--batch") == 0) return runBatch(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--sweep") == 0) return runSweep(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--profile") == 0) return runProfile(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--wide") == 0) return runWide(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--analyze") == 0) return runAnalyze(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--record") == 0) return runRecord(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--replay") == 0) return runReplay(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--trace") == 0) return runTrace(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--decode") == 0) return runDecode(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--cores") == 0) return runCores(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--watch") == 0) return runWatch(argc, argv);
+
 	ByteSyzed lawlor = {0};
 
 	lawlor.progStart = 0x00; /* Sets where to load program */
@@ -33,12 +414,16 @@ int main(int argc, const char * argv[]) {
 
 	/* Load from file */
 	if(!lawlor.loadFromFile(inputFileName)) {
+		lawlor.output->flush(); /* Its messages first */
 		printf("Error. Failed to load from file.\n");
 		return 0;
 	}
 
-	/* Run the ByteSyzed CPU */
-	lawlor.run();
+	/* Run the ByteSyzed CPU. Picking the policy here keeps silent runs free of tracing */
+	if (lawlor.verbose)
+		lawlor.run<ByteSyzed::Verbose>();
+	else
+		lawlor.run<ByteSyzed::Silent>();
 
 	/* Zeroes memory */
 	lawlor.wipeMemory();
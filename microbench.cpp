@@ -0,0 +1,288 @@
+/*	microbench.cpp
+*
+*	ByteSyzed microbenchmarks.
+*
+*	Times small kernels, each one kind of work a program does (arithmetic
+*	loops, call and ret recursion, memory to memory copies, stack churn,
+*	printstr output), plus loading a program from a file, wiping a
+*	machine, and setting up a short run from scratch or from a pool.
+*	Every benchmark runs once to warm up, then a number of repetitions,
+*	each a batch of runs long enough to time well. It prints the median
+*	time per instruction (or per load or wipe) with the spread over
+*	repetitions and runs per second, so two builds can be compared.
+*
+*	Usage: microbench [-e switch|threaded|blocks] [-r repetitions] [-t msPerRepetition] [names...]
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Assembler.h"
+#include "MachinePool.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* Kernels, each exits with 0 after a few hundred thousand instructions */
+struct Kernel {
+	const char * name;
+	const char * source;
+};
+static const Kernel kernels[] = {
+	{"arith", /* Nested loop of register arithmetic, 200 * 200 iterations */
+		"	mov r2, r3, 0\n"
+		"	mov r4, 200\n"
+		"	mov r7, 3\n"
+		"outer:\n"
+		"	mov r3, 0\n"
+		"inner:\n"
+		"	inc r3, 1\n"
+		"	add r5, r3\n"
+		"	xor r6, r5\n"
+		"	shl r6, r7\n"
+		"	sub r5, r6, 7\n"
+		"	jne r3, r4, inner\n"
+		"	inc r2, 1\n"
+		"	jne r2, r4, outer\n"
+		"	mov r0, 0\n"
+		"	exit\n"},
+	{"recursion", /* 250 times, a function that calls itself 100 deep */
+		"	mov r0, r4, 0\n"
+		"	mov r5, 250\n"
+		"again:\n"
+		"	mov r1, 100\n"
+		"	call down\n"
+		"	inc r4, 1\n"
+		"	jne r4, r5, again\n"
+		"	exit\n"
+		"down:\n"
+		"	je r1, r0, bottom\n"
+		"	dec r1, 1\n"
+		"	call down\n"
+		"bottom:\n"
+		"	ret\n"},
+	{"memcopy", /* 64 bytes copied with 0x13, 1000 times */
+		"	mov r0, r6, 0\n"
+		"	mov r7, 250\n"
+		"	mov r8, 4\n"
+		"again:\n"
+		"	mov r2, destination\n"
+		"	mov r3, source\n"
+		"	mov r4, source + 64\n"
+		"copy:\n"
+		"	mov [r2], [r3]\n"
+		"	inc r2, 1\n"
+		"	inc r3, 1\n"
+		"	jne r3, r4, copy\n"
+		"	inc r6, 1\n"
+		"	jne r6, r7, again\n"
+		"	mov r6, 0\n"
+		"	dec r8, 1\n"
+		"	jne r8, r0, again\n"
+		"	exit\n"
+		"	.org 0x40\n"
+		"source:\n"
+		"	.ascii \"The quick brown fox jumps over the lazy dog, then naps. 0123456\"\n"
+		"destination:\n"},
+	{"stack", /* Eight pushes and pops, 200 * 50 times */
+		"	mov r0, r2, 0\n"
+		"	mov r3, 0\n"
+		"	mov r4, 200\n"
+		"	mov r5, 50\n"
+		"loop:\n"
+		"	push r1\n	push r2\n	push r3\n	push r4\n	push r5\n	push r6\n	push r7\n	push r8\n"
+		"	pop r8\n	pop r7\n	pop r6\n	pop r5\n	pop r4\n	pop r3\n	pop r2\n	pop r1\n"
+		"	inc r2, 1\n"
+		"	jne r2, r4, loop\n"
+		"	mov r2, 0\n"
+		"	inc r3, 1\n"
+		"	jne r3, r5, loop\n"
+		"	exit\n"},
+	{"printstr", /* A 44 character line, 200 * 20 times */
+		"	mov r0, r2, 0\n"
+		"	mov r3, 0\n"
+		"	mov r4, 200\n"
+		"	mov r5, 20\n"
+		"loop:\n"
+		"	printstr \"The quick brown fox jumps over the lazy dog\\n\"\n"
+		"	inc r2, 1\n"
+		"	jne r2, r4, loop\n"
+		"	mov r2, 0\n"
+		"	inc r3, 1\n"
+		"	jne r3, r5, loop\n"
+		"	exit\n"},
+};
+
+/* Output that is counted and thrown away, so printing costs what the emulator spends on it and no more */
+class DiscardOutput : public EmulatorOutput {
+public:
+	unsigned long long discarded = 0; /* Bytes thrown away */
+
+protected:
+	void drain(const char * /* bytes */, size_t count) { discarded += count; }
+};
+
+/* Timing of one benchmark over its repetitions */
+struct Timing {
+	std::vector<double> perUnit; /* Nanoseconds per instruction (or load, or wipe), one per repetition */
+	std::vector<double> perRun; /* Nanoseconds per run */
+};
+
+static int repetitions = 10;
+static double secondsPerRepetition = 0.05;
+
+/* Calls once() in batches, growing the batch until it takes secondsPerRepetition, then times repetitions batches. once() returns the units (instructions) of a run */
+template <class Once>
+static Timing measure(Once once) {
+	typedef std::chrono::steady_clock Clock;
+	Timing timing;
+	long batch = 1;
+	for (;;) { /* Warm up, and size the batch */
+		auto begin = Clock::now();
+		for (long run = 0; run < batch; ++run) once();
+		double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+		if (seconds >= secondsPerRepetition / 2 || batch >= (1L << 30)) break;
+		batch = (seconds <= 0)? batch * 16 : (long)(batch * secondsPerRepetition / seconds) + 1;
+	}
+	for (int repetition = 0; repetition < repetitions; ++repetition) {
+		unsigned long long units = 0;
+		auto begin = Clock::now();
+		for (long run = 0; run < batch; ++run) units += once();
+		double nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+		timing.perUnit.push_back(nanoseconds / units);
+		timing.perRun.push_back(nanoseconds / batch);
+	}
+	return timing;
+}
+
+static double median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return (values.size() % 2 != 0)? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+/* Standard deviation as a percentage of the mean */
+static double spread(const std::vector<double> & values) {
+	double mean = 0, squares = 0;
+	for (double value : values) mean += value;
+	mean /= values.size();
+	for (double value : values) squares += (value - mean) * (value - mean);
+	return (mean > 0)? 100 * sqrt(squares / values.size()) / mean : 0;
+}
+
+static void report(const char * name, unsigned long long unitsPerRun, const char * unit, const Timing & timing) {
+	printf("%-12s %10llu %-6s %10.3f ns/%-5s +-%5.1f%% %10.3f min %12.0f runs/s\n", name, unitsPerRun, unit, median(timing.perUnit), unit,
+		spread(timing.perUnit), *std::min_element(timing.perUnit.begin(), timing.perUnit.end()), 1e9 / median(timing.perRun));
+}
+
+/* Names the user asked for, or all of them */
+static bool wanted(const std::vector<const char *> & names, const char * name) {
+	if (names.empty()) return true;
+	for (const char * each : names)
+		if (strcmp(each, name) == 0) return true;
+	return false;
+}
+
+int main(int argc, const char * argv[]) {
+	static ByteSyzed cpu; /* Static, it is a few kilobytes */
+	static Assembler assembler;
+	static DiscardOutput discard;
+	unsigned char (ByteSyzed::*engine)(void) = &ByteSyzed::runBlocks;
+	const char * engineName = "blocks";
+	std::vector<const char *> names;
+
+	for (int index = 1; index < argc; ++index) {
+		bool value = index + 1 < argc;
+		if (strcmp(argv[index], "-e") == 0 && value) {
+			engineName = argv[++index];
+			if (strcmp(engineName, "switch") == 0) engine = &ByteSyzed::runSwitch<ByteSyzed::Silent>;
+#if BYTESYZED_THREADED
+			else if (strcmp(engineName, "threaded") == 0) engine = &ByteSyzed::runThreaded<ByteSyzed::Silent>;
+#endif
+			else if (strcmp(engineName, "blocks") == 0) engine = &ByteSyzed::runBlocks;
+			else {
+				printf("Error. No engine named %s in this build.\n", engineName);
+				return 0;
+			}
+		}
+		else if (strcmp(argv[index], "-r") == 0 && value) repetitions = std::max(1, atoi(argv[++index]));
+		else if (strcmp(argv[index], "-t") == 0 && value) secondsPerRepetition = atof(argv[++index]) / 1000;
+		else if (argv[index][0] == '-') {
+			printf("Usage: %s [-e switch|threaded|blocks] [-r repetitions] [-t msPerRepetition] [names...]\n", argv[0]);
+			return 0;
+		}
+		else names.push_back(argv[index]);
+	}
+
+	printf("%s engine, %i repetitions of %.0f ms, median time with the spread (standard deviation) over repetitions and the fastest\n",
+		engineName, repetitions, secondsPerRepetition * 1000);
+	cpu.verbose = false;
+	cpu.prompt = false;
+	cpu.output = &discard;
+
+	bool failed = false;
+	for (const Kernel & kernel : kernels) {
+		if (!wanted(names, kernel.name)) continue;
+		if (!assembler.assemble(kernel.source)) return 0; /* The errors are printed */
+		cpu.wipeMemory();
+		assembler.load(cpu);
+
+		/* Runs once to check it, a kernel that does not exit cleanly measures nothing */
+		(cpu.*engine)();
+		if (cpu.status != ByteSyzed::exited || cpu.regs[0x0] != 0) {
+			printf("%-12s did not exit cleanly (status %i)\n", kernel.name, cpu.status);
+			failed = true;
+			continue;
+		}
+		unsigned long long steps = cpu.steps;
+		report(kernel.name, steps, "instr", measure([&]() { (cpu.*engine)(); return cpu.steps; }));
+	}
+
+	/* Loading the arith kernel from a text file and from an image, as a run from the command line starts */
+	if (wanted(names, "load")) {
+		assembler.assemble(kernels[0].source);
+		const char * textName = "microbench-load.txt", * imageName = "microbench-load.bsz";
+		if (assembler.saveText(textName, &discard) && assembler.saveImage(imageName, &discard)) {
+			report("load text", 1, "load", measure([&]() { cpu.loadFromFile(textName); return 1; }));
+			report("load image", 1, "load", measure([&]() { cpu.loadFromFile(imageName); return 1; }));
+		}
+		else {
+			printf("load         unable to write %s and %s here\n", textName, imageName);
+			failed = true;
+		}
+		remove(textName);
+		remove(imageName);
+	}
+
+	/* Resetting a machine between runs */
+	if (wanted(names, "wipe")) {
+		report("wipe", 1, "wipe", measure([&]() { cpu.wipeMemory(); return 1; }));
+		ByteSyzed16 * wide = new ByteSyzed16; /* About 5 MB */
+		report("wipe16", 1, "wipe", measure([&]() { wide->wipeMemory(); return 1; }));
+		delete wide;
+	}
+
+	/* A dozen instructions, set up with a wipe and a load every time, or handed out by a pool that only resets what the run wrote */
+	if (wanted(names, "pool")) {
+		static const unsigned char image[] = {0x02, 0x00, 0x15, 0x21, 0x15, 0x21, 0x15, 0x21, 0x15, 0x21, 0x82, 0x15, 0x21, 0x92, 0x00, 0x00, 0xEE};
+		MachinePool pool;
+		MachinePool16 pool16;
+		pool.loadImage(image, sizeof(image));
+		pool16.loadImage(image, sizeof(image));
+		ByteSyzed16 * wide = new ByteSyzed16;
+		wide->verbose = false;
+		wide->output = &discard;
+
+		report("fresh", 1, "run", measure([&]() { cpu.wipeMemory(); cpu.progStart = 0; cpu.loadFromMemory(image, sizeof(image)); cpu.run(~0ULL); return 1; }));
+		report("pooled", 1, "run", measure([&]() { ByteSyzed * each = pool.acquire(); each->step(~0ULL); pool.release(each); return 1; }));
+		report("fresh16", 1, "run", measure([&]() { wide->wipeMemory(); wide->progStart = 0; wide->loadFromMemory(image, sizeof(image)); wide->run(~0ULL); return 1; }));
+		report("pooled16", 1, "run", measure([&]() { ByteSyzed16 * each = pool16.acquire(); each->step(~0ULL); pool16.release(each); return 1; }));
+		delete wide;
+	}
+
+	return !failed;
+}
\ No newline at end of file
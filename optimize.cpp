@@ -0,0 +1,60 @@
+/*	optimize.cpp
+*
+*	ByteSyzed peephole optimizer.
+*
+*	Loads a program, rewrites it into a shorter one that does the same (see
+*	Optimizer.h), runs both on the same input to check they agree, and saves
+*	the result as a binary image (see ByteSyzed::saveImage). A program the
+*	optimizer can't prove safe to rewrite is not saved.
+*
+*	Usage: optimize input output.bsz [-i "numbers"] [-n maxSteps]
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, const char * argv[]) {
+	static ByteSyzed cpu, rewritten; /* Static, they are a few kilobytes */
+	static Optimizer optimizer;
+	const char * input = ""; /* Numbers getchar reads while verifying */
+	unsigned long long maxSteps = 10000000;
+
+	if (argc < 3) {
+		printf("Usage: %s input output.bsz [-i \"numbers\"] [-n maxSteps]\n", argv[0]);
+		return 0;
+	}
+	for (int index = 3; index + 1 < argc; index += 2) {
+		if (strcmp(argv[index], "-i") == 0) input = argv[index + 1];
+		else if (strcmp(argv[index], "-n") == 0) maxSteps = strtoull(argv[index + 1], NULL, 0);
+	}
+
+	if (!cpu.loadFromFile(argv[1])) {
+		cpu.output->flush(); /* Its messages first */
+		printf("Error. Failed to load from file.\n");
+		return 0;
+	}
+
+	if (!optimizer.optimize(cpu) || !optimizer.verify(cpu.mem, input, maxSteps)) {
+		standardOutput.flush();
+		printf("Error. Not saved.\n");
+		return 0;
+	}
+	optimizer.report(standardOutput);
+	standardOutput.flush();
+
+	/* The rewritten program starts at its own entry point */
+	memcpy(rewritten.mem + optimizer.first, optimizer.program.data(), optimizer.program.size());
+	rewritten.progStart = optimizer.entry;
+	if (!rewritten.saveImage(argv[2], optimizer.first, (int) optimizer.program.size())) {
+		rewritten.output->flush();
+		printf("Error. Failed to save the image.\n");
+		return 0;
+	}
+
+	printf("Saved %i bytes at 0x%02X to %s\n", (int) optimizer.program.size(), optimizer.first, argv[2]);
+	return 1;
+}
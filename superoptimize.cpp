@@ -0,0 +1,149 @@
+/*	superoptimize.cpp
+*
+*	ByteSyzed superoptimizer.
+*
+*	Searches for the shortest and the fastest programs that print a target
+*	output and exit (see Superoptimizer.h). The target is what a program
+*	prints, which also seeds the search, or text given on the command line.
+*	By default candidates are mutations of the seed; -e enumerates every
+*	sequence of up to that many instructions instead.
+*
+*	Usage: superoptimize (-f program | -t "text") [-i "numbers"] [-x exitCode]
+*		[-n candidates | -e instructions] [-b maxBytes] [-m maxSteps]
+*		[-r registers] [-o "opcodes"] [-j threads] [-s seed]
+*		[-w shortest.txt] [-W fastest.txt]
+*	-t takes C escapes: \n, \t, \\ and \xHH.
+*
+*	Created: 10/17/2026
+*	Last Edited: 10/17/2026
+*/
+
+#include "Superoptimizer.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Text with its escapes turned into bytes */
+static std::string unescape(const char * text) {
+	std::string bytes;
+	for (; *text != '\0'; ++text) {
+		if (*text != '\\' || text[1] == '\0') {
+			bytes += *text;
+			continue;
+		}
+		switch (*++text) {
+			case 'n': bytes += '\n'; break;
+			case 't': bytes += '\t'; break;
+			case 'x': {
+				char * end;
+				bytes += (char) strtol(text + 1, &end, 16);
+				text = end - 1;
+				break;
+			}
+			default: bytes += *text;
+		}
+	}
+	return bytes;
+}
+
+/* Every number in text, whitespace separated. False if some of it is not a number */
+static bool parseBytes(const char * text, std::vector<unsigned char> & bytes) {
+	bytes.clear();
+	for (char * end; *text != '\0'; text = end) {
+		while (isspace((unsigned char) *text)) ++text;
+		if (*text == '\0') break;
+		const long value = strtol(text, &end, 0);
+		if (end == text) return false; /* Not a number */
+		bytes.push_back((unsigned char) value);
+	}
+	return true;
+}
+
+int main(int argc, const char * argv[]) {
+	static Superoptimizer optimizer; /* Static, its workers are a few kilobytes each */
+	const char * programFileName = NULL, * text = NULL, * shortestFileName = NULL, * fastestFileName = NULL;
+	unsigned long long count = 10000000;
+	int instructions = 0, threads = 0;
+	unsigned int seed = 1;
+
+	for (int index = 1; index + 1 < argc; index += 2) {
+		const char * option = argv[index], * value = argv[index + 1];
+		if (strcmp(option, "-f") == 0) programFileName = value;
+		else if (strcmp(option, "-t") == 0) text = value;
+		else if (strcmp(option, "-i") == 0) optimizer.target.input = value;
+		else if (strcmp(option, "-x") == 0) optimizer.target.exitCode = (int) strtol(value, NULL, 0) & 0xFF;
+		else if (strcmp(option, "-n") == 0) count = strtoull(value, NULL, 0);
+		else if (strcmp(option, "-e") == 0) instructions = (int) strtol(value, NULL, 0);
+		else if (strcmp(option, "-b") == 0) optimizer.maxBytes = (int) strtol(value, NULL, 0);
+		else if (strcmp(option, "-m") == 0) optimizer.maxSteps = strtoull(value, NULL, 0);
+		else if (strcmp(option, "-r") == 0) optimizer.registers = (int) strtol(value, NULL, 0);
+		else if (strcmp(option, "-o") == 0) {
+			if (!parseBytes(value, optimizer.opcodes)) {
+				printf("Error. -o takes numbers, not \"%s\".\n", value);
+				return 0;
+			}
+		}
+		else if (strcmp(option, "-j") == 0) threads = (int) strtol(value, NULL, 0);
+		else if (strcmp(option, "-s") == 0) seed = (unsigned int) strtoul(value, NULL, 0);
+		else if (strcmp(option, "-w") == 0) shortestFileName = value;
+		else if (strcmp(option, "-W") == 0) fastestFileName = value;
+	}
+	if ((programFileName == NULL) == (text == NULL)) {
+		printf("Usage: %s (-f program | -t \"text\") [-i \"numbers\"] [-x exitCode] [-n candidates | -e instructions] [-b maxBytes] [-m maxSteps] [-r registers] [-o \"opcodes\"] [-j threads] [-s seed] [-w shortest.txt] [-W fastest.txt]\n", argv[0]);
+		return 0;
+	}
+
+	/* The target is what the program prints, and the program is where the search starts */
+	std::vector<unsigned char> start;
+	if (programFileName != NULL) {
+		static ByteSyzed cpu; /* Static, it is a few kilobytes */
+		MemoryOutput output;
+		QueueInput input;
+		input.push(optimizer.target.input.c_str());
+		cpu.verbose = false;
+		cpu.prompt = false;
+		cpu.dumpFileName = NULL;
+		if (!cpu.loadFromFile(programFileName)) {
+			cpu.output->flush(); /* Its messages first */
+			printf("Error. Failed to load from file.\n");
+			return 0;
+		}
+		/* The seed is the program as it loaded, before running changes it. Candidates start where they load */
+		optimizer.progStart = cpu.progStart;
+		if (cpu.loadedFirst == cpu.progStart) start.assign(cpu.mem + cpu.loadedFirst, cpu.mem + cpu.loadedFirst + cpu.loadedCount);
+		cpu.output = &output;
+		cpu.input = &input;
+		if (cpu.run(10000000ULL) != ByteSyzed::exited) {
+			printf("Error. %s does not exit within 10000000 instructions.\n", programFileName);
+			return 0;
+		}
+		optimizer.target.output = output.text();
+
+		unsigned long long steps;
+		if (start.empty())
+			printf("%s starts at 0x%02X, past where it loads (0x%02X), the search starts from exit alone\n", programFileName, cpu.progStart, cpu.loadedFirst);
+		else if (optimizer.check(start.data(), (int) start.size(), &steps)) {
+			printf("%s: %i bytes, %llu steps\n", programFileName, (int) start.size(), steps);
+			if ((int) start.size() > optimizer.maxBytes) optimizer.maxBytes = (int) start.size();
+		}
+		else {
+			printf("%s does not do the same from a wiped machine, the search starts from exit alone\n", programFileName);
+			start.clear();
+		}
+	}
+	else optimizer.target.output = unescape(text);
+
+	if (instructions > 0) {
+		printf("Enumerating %llu candidates\n", optimizer.candidates(instructions));
+		fflush(stdout); /* Before the wait */
+		optimizer.enumerate(instructions, threads);
+	}
+	else optimizer.search(count, start, seed, threads);
+
+	optimizer.report(standardOutput);
+	standardOutput.flush();
+
+	if (shortestFileName != NULL && !optimizer.shortest.program.empty() && !optimizer.save(shortestFileName, optimizer.shortest)) printf("Can't open %s. Unable to save the shortest program.\n", shortestFileName);
+	if (fastestFileName != NULL && !optimizer.fastest.program.empty() && !optimizer.save(fastestFileName, optimizer.fastest)) printf("Can't open %s. Unable to save the fastest program.\n", fastestFileName);
+	return 1;
+}
\ No newline at end of file